@@ -0,0 +1,92 @@
+/* Example bot plugin, heads for the apple or the nearest item and avoids cells without a way out.
+ * Build it with the game, then let it play player one:
+ *   ./Bens-Snake-Game --bot 1:./libExampleBot.so
+ */
+
+#include "BotPluginApi.h"
+#include <stdlib.h>
+
+static int32_t const STEPS[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+
+static int IsFree(SnakeBotView const * const view, int32_t const x, int32_t const y)
+{
+  return (x >= 0) && (x < view->width) && (y >= 0) && (y < view->height) && (view->field[y * view->width + x] == 0U);
+}
+
+
+static int FreeNeighbours(SnakeBotView const * const view, int32_t const x, int32_t const y)
+{
+  int count = 0;
+  for (int step = 0; step < 4; ++step)
+  {
+    count += IsFree(view, x + STEPS[step][0], y + STEPS[step][1]);
+  }
+  return count;
+}
+
+
+uint32_t snake_bot_abi_version(void)
+{
+  return SNAKE_BOT_ABI_VERSION;
+}
+
+
+void* snake_bot_create(uint32_t player)
+{
+  (void)player;
+  return NULL;
+}
+
+
+int32_t snake_bot_decide(void* context, SnakeBotView const * view, uint32_t player)
+{
+  (void)context;
+  SnakeBotSnake const * const snake = &view->snakes[player];
+  SnakeBotPosition const head = snake->ring[snake->head];
+
+  /* The apple, or in arenas without one the nearest item */
+  SnakeBotPosition target = view->apple;
+  if (!view->hasApple)
+  {
+    int32_t bestDistance = -1;
+    target = head;
+    for (uint32_t i = 0U; i < view->numberOfItems; ++i)
+    {
+      SnakeBotPosition const item = { view->items[i].cell % view->width, view->items[i].cell / view->width };
+      int32_t const distance = abs(item.x - head.x) + abs(item.y - head.y);
+      if ((view->items[i].type != SNAKE_BOT_ITEM_SCISSORS) && ((bestDistance < 0) || (distance < bestDistance)))
+      {
+        bestDistance = distance;
+        target = item;
+      }
+    }
+  }
+
+  int32_t best = -1;
+  int32_t bestScore = -1;
+  for (int32_t direction = SNAKE_BOT_UP; direction <= SNAKE_BOT_RIGHT; ++direction)
+  {
+    int32_t const x = head.x + STEPS[direction][0];
+    int32_t const y = head.y + STEPS[direction][1];
+    if (((uint32_t)direction ^ 1U) == snake->direction || !IsFree(view, x, y))
+    {
+      continue;
+    }
+
+    /* Cells without a way out are taken last, among the others the closest to the target wins */
+    int32_t const distance = abs(target.x - x) + abs(target.y - y);
+    int32_t const score = ((FreeNeighbours(view, x, y) > 0) ? 1 << 20 : 0) + (view->width + view->height - distance);
+    if (score > bestScore)
+    {
+      bestScore = score;
+      best = direction;
+    }
+  }
+  return best;
+}
+
+
+void snake_bot_destroy(void* context)
+{
+  (void)context;
+}
@@ -0,0 +1,126 @@
+#include "AllocationCounter.hpp"
+
+#ifdef COUNT_ALLOCATIONS
+#include <SDL_stdinc.h>
+#include <cstdlib>
+#include <new>
+
+static thread_local uint64_t threadAllocations = 0UL;
+
+// SDL's own functions, the counting ones only forward to them
+static SDL_malloc_func pSdlMalloc = nullptr;
+static SDL_calloc_func pSdlCalloc = nullptr;
+static SDL_realloc_func pSdlRealloc = nullptr;
+static SDL_free_func pSdlFree = nullptr;
+
+void* operator new(size_t size)
+{
+  ++threadAllocations;
+  void* const pMemory = std::malloc((size > 0UL) ? size : 1UL);
+  if (pMemory == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return pMemory;
+}
+
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+
+void* operator new(size_t size, std::nothrow_t const &) noexcept
+{
+  ++threadAllocations;
+  return std::malloc((size > 0UL) ? size : 1UL);
+}
+
+
+void* operator new[](size_t size, std::nothrow_t const & nothrow) noexcept
+{
+  return operator new(size, nothrow);
+}
+
+
+void operator delete(void* pMemory) noexcept
+{
+  std::free(pMemory);
+}
+
+
+void operator delete[](void* pMemory) noexcept
+{
+  std::free(pMemory);
+}
+
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+  std::free(pMemory);
+}
+
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+  std::free(pMemory);
+}
+
+
+static void* SDLCALL CountedMalloc(size_t size)
+{
+  ++threadAllocations;
+  return pSdlMalloc(size);
+}
+
+
+static void* SDLCALL CountedCalloc(size_t number, size_t size)
+{
+  ++threadAllocations;
+  return pSdlCalloc(number, size);
+}
+
+
+static void* SDLCALL CountedRealloc(void* pMemory, size_t size)
+{
+  // Growing in place is not free either
+  ++threadAllocations;
+  return pSdlRealloc(pMemory, size);
+}
+
+
+uint64_t GetThreadAllocations(void)
+{
+  return threadAllocations;
+}
+
+
+void CountSdlAllocations(void)
+{
+  SDL_GetMemoryFunctions(&pSdlMalloc, &pSdlCalloc, &pSdlRealloc, &pSdlFree);
+  (void)SDL_SetMemoryFunctions(CountedMalloc, CountedCalloc, CountedRealloc, pSdlFree);
+}
+
+
+bool IsCountingAllocations(void)
+{
+  return true;
+}
+#else
+uint64_t GetThreadAllocations(void)
+{
+  return 0UL;
+}
+
+
+void CountSdlAllocations(void)
+{
+}
+
+
+bool IsCountingAllocations(void)
+{
+  return false;
+}
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations by operator new and by SDL's allocator of the calling thread, always 0 unless built with COUNT_ALLOCATIONS
+uint64_t GetThreadAllocations(void);
+// SDL_image, SDL_ttf and SDL_mixer allocate through SDL as well, has to be called before SDL allocates anything
+void CountSdlAllocations(void);
+bool IsCountingAllocations(void);
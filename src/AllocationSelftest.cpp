@@ -0,0 +1,68 @@
+#include "AllocationSelftest.hpp"
+#include <iostream>
+
+AllocationSelftest::AllocationSelftest(uint64_t const frames, std::vector<char const *> const & phaseNames)
+: frames(frames)
+, totalFrames(0UL)
+, phases()
+{
+  for (char const * const pName : phaseNames)
+  {
+    phases.push_back({ pName, 0UL, 0UL, 0UL, 0UL });
+  }
+}
+
+
+void AllocationSelftest::AddFrame(size_t const phase, uint64_t const allocations, bool const steady)
+{
+  Phase & current = phases[phase];
+  ++current.frames;
+  ++totalFrames;
+  if (!steady || (current.frames <= WARM_UP_FRAMES))
+  {
+    return;
+  }
+
+  ++current.checkedFrames;
+  if (allocations > 0UL)
+  {
+    ++current.allocatingFrames;
+    current.allocations += allocations;
+    if (current.allocatingFrames <= MAX_REPORTED_FRAMES)
+    {
+      std::cout << current.pName << " frame " << current.frames << ": " << allocations << " heap allocations\n";
+    }
+  }
+}
+
+
+bool AllocationSelftest::IsChecked(size_t const phase) const
+{
+  Phase const & current = phases[phase];
+  return (current.checkedFrames >= frames) || (current.frames >= (WARM_UP_FRAMES + frames) * MAX_FRAMES_FACTOR);
+}
+
+
+bool AllocationSelftest::IsFinished(void) const
+{
+  bool checked = true;
+  for (size_t phase = 0UL; phase < phases.size(); ++phase)
+  {
+    checked = checked && IsChecked(phase);
+  }
+  return checked || (totalFrames >= (WARM_UP_FRAMES + frames) * MAX_FRAMES_FACTOR * phases.size());
+}
+
+
+bool AllocationSelftest::Passed(void) const
+{
+  bool passed = true;
+  for (Phase const & phase : phases)
+  {
+    std::cout << phase.pName << ": " << phase.frames << " frames, " << phase.checkedFrames << " checked, "
+              << phase.allocatingFrames << " allocated " << phase.allocations << " times\n";
+    passed = passed && (phase.checkedFrames >= frames) && (phase.allocatingFrames == 0UL);
+  }
+  std::cout << "Allocation selftest " << (passed ? "passed" : "FAILED") << "\n";
+  return passed;
+}
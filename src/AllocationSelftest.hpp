@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Counts the heap allocations of a scripted game frame by frame, frames of every phase after its warm up must not allocate
+class AllocationSelftest
+{
+public:
+  AllocationSelftest(uint64_t const frames, std::vector<char const *> const & phaseNames);
+
+  // Frames which change the phase or rasterize a changed text may allocate, they are not checked
+  void AddFrame(size_t const phase, uint64_t const allocations, bool const steady);
+  // The script stays in a menu until it has been checked for enough frames
+  bool IsChecked(size_t const phase) const;
+  bool IsFinished(void) const;
+  bool Passed(void) const;
+
+private:
+  // Pictures, fonts and sounds are loaded during the first frames a phase is shown
+  static uint64_t constexpr WARM_UP_FRAMES = 120UL;
+  static uint64_t constexpr MAX_REPORTED_FRAMES = 10UL;
+  // Phases which are rarely steady or never reached give up after this many frames per checked frame
+  static uint64_t constexpr MAX_FRAMES_FACTOR = 20UL;
+
+  struct Phase
+  {
+    char const * pName;
+    uint64_t frames;
+    uint64_t checkedFrames;
+    uint64_t allocatingFrames;
+    uint64_t allocations;
+  };
+
+  uint64_t frames;
+  uint64_t totalFrames;
+  std::vector<Phase> phases;
+};
@@ -0,0 +1,300 @@
+#include "Analytics.hpp"
+#include "BoardAnalysis.hpp"
+#include "Bot.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include <SDL_image.h>
+#include <SDL_surface.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static char constexpr HEATMAP_MAGIC[4] = { 'S', 'N', 'K', 'H' };
+static uint32_t constexpr HEATMAP_VERSION = 1U;
+static int constexpr PIXELS_PER_CELL = 8;
+static int constexpr PANEL_GAP = 2;
+// Game lengths in buckets of this many ticks, the last bucket takes all longer games
+static uint64_t constexpr LENGTH_BUCKET_TICKS = 64UL;
+static size_t constexpr NUMBER_OF_LENGTH_BUCKETS = 64UL;
+
+enum Layer : size_t
+{
+  OCCUPIED,
+  DEATHS,
+  APPLE_SPAWNS,
+  APPLES_EATEN,
+  NUMBER_OF_LAYERS
+};
+
+static char const * const LAYER_NAMES[NUMBER_OF_LAYERS] = { "occupied ticks", "deaths", "apple spawns", "apples eaten" };
+
+// Counts of one worker, summed up with the others once all games are played
+struct Accumulator
+{
+  std::array<std::vector<uint64_t>, NUMBER_OF_LAYERS> layers;
+  std::array<uint64_t, NUMBER_OF_LENGTH_BUCKETS> gameLengths;
+  uint64_t games;
+  uint64_t ticks;
+  uint64_t stalledGames;
+};
+
+static void PlayGames(Options const & options, uint64_t const firstGame, uint64_t const endGame, Accumulator & accumulator)
+{
+  Position const size = options.boardSize;
+  size_t const cells = static_cast<size_t>(size.x) * size.y;
+  size_t const numberOfPlayers = std::max(options.arenaPlayers, 1U);
+  // Bots circling without eating are stopped after they could have visited every cell, like in training
+  uint64_t const maxTicksSinceApple = cells;
+  for (std::vector<uint64_t> & layer : accumulator.layers)
+  {
+    layer.assign(cells, 0UL);
+  }
+  accumulator.gameLengths.fill(0UL);
+  accumulator.games = 0UL;
+  accumulator.ticks = 0UL;
+  accumulator.stalledGames = 0UL;
+
+  Simulation simulation(size);
+  BoardAnalysis analysis;
+  std::vector<Position> headsBefore(numberOfPlayers);
+  std::vector<uint8_t> aliveBefore(numberOfPlayers, 0U);
+  uint64_t* const pOccupied = accumulator.layers[OCCUPIED].data();
+  auto const cellIndex = [&size](Position const & cell){ return static_cast<size_t>(cell.y) * size.x + cell.x; };
+
+  for (uint64_t game = firstGame; game < endGame; ++game)
+  {
+    // Seeded by the game number, so the result does not depend on the number of workers
+    simulation.Restart(numberOfPlayers, game + 1UL);
+    if (simulation.HasApple())
+    {
+      ++accumulator.layers[APPLE_SPAWNS][cellIndex(simulation.GetState().apple)];
+    }
+
+    uint64_t ticks = 0UL;
+    uint64_t ticksSinceApple = 0UL;
+    while (simulation.GetState().running && (ticksSinceApple < maxTicksSinceApple))
+    {
+      std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+      analysis.Analyze(simulation.GetState().field, size);
+      for (size_t i = 0UL; i < snakes.size(); ++i)
+      {
+        aliveBefore[i] = snakes[i].alive ? 1U : 0U;
+        if (snakes[i].alive)
+        {
+          headsBefore[i] = snakes[i].Head();
+          simulation.SetPressedDirection(i, ChooseBotDirection(simulation, analysis, i));
+        }
+      }
+      Position const appleBefore = simulation.GetState().apple;
+
+      Simulation::Events const events = simulation.Step();
+      ++ticks;
+      ++ticksSinceApple;
+
+      // A plain sum over the board, it costs the same for any number of snakes
+      Simulation::Cell const * const pField = simulation.GetState().field.data();
+      for (size_t cell = 0UL; cell < cells; ++cell)
+      {
+        pOccupied[cell] += (pField[cell] != Simulation::FREE) ? 1UL : 0UL;
+      }
+
+      if (events.death)
+      {
+        for (size_t i = 0UL; i < snakes.size(); ++i)
+        {
+          accumulator.layers[DEATHS][cellIndex(headsBefore[i])] += ((aliveBefore[i] != 0U) && !snakes[i].alive) ? 1UL : 0UL;
+        }
+      }
+
+      if (simulation.HasApple() && !(simulation.GetState().apple == appleBefore))
+      {
+        ++accumulator.layers[APPLES_EATEN][cellIndex(appleBefore)];
+        ++accumulator.layers[APPLE_SPAWNS][cellIndex(simulation.GetState().apple)];
+        ticksSinceApple = 0UL;
+      }
+    }
+
+    ++accumulator.games;
+    accumulator.ticks += ticks;
+    accumulator.stalledGames += simulation.GetState().running ? 1UL : 0UL;
+    ++accumulator.gameLengths[std::min(ticks / LENGTH_BUCKET_TICKS, NUMBER_OF_LENGTH_BUCKETS - 1UL)];
+  }
+}
+
+
+static void ReduceCells(std::vector<Accumulator> const & accumulators, size_t const firstCell, size_t const endCell, Accumulator & total)
+{
+  // Every worker sums its own range of cells over all accumulators, no two write the same counter
+  for (size_t layer = 0UL; layer < NUMBER_OF_LAYERS; ++layer)
+  {
+    uint64_t* const pTotal = total.layers[layer].data();
+    for (Accumulator const & accumulator : accumulators)
+    {
+      uint64_t const * const pCounts = accumulator.layers[layer].data();
+      for (size_t cell = firstCell; cell < endCell; ++cell)
+      {
+        pTotal[cell] += pCounts[cell];
+      }
+    }
+  }
+}
+
+
+static bool WriteBinary(std::string const & path, Position const & size, Accumulator const & total)
+{
+  // Magic, version, width, height, games, ticks, stalled games, the layers row by row, then the game length buckets
+  FILE* const pFile = fopen(path.c_str(), "wb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+
+  uint32_t const header[5] = { HEATMAP_VERSION, static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y),
+                               static_cast<uint32_t>(NUMBER_OF_LAYERS), static_cast<uint32_t>(NUMBER_OF_LENGTH_BUCKETS) };
+  uint64_t const counts[3] = { total.games, total.ticks, total.stalledGames };
+  bool written =    (fwrite(HEATMAP_MAGIC, sizeof(HEATMAP_MAGIC), 1UL, pFile) == 1UL)
+                 && (fwrite(header, sizeof(header), 1UL, pFile) == 1UL)
+                 && (fwrite(counts, sizeof(counts), 1UL, pFile) == 1UL);
+  for (std::vector<uint64_t> const & layer : total.layers)
+  {
+    written = written && (fwrite(layer.data(), sizeof(uint64_t), layer.size(), pFile) == layer.size());
+  }
+  written = written && (fwrite(total.gameLengths.data(), sizeof(uint64_t), NUMBER_OF_LENGTH_BUCKETS, pFile) == NUMBER_OF_LENGTH_BUCKETS);
+  return (fclose(pFile) == 0) && written;
+}
+
+
+static uint32_t HeatColor(double const heat)
+{
+  // Black over red and yellow to white, as RGBA bytes
+  uint32_t const red = static_cast<uint32_t>(std::min(heat * 3.0, 1.0) * 255.0);
+  uint32_t const green = static_cast<uint32_t>(std::min(std::max(heat * 3.0 - 1.0, 0.0), 1.0) * 255.0);
+  uint32_t const blue = static_cast<uint32_t>(std::min(std::max(heat * 3.0 - 2.0, 0.0), 1.0) * 255.0);
+  return 0xFF000000U | (blue << 16) | (green << 8) | red;
+}
+
+
+static bool WritePng(std::string const & path, Position const & size, Accumulator const & total)
+{
+  // The layers side by side, each scaled to its own maximum
+  Position const panel = { size.x * PIXELS_PER_CELL, size.y * PIXELS_PER_CELL };
+  Position const image = { static_cast<int>(NUMBER_OF_LAYERS) * (panel.x + PANEL_GAP) - PANEL_GAP, panel.y };
+  std::vector<uint32_t> pixels(static_cast<size_t>(image.x) * image.y, 0xFF404040U);
+  for (size_t layer = 0UL; layer < NUMBER_OF_LAYERS; ++layer)
+  {
+    std::vector<uint64_t> const & counts = total.layers[layer];
+    double const maximum = static_cast<double>(std::max(*std::max_element(counts.begin(), counts.end()), static_cast<uint64_t>(1U)));
+    int const left = static_cast<int>(layer) * (panel.x + PANEL_GAP);
+    for (int y = 0; y < panel.y; ++y)
+    {
+      for (int x = 0; x < panel.x; ++x)
+      {
+        uint64_t const count = counts[static_cast<size_t>(y / PIXELS_PER_CELL) * size.x + x / PIXELS_PER_CELL];
+        pixels[static_cast<size_t>(y) * image.x + left + x] = HeatColor(static_cast<double>(count) / maximum);
+      }
+    }
+  }
+
+  SDL_Surface* const pSurface = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(), image.x, image.y, 32, image.x * 4,
+                                                                   SDL_PIXELFORMAT_RGBA32);
+  if (pSurface == nullptr)
+  {
+    return false;
+  }
+  bool const saved = IMG_SavePNG(pSurface, path.c_str()) == 0;
+  SDL_FreeSurface(pSurface);
+  return saved;
+}
+
+
+int RunAnalytics(Options const & options)
+{
+  Position const size = options.boardSize;
+  size_t const cells = static_cast<size_t>(size.x) * size.y;
+  uint64_t const numberOfGames = options.analyticsGames;
+  size_t const numberOfWorkers = std::max(std::thread::hardware_concurrency(), 1U);
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+  // Contiguous ranges of games per worker, each counting into its own accumulator
+  std::vector<Accumulator> accumulators(numberOfWorkers);
+  {
+    std::vector<std::thread> workers;
+    for (size_t worker = 0UL; worker < numberOfWorkers; ++worker)
+    {
+      workers.emplace_back(PlayGames, std::cref(options), numberOfGames * worker / numberOfWorkers,
+                           numberOfGames * (worker + 1UL) / numberOfWorkers, std::ref(accumulators[worker]));
+    }
+    for (std::thread & worker : workers)
+    {
+      worker.join();
+    }
+  }
+  std::chrono::steady_clock::time_point const played = std::chrono::steady_clock::now();
+
+  Accumulator total;
+  for (std::vector<uint64_t> & layer : total.layers)
+  {
+    layer.assign(cells, 0UL);
+  }
+  {
+    std::vector<std::thread> workers;
+    for (size_t worker = 0UL; worker < numberOfWorkers; ++worker)
+    {
+      workers.emplace_back(ReduceCells, std::cref(accumulators), cells * worker / numberOfWorkers,
+                           cells * (worker + 1UL) / numberOfWorkers, std::ref(total));
+    }
+    for (std::thread & worker : workers)
+    {
+      worker.join();
+    }
+  }
+  total.gameLengths.fill(0UL);
+  total.games = 0UL;
+  total.ticks = 0UL;
+  total.stalledGames = 0UL;
+  for (Accumulator const & accumulator : accumulators)
+  {
+    for (size_t bucket = 0UL; bucket < NUMBER_OF_LENGTH_BUCKETS; ++bucket)
+    {
+      total.gameLengths[bucket] += accumulator.gameLengths[bucket];
+    }
+    total.games += accumulator.games;
+    total.ticks += accumulator.ticks;
+    total.stalledGames += accumulator.stalledGames;
+  }
+
+  double const seconds = std::chrono::duration<double>(played - start).count();
+  std::cout << total.games << " games on " << numberOfWorkers << " cores in " << seconds << " s, "
+            << static_cast<uint64_t>(total.games / std::max(seconds, 1e-9)) << " games/s, "
+            << (total.ticks / std::max(total.games, static_cast<uint64_t>(1U))) << " ticks per game, "
+            << total.stalledGames << " stalled\n";
+
+  // Apples should be spread evenly over the cells they can appear on
+  for (size_t layer = 0UL; layer < NUMBER_OF_LAYERS; ++layer)
+  {
+    std::vector<uint64_t> const & counts = total.layers[layer];
+    uint64_t sum = 0UL;
+    for (uint64_t const count : counts)
+    {
+      sum += count;
+    }
+    std::cout << LAYER_NAMES[layer] << ": min " << *std::min_element(counts.begin(), counts.end())
+              << ", mean " << (sum / cells) << ", max " << *std::max_element(counts.begin(), counts.end()) << " per cell\n";
+  }
+
+  std::string const binaryPath = options.analyticsOutput + ".bin";
+  std::string const pngPath = options.analyticsOutput + ".png";
+  bool const binaryWritten = WriteBinary(binaryPath, size, total);
+  bool const pngWritten = WritePng(pngPath, size, total);
+  if (!binaryWritten || !pngWritten)
+  {
+    std::cerr << "Heatmap " << (binaryWritten ? pngPath : binaryPath) << " could not be written\n";
+    return 1;
+  }
+  std::cout << "written to " << binaryPath << " and " << pngPath << "\n";
+  return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+struct Options;
+
+// Plays many bot games on all cores and writes where snakes were, died and found apples as binary file and PNG heatmap
+int RunAnalytics(Options const & options);
@@ -0,0 +1,322 @@
+#include "AudioMixer.hpp"
+#include <SDL_mixer.h>
+#include <SDL_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+AudioMixer::AudioMixer(int const bufferSamples)
+: adaptive(bufferSamples <= 0)
+, bufferSamples((bufferSamples <= 0) ? MIN_BUFFER_SAMPLES : bufferSamples)
+, mixVoices(false)
+, callbackPeriod(0UL)
+, queue()
+, queueHead(0UL)
+, queueTail(0UL)
+, voices()
+, nextVoice(0UL)
+, lastCallbackTick(0UL)
+, callbacks(0UL)
+, lateCallbacks(0UL)
+, lateCallbacksAtOpen(0UL)
+, triggers(0UL)
+, latencySum_us(0UL)
+, maxLatency_us(0UL)
+, stolenVoices(0UL)
+, latencyHistogram()
+, retiredChunks()
+, droppedTriggers(0UL)
+, reopens(0UL)
+{
+  Open();
+}
+
+
+AudioMixer::~AudioMixer(void)
+{
+  Close();
+
+  std::cout << "audio: " << bufferSamples << " samples buffer, " << triggers << " sounds, trigger to mix mean "
+            << ((triggers > 0UL) ? latencySum_us / triggers : 0UL) << " us, p50 " << GetLatencyPercentile_us(50.0)
+            << " us, p99 " << GetLatencyPercentile_us(99.0) << " us, max " << maxLatency_us << " us, "
+            << lateCallbacks.load() << " late callbacks, " << droppedTriggers << " dropped, "
+            << stolenVoices << " stolen voices, " << reopens << " reopens\n";
+}
+
+
+void AudioMixer::Play(Mix_Chunk* const pChunk)
+{
+  if (pChunk == nullptr)
+  {
+    return;
+  }
+
+  if (!mixVoices)
+  {
+    // The device did not get 16 bit samples, SDL_mixer plays the sound itself
+    (void)Mix_PlayChannel(-1, pChunk, 0);
+    return;
+  }
+
+  FreeRetiredChunks();
+  if (!Push({ pChunk, SDL_GetPerformanceCounter(), false }))
+  {
+    ++droppedTriggers;
+  }
+}
+
+
+void AudioMixer::Forget(Mix_Chunk* const pChunk)
+{
+  if (pChunk == nullptr)
+  {
+    return;
+  }
+
+  if (!mixVoices)
+  {
+    // SDL_mixer halts the channels playing the chunk itself
+    Mix_FreeChunk(pChunk);
+    return;
+  }
+
+  // The callback stops the chunk when it gets to the command, the game thread never waits for it
+  retiredChunks.push_back({ pChunk, 0UL, false });
+  FreeRetiredChunks();
+}
+
+
+bool AudioMixer::NeedsLargerBuffer(void) const
+{
+  return adaptive && (bufferSamples < MAX_BUFFER_SAMPLES)
+      && ((lateCallbacks.load(std::memory_order_relaxed) - lateCallbacksAtOpen) >= UNDERRUN_LIMIT);
+}
+
+
+void AudioMixer::Reopen(void)
+{
+  Close();
+  bufferSamples = std::min(bufferSamples * 2, MAX_BUFFER_SAMPLES);
+  ++reopens;
+  Open();
+
+  std::cout << "audio: device underruns, buffer raised to " << bufferSamples << " samples\n";
+}
+
+
+uint64_t AudioMixer::GetBufferPeriod_us(void) const
+{
+  return (callbackPeriod * 1000000UL) / SDL_GetPerformanceFrequency();
+}
+
+
+uint64_t AudioMixer::GetLatencyPercentile_us(double const percentile) const
+{
+  uint64_t total = 0UL;
+  for (std::atomic<uint32_t> const & bucket : latencyHistogram)
+  {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  if (total == 0UL)
+  {
+    return 0UL;
+  }
+
+  uint64_t const rank = std::max(static_cast<uint64_t>(std::ceil(total * percentile / 100.0)), 1UL);
+  uint64_t counted = 0UL;
+  for (size_t i = 0UL; i < NUMBER_OF_LATENCY_BUCKETS; ++i)
+  {
+    counted += latencyHistogram[i].load(std::memory_order_relaxed);
+    if (counted >= rank)
+    {
+      return (i + 1UL) * LATENCY_BUCKET_US;
+    }
+  }
+  return NUMBER_OF_LATENCY_BUCKETS * LATENCY_BUCKET_US;
+}
+
+
+bool AudioMixer::Push(Trigger const & trigger)
+{
+  size_t const tail = queueTail.load(std::memory_order_relaxed);
+  if ((tail - queueHead.load(std::memory_order_acquire)) >= QUEUE_SIZE)
+  {
+    return false;
+  }
+  queue[tail % QUEUE_SIZE] = trigger;
+  queueTail.store(tail + 1UL, std::memory_order_release);
+  return true;
+}
+
+
+void AudioMixer::FreeRetiredChunks(void)
+{
+  // Commands which did not fit into the queue before go first, so they stay in order
+  for (RetiredChunk & retired : retiredChunks)
+  {
+    if (!retired.queued)
+    {
+      retired.position = queueTail.load(std::memory_order_relaxed);
+      retired.queued = Push({ retired.pChunk, 0UL, true });
+      if (!retired.queued)
+      {
+        break;
+      }
+    }
+  }
+
+  // Once the head passed the command the callback holds no pointer to the chunk anymore
+  size_t const head = queueHead.load(std::memory_order_acquire);
+  size_t kept = 0UL;
+  for (size_t i = 0UL; i < retiredChunks.size(); ++i)
+  {
+    if (retiredChunks[i].queued && (head > retiredChunks[i].position))
+    {
+      Mix_FreeChunk(retiredChunks[i].pChunk);
+    }
+    else
+    {
+      retiredChunks[kept++] = retiredChunks[i];
+    }
+  }
+  retiredChunks.resize(kept);
+}
+
+
+void AudioMixer::Open(void)
+{
+  if (Mix_OpenAudio(FREQUENCY, MIX_DEFAULT_FORMAT, CHANNELS, bufferSamples) < 0)
+    throw std::runtime_error("AudioMixer::Open: Audio could not be opened.");
+
+  int frequency = FREQUENCY;
+  Uint16 format = MIX_DEFAULT_FORMAT;
+  int channels = CHANNELS;
+  (void)Mix_QuerySpec(&frequency, &format, &channels);
+  mixVoices = (format == AUDIO_S16SYS);
+  callbackPeriod = (SDL_GetPerformanceFrequency() * static_cast<uint64_t>(bufferSamples)) / static_cast<uint64_t>(frequency);
+
+  lastCallbackTick = 0UL;
+  callbacks = 0UL;
+  lateCallbacksAtOpen = lateCallbacks.load();
+  Mix_SetPostMix(&AudioMixer::PostMix, this);
+}
+
+
+void AudioMixer::Close(void)
+{
+  // Once unregistered the callback never runs again, it is called with the audio device locked
+  Mix_SetPostMix(nullptr, nullptr);
+  for (RetiredChunk const & retired : retiredChunks)
+  {
+    Mix_FreeChunk(retired.pChunk);
+  }
+  retiredChunks.clear();
+  Mix_CloseAudio();
+
+  for (Voice & voice : voices)
+  {
+    voice.pChunk = nullptr;
+  }
+  queueHead.store(queueTail.load());
+}
+
+
+void AudioMixer::PostMix(void* pUserData, uint8_t* pStream, int length)
+{
+  static_cast<AudioMixer*>(pUserData)->Mix(reinterpret_cast<int16_t*>(pStream),
+                                           static_cast<size_t>(length) / sizeof(int16_t));
+}
+
+
+void AudioMixer::Mix(int16_t* const pSamples, size_t const count)
+{
+  uint64_t const now = SDL_GetPerformanceCounter();
+
+  // A callback later than one and a half buffers means the device ran dry in between
+  if ((callbacks > SETTLING_CALLBACKS) && ((now - lastCallbackTick) > (callbackPeriod * 3UL) / 2UL))
+  {
+    lateCallbacks.fetch_add(1UL, std::memory_order_relaxed);
+  }
+  lastCallbackTick = now;
+  ++callbacks;
+
+  // The slots up to the tail belong to the callback until the head is moved, forgotten chunks cancel their earlier triggers
+  size_t const first = queueHead.load(std::memory_order_relaxed);
+  size_t const tail = queueTail.load(std::memory_order_acquire);
+  for (size_t command = first; command != tail; ++command)
+  {
+    if (queue[command % QUEUE_SIZE].forget)
+    {
+      for (size_t head = first; head != command; ++head)
+      {
+        Trigger & trigger = queue[head % QUEUE_SIZE];
+        trigger.pChunk = (trigger.pChunk == queue[command % QUEUE_SIZE].pChunk) ? nullptr : trigger.pChunk;
+      }
+    }
+  }
+
+  // Start the triggered sounds, they are heard from the first sample of this buffer
+  uint64_t const frequency = SDL_GetPerformanceFrequency();
+  for (size_t head = first; head != tail; ++head)
+  {
+    Trigger const & trigger = queue[head % QUEUE_SIZE];
+    if (trigger.forget)
+    {
+      for (Voice & voice : voices)
+      {
+        voice.pChunk = (voice.pChunk == trigger.pChunk) ? nullptr : voice.pChunk;
+      }
+      continue;
+    }
+    if (trigger.pChunk == nullptr)
+    {
+      continue;
+    }
+
+    uint64_t const latency_us = ((now - trigger.tick) * 1000000UL) / frequency;
+    ++triggers;
+    latencySum_us += latency_us;
+    maxLatency_us = std::max(maxLatency_us, latency_us);
+    latencyHistogram[std::min(static_cast<size_t>(latency_us / LATENCY_BUCKET_US), NUMBER_OF_LATENCY_BUCKETS - 1UL)]
+      .fetch_add(1U, std::memory_order_relaxed);
+
+    std::array<Voice, NUMBER_OF_VOICES>::iterator voice =
+      std::find_if(voices.begin(), voices.end(), [](Voice const & candidate){ return candidate.pChunk == nullptr; });
+    if (voice == voices.end())
+    {
+      voice = voices.begin() + nextVoice;
+      nextVoice = (nextVoice + 1UL) % NUMBER_OF_VOICES;
+      ++stolenVoices;
+    }
+    *voice = { trigger.pChunk, 0U };
+  }
+  queueHead.store(tail, std::memory_order_release);
+
+  int32_t const masterVolume = Mix_MasterVolume(-1);
+  for (Voice & voice : voices)
+  {
+    if (voice.pChunk == nullptr)
+    {
+      continue;
+    }
+
+    // Chunks are converted to the device format on load, so samples are added as they are
+    int16_t const * const pSource = reinterpret_cast<int16_t const *>(voice.pChunk->abuf + voice.offset);
+    size_t const samples = std::min(count, static_cast<size_t>(voice.pChunk->alen - voice.offset) / sizeof(int16_t));
+    int32_t const gain = static_cast<int32_t>(voice.pChunk->volume) * masterVolume;
+    for (size_t i = 0UL; i < samples; ++i)
+    {
+      int32_t const sample = pSamples[i] + ((pSource[i] * gain) >> 14);
+      pSamples[i] = static_cast<int16_t>(std::max<int32_t>(std::min<int32_t>(sample, std::numeric_limits<int16_t>::max()),
+                                                           std::numeric_limits<int16_t>::min()));
+    }
+
+    voice.offset += static_cast<uint32_t>(samples * sizeof(int16_t));
+    if (voice.offset >= voice.pChunk->alen)
+    {
+      voice.pChunk = nullptr;
+    }
+  }
+}
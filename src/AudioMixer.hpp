@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef struct Mix_Chunk Mix_Chunk;
+
+// Sound effects mixed in SDL_mixer's post mix callback, so a trigger is heard with the next buffer
+class AudioMixer
+{
+public:
+  // Zero buffer samples start small and grow while the device underruns
+  AudioMixer(int const bufferSamples);
+  ~AudioMixer(void);
+
+  void Play(Mix_Chunk* const pChunk);
+  // Stops the chunk and frees it once the callback is done with it, the caller must not use it anymore
+  void Forget(Mix_Chunk* const pChunk);
+
+  bool NeedsLargerBuffer(void) const;
+  void Reopen(void);
+
+  uint64_t GetBufferPeriod_us(void) const;
+  // Upper bound of the time from a trigger to its first mixed sample for the given share of all triggers so far
+  uint64_t GetLatencyPercentile_us(double const percentile) const;
+
+private:
+  static int constexpr FREQUENCY = 48000;
+  static int constexpr CHANNELS = 2;
+  static int constexpr MIN_BUFFER_SAMPLES = 256;
+  static int constexpr MAX_BUFFER_SAMPLES = 4096;
+  static uint64_t constexpr UNDERRUN_LIMIT = 3UL;
+  static uint64_t constexpr SETTLING_CALLBACKS = 8UL;
+  static size_t constexpr QUEUE_SIZE = 64UL;
+  static size_t constexpr NUMBER_OF_VOICES = 16UL;
+  static uint64_t constexpr LATENCY_BUCKET_US = 50UL;
+  static size_t constexpr NUMBER_OF_LATENCY_BUCKETS = 2048UL;
+
+  // Plays the chunk or, once forget is set, stops it and cancels its earlier triggers
+  struct Trigger
+  {
+    Mix_Chunk* pChunk;
+    uint64_t tick;
+    bool forget;
+  };
+
+  // A forgotten chunk is freed once the callback passed the command at position
+  struct RetiredChunk
+  {
+    Mix_Chunk* pChunk;
+    size_t position;
+    bool queued;
+  };
+
+  struct Voice
+  {
+    Mix_Chunk* pChunk;
+    uint32_t offset;
+  };
+
+  bool adaptive;
+  int bufferSamples;
+  bool mixVoices;
+  uint64_t callbackPeriod;
+
+  // Single producer, single consumer ring, the game thread writes the tail and the callback the head
+  std::array<Trigger, QUEUE_SIZE> queue;
+  std::atomic<size_t> queueHead;
+  std::atomic<size_t> queueTail;
+
+  // Only touched by the callback, or while it is unregistered
+  std::array<Voice, NUMBER_OF_VOICES> voices;
+  size_t nextVoice;
+
+  // Written by the callback
+  uint64_t lastCallbackTick;
+  uint64_t callbacks;
+  std::atomic<uint64_t> lateCallbacks;
+  uint64_t lateCallbacksAtOpen;
+  uint64_t triggers;
+  uint64_t latencySum_us;
+  uint64_t maxLatency_us;
+  uint64_t stolenVoices;
+  std::array<std::atomic<uint32_t>, NUMBER_OF_LATENCY_BUCKETS> latencyHistogram;
+
+  // Written by the game thread
+  std::vector<RetiredChunk> retiredChunks;
+  uint64_t droppedTriggers;
+  uint64_t reopens;
+
+  bool Push(Trigger const & trigger);
+  void FreeRetiredChunks(void);
+  void Open(void);
+  void Close(void);
+  static void PostMix(void* pUserData, uint8_t* pStream, int length);
+  void Mix(int16_t* const pSamples, size_t const count);
+};
@@ -0,0 +1,116 @@
+#include "AudioSelftest.hpp"
+#include "AudioMixer.hpp"
+#include "Options.hpp"
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <SDL_stdinc.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+static uint32_t constexpr SELFTEST_TRIGGERS = 2000U;
+// Sounds are unloaded while they play, like under a tight memory budget
+static uint32_t constexpr FORGET_PERIOD = 25U;
+static uint32_t constexpr MIN_TRIGGER_PERIOD_US = 500U;
+static uint32_t constexpr MAX_TRIGGER_PERIOD_US = 9000U;
+static uint32_t constexpr DRAIN_TIME_MS = 200U;
+static int constexpr BEEP_FREQUENCY = 48000;
+static size_t constexpr BEEP_FRAMES = 960UL;
+// A trigger waits for the next callback, so it is mixed within a buffer unless the callback runs late
+static uint64_t constexpr MAX_P99_BUFFERS = 2UL;
+
+#ifdef _WIN32
+static char constexpr NULL_DEVICE[] = "NUL";
+#else
+static char constexpr NULL_DEVICE[] = "/dev/null";
+#endif
+
+// Sorts the values, so the maximum is the last one afterwards
+static uint64_t Percentile(std::vector<uint64_t> & values, double const percentile)
+{
+  std::sort(values.begin(), values.end());
+  return values[std::min(static_cast<size_t>(values.size() * percentile / 100.0), values.size() - 1UL)];
+}
+
+
+int RunAudioSelftest(Options const & options)
+{
+  // The disk driver writes the samples away at the pace of a sound card, another driver may be chosen by SDL_AUDIODRIVER
+  (void)SDL_setenv("SDL_AUDIODRIVER", "disk", 0);
+  (void)SDL_setenv("SDL_DISKAUDIOFILE", NULL_DEVICE, 0);
+
+  // 20 ms of a 440 Hz tone in 16 bit stereo, the mixer expects its chunks in the device format
+  std::vector<int16_t> beep(BEEP_FRAMES * 2UL);
+  for (size_t frame = 0UL; frame < BEEP_FRAMES; ++frame)
+  {
+    int16_t const sample = static_cast<int16_t>(8000.0 * std::sin(2.0 * M_PI * 440.0 * frame / BEEP_FREQUENCY));
+    beep[2UL * frame] = sample;
+    beep[2UL * frame + 1UL] = sample;
+  }
+
+  std::unique_ptr<AudioMixer> pMixer;
+  try {
+    pMixer.reset(new AudioMixer(static_cast<int>(options.audioBufferSamples)));
+  } catch (std::exception const & exception) {
+    std::cerr << exception.what() << " " << SDL_GetError() << "\n";
+    SDL_Quit();
+    return 1;
+  }
+
+  std::mt19937 random(1U);
+  std::uniform_int_distribution<uint32_t> period_us(MIN_TRIGGER_PERIOD_US, MAX_TRIGGER_PERIOD_US);
+  std::vector<uint64_t> playTimes_ns;
+  std::vector<uint64_t> forgetTimes_ns;
+  playTimes_ns.reserve(SELFTEST_TRIGGERS);
+  forgetTimes_ns.reserve(SELFTEST_TRIGGERS / FORGET_PERIOD);
+  Mix_Chunk* pChunk = Mix_QuickLoad_RAW(reinterpret_cast<uint8_t*>(beep.data()), static_cast<uint32_t>(beep.size() * sizeof(int16_t)));
+
+  for (uint32_t trigger = 0U; trigger < SELFTEST_TRIGGERS; ++trigger)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(period_us(random)));
+    if (pMixer->NeedsLargerBuffer())
+    {
+      pMixer->Reopen();
+    }
+
+    std::chrono::steady_clock::time_point const playStart = std::chrono::steady_clock::now();
+    pMixer->Play(pChunk);
+    playTimes_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - playStart).count());
+
+    if ((trigger % FORGET_PERIOD) == (FORGET_PERIOD - 1U))
+    {
+      // The mixer frees the chunk, the samples stay with the selftest
+      std::chrono::steady_clock::time_point const forgetStart = std::chrono::steady_clock::now();
+      pMixer->Forget(pChunk);
+      forgetTimes_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - forgetStart).count());
+      pChunk = Mix_QuickLoad_RAW(reinterpret_cast<uint8_t*>(beep.data()), static_cast<uint32_t>(beep.size() * sizeof(int16_t)));
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_TIME_MS));
+
+  uint64_t const bufferPeriod_us = pMixer->GetBufferPeriod_us();
+  uint64_t const p50_us = pMixer->GetLatencyPercentile_us(50.0);
+  uint64_t const p90_us = pMixer->GetLatencyPercentile_us(90.0);
+  uint64_t const p99_us = pMixer->GetLatencyPercentile_us(99.0);
+  uint64_t const p999_us = pMixer->GetLatencyPercentile_us(99.9);
+  pMixer->Forget(pChunk);
+  pMixer.reset();
+  SDL_Quit();
+
+  uint64_t const playP99_ns = Percentile(playTimes_ns, 99.0);
+  uint64_t const forgetP99_ns = Percentile(forgetTimes_ns, 99.0);
+  bool const passed = (p50_us > 0UL) && (p99_us <= MAX_P99_BUFFERS * bufferPeriod_us);
+  std::cout << SELFTEST_TRIGGERS << " triggers, " << forgetTimes_ns.size() << " sounds unloaded while playing, "
+            << bufferPeriod_us << " us per buffer\n"
+            << "trigger to mix: p50 " << p50_us << " us, p90 " << p90_us << " us, p99 " << p99_us << " us, p99.9 " << p999_us << " us\n"
+            << "game thread: play p99 " << playP99_ns << " ns, max " << playTimes_ns.back() << " ns, forget p99 "
+            << forgetP99_ns << " ns, max " << forgetTimes_ns.back() << " ns\n"
+            << "Audio selftest " << (passed ? "passed" : "FAILED") << "\n";
+  return passed ? 0 : 1;
+}
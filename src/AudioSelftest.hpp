@@ -0,0 +1,6 @@
+#pragma once
+
+struct Options;
+
+// Triggers and unloads sounds on the running mixer like the game does and reports the trigger to mix latency percentiles
+int RunAudioSelftest(Options const & options);
@@ -0,0 +1,269 @@
+#include "BoardAnalysis.hpp"
+#include "Position.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BOARD_ANALYSIS_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit, bits must not be 0
+static int CountTrailingZeros(uint64_t const bits)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index = 0UL;
+  (void)_BitScanForward64(&index, bits);
+  return static_cast<int>(index);
+#elif defined(_MSC_VER)
+  // 32 bit targets only scan 32 bits at once
+  unsigned long index = 0UL;
+  if (_BitScanForward(&index, static_cast<unsigned long>(bits)) == 0U)
+  {
+    (void)_BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+    index += 32UL;
+  }
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(bits);
+#endif
+}
+
+BoardAnalysis::BoardAnalysis(void)
+: size{ 0, 0 }
+, words(0UL)
+, freeBits()
+, runs()
+, rowRuns()
+, parents()
+, runRegions()
+, regionSizes()
+{
+}
+
+
+void BoardAnalysis::Analyze(std::vector<uint8_t> const & field, Position const & fieldSize)
+{
+  Resize(fieldSize);
+  for (int y = 0; y < size.y; ++y)
+  {
+    BuildRow(field.data() + static_cast<size_t>(y) * size.x, freeBits.data() + static_cast<size_t>(y) * words);
+  }
+  Label();
+}
+
+
+void BoardAnalysis::Analyze(uint64_t const * const pOccupiedBits, Position const & fieldSize)
+{
+  Resize(fieldSize);
+
+  // Rows start anywhere in the words, so each row word is shifted together from two
+  size_t const cellWords = (static_cast<size_t>(size.x) * size.y + 63UL) / 64UL;
+  for (int y = 0; y < size.y; ++y)
+  {
+    for (size_t word = 0UL; word < words; ++word)
+    {
+      size_t const bit = static_cast<size_t>(y) * size.x + word * 64UL;
+      size_t const source = bit / 64UL;
+      size_t const shift = bit % 64UL;
+      uint64_t occupied = pOccupiedBits[source] >> shift;
+      if ((shift > 0UL) && (source + 1UL < cellWords))
+      {
+        occupied |= pOccupiedBits[source + 1UL] << (64UL - shift);
+      }
+      freeBits[static_cast<size_t>(y) * words + word] = ~occupied;
+    }
+  }
+  Label();
+}
+
+
+void BoardAnalysis::Resize(Position const & fieldSize)
+{
+  // Buffers keep their capacity, so analyzing every tick does not allocate
+  size = fieldSize;
+  words = static_cast<size_t>(size.x + 63) / 64UL;
+  freeBits.assign(words * size.y, 0UL);
+  runs.clear();
+  rowRuns.clear();
+  parents.clear();
+}
+
+
+void BoardAnalysis::Label(void)
+{
+  size_t previousBegin = 0UL;
+  for (int y = 0; y < size.y; ++y)
+  {
+    uint64_t const * const pBits = freeBits.data() + static_cast<size_t>(y) * words;
+    size_t const begin = runs.size();
+    rowRuns.push_back(begin);
+    size_t above = previousBegin;
+    for (int x = FindBit(pBits, 0, true); x < size.x; x = FindBit(pBits, x, true))
+    {
+      Run const run = { x, std::min(FindBit(pBits, x, false), size.x) };
+      uint32_t const index = static_cast<uint32_t>(runs.size());
+      runs.push_back(run);
+      parents.push_back(index);
+
+      // Join with every run above which shares a column, the lower index becomes the root
+      while ((above < begin) && (runs[above].end <= run.start))
+      {
+        ++above;
+      }
+      for (size_t other = above; (other < begin) && (runs[other].start < run.end); ++other)
+      {
+        uint32_t const rootA = FindRoot(static_cast<uint32_t>(other));
+        uint32_t const rootB = FindRoot(index);
+        parents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+      }
+
+      x = run.end;
+    }
+    previousBegin = begin;
+  }
+  rowRuns.push_back(runs.size());
+
+  // Roots come first, so one pass numbers the regions and sums their cells
+  runRegions.resize(runs.size());
+  regionSizes.assign(1UL, 0U);
+  for (uint32_t run = 0U; run < runs.size(); ++run)
+  {
+    uint32_t const root = FindRoot(run);
+    if (root == run)
+    {
+      runRegions[run] = static_cast<uint32_t>(regionSizes.size());
+      regionSizes.push_back(0U);
+    }
+    else
+    {
+      runRegions[run] = runRegions[root];
+    }
+    regionSizes[runRegions[run]] += static_cast<uint32_t>(runs[run].end - runs[run].start);
+  }
+}
+
+
+uint32_t BoardAnalysis::GetRegion(Position const & cell) const
+{
+  if ((cell.x < 0) || (cell.y < 0) || (cell.x >= size.x) || (cell.y >= size.y))
+  {
+    return 0U;
+  }
+
+  std::vector<Run>::const_iterator const rowBegin = runs.begin() + rowRuns[cell.y];
+  std::vector<Run>::const_iterator const rowEnd = runs.begin() + rowRuns[cell.y + 1];
+  std::vector<Run>::const_iterator const next =
+    std::upper_bound(rowBegin, rowEnd, cell.x, [](int const x, Run const & run){ return x < run.start; });
+  if ((next == rowBegin) || ((next - 1)->end <= cell.x))
+  {
+    return 0U;
+  }
+  return runRegions[(next - 1) - runs.begin()];
+}
+
+
+uint32_t BoardAnalysis::GetRegionSize(uint32_t const region) const
+{
+  return (region < regionSizes.size()) ? regionSizes[region] : 0U;
+}
+
+
+size_t BoardAnalysis::GetNumberOfRegions(void) const
+{
+  return regionSizes.size() - 1UL;
+}
+
+
+uint32_t BoardAnalysis::GetReachableCells(Position const & head) const
+{
+  uint32_t regions[4];
+  size_t const count = GetAdjacentRegions(head, regions);
+  uint32_t cells = 0U;
+  for (size_t i = 0UL; i < count; ++i)
+  {
+    cells += regionSizes[regions[i]];
+  }
+  return cells;
+}
+
+
+bool BoardAnalysis::IsReachable(Position const & head, Position const & cell) const
+{
+  uint32_t const region = GetRegion(cell);
+  uint32_t regions[4];
+  size_t const count = GetAdjacentRegions(head, regions);
+  return (region != 0U) && (std::find(regions, regions + count, region) != regions + count);
+}
+
+
+void BoardAnalysis::BuildRow(uint8_t const * const pCells, uint64_t* const pBits) const
+{
+  int x = 0;
+#ifdef BOARD_ANALYSIS_SSE2
+  // 16 cells compared at once, their mask lands at a multiple of 16 bits in the word
+  __m128i const zero = _mm_setzero_si128();
+  for (; x + 16 <= size.x; x += 16)
+  {
+    uint64_t const mask = static_cast<uint16_t>(_mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(pCells + x)), zero)));
+    pBits[x / 64] |= mask << (x % 64);
+  }
+#endif
+  for (; x < size.x; ++x)
+  {
+    pBits[x / 64] |= static_cast<uint64_t>(pCells[x] == 0U) << (x % 64);
+  }
+}
+
+
+int BoardAnalysis::FindBit(uint64_t const * const pBits, int const from, bool const value) const
+{
+  // Whole words of the other value are skipped at once
+  size_t word = static_cast<size_t>(from) / 64UL;
+  if (word >= words)
+  {
+    return size.x;
+  }
+  uint64_t bits = (value ? pBits[word] : ~pBits[word]) & (~static_cast<uint64_t>(0U) << (from % 64));
+  while (bits == 0UL)
+  {
+    if (++word >= words)
+    {
+      return size.x;
+    }
+    bits = value ? pBits[word] : ~pBits[word];
+  }
+  return std::min(static_cast<int>(word * 64UL) + CountTrailingZeros(bits), size.x);
+}
+
+
+uint32_t BoardAnalysis::FindRoot(uint32_t run)
+{
+  while (parents[run] != run)
+  {
+    parents[run] = parents[parents[run]];
+    run = parents[run];
+  }
+  return run;
+}
+
+
+size_t BoardAnalysis::GetAdjacentRegions(Position const & head, uint32_t (&regions)[4]) const
+{
+  Position const neighbours[4] = { { head.x, head.y - 1 }, { head.x, head.y + 1 },
+                                   { head.x - 1, head.y }, { head.x + 1, head.y } };
+  size_t count = 0UL;
+  for (Position const & neighbour : neighbours)
+  {
+    uint32_t const region = GetRegion(neighbour);
+    if ((region != 0U) && (std::find(regions, regions + count, region) == regions + count))
+    {
+      regions[count++] = region;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Position.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Connected regions of free cells, cells are free when zero and regions are numbered from 1
+class BoardAnalysis
+{
+public:
+  BoardAnalysis(void);
+
+  void Analyze(std::vector<uint8_t> const & field, Position const & fieldSize);
+  // One set bit per occupied cell, cell y * width + x is bit (cell % 64) of word cell / 64
+  void Analyze(uint64_t const * const pOccupiedBits, Position const & fieldSize);
+
+  uint32_t GetRegion(Position const & cell) const;
+  uint32_t GetRegionSize(uint32_t const region) const;
+  size_t GetNumberOfRegions(void) const;
+
+  // Free cells the snake with this head can still reach, summed over the regions around it
+  uint32_t GetReachableCells(Position const & head) const;
+  bool IsReachable(Position const & head, Position const & cell) const;
+
+private:
+  struct Run
+  {
+    int start;
+    int end;
+  };
+
+  Position size;
+  size_t words;
+
+  // One bit per cell, set for free cells, 64 cells per word
+  std::vector<uint64_t> freeBits;
+
+  // Runs of free cells per row, joined with the overlapping runs of the row above
+  std::vector<Run> runs;
+  std::vector<size_t> rowRuns;
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> runRegions;
+  std::vector<uint32_t> regionSizes;
+
+  void Resize(Position const & fieldSize);
+  void Label(void);
+  void BuildRow(uint8_t const * const pCells, uint64_t* const pBits) const;
+  int FindBit(uint64_t const * const pBits, int const from, bool const value) const;
+  uint32_t FindRoot(uint32_t run);
+  size_t GetAdjacentRegions(Position const & head, uint32_t (&regions)[4]) const;
+};
@@ -0,0 +1,94 @@
+#include "Bot.hpp"
+#include "BoardAnalysis.hpp"
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <cstdlib>
+
+static Position Move(Position const & position, Simulation::Direction const direction)
+{
+  switch (direction)
+  {
+    case Simulation::Direction::Up:
+      return { position.x, position.y - 1 };
+
+    case Simulation::Direction::Down:
+      return { position.x, position.y + 1 };
+
+    case Simulation::Direction::Left:
+      return { position.x - 1, position.y };
+
+    case Simulation::Direction::Right:
+    default:
+      return { position.x + 1, position.y };
+  }
+}
+
+
+static int CountFreeNeighbours(Simulation const & simulation, Position const & position)
+{
+  int count = 0;
+  count += simulation.IsFree({ position.x, position.y - 1 }) ? 1 : 0;
+  count += simulation.IsFree({ position.x, position.y + 1 }) ? 1 : 0;
+  count += simulation.IsFree({ position.x - 1, position.y }) ? 1 : 0;
+  count += simulation.IsFree({ position.x + 1, position.y }) ? 1 : 0;
+  return count;
+}
+
+
+Simulation::Direction ChooseBotDirection(Simulation const & simulation, BoardAnalysis const & analysis, size_t const player)
+{
+  Simulation::State const & state = simulation.GetState();
+  Simulation::Snake const & snake = state.snakes[player];
+  Position const head = snake.Head();
+
+  // Go straight or turn, a snake can't reverse
+  bool const movingVertical =    (snake.snakeDirection == Simulation::Direction::Up)
+                              || (snake.snakeDirection == Simulation::Direction::Down);
+  Simulation::Direction const candidates[3] = {
+    snake.snakeDirection,
+    movingVertical ? Simulation::Direction::Left : Simulation::Direction::Up,
+    movingVertical ? Simulation::Direction::Right : Simulation::Direction::Down
+  };
+
+  // Vary the preferred turn per snake and move, but stay deterministic
+  size_t const firstTurn = 1U + ((player + state.numberOfMoves / 8U) % 2U);
+
+  Simulation::Direction best = snake.snakeDirection;
+  int bestScore = -1;
+  for (size_t i = 0U; i < 3U; ++i)
+  {
+    Simulation::Direction const direction = candidates[(i == 0U) ? 0U : ((i == 1U) ? firstTurn : 3U - firstTurn)];
+    Position const target = Move(head, direction);
+    if (!simulation.IsFree(target))
+    {
+      continue;
+    }
+
+    // One step look ahead avoids most dead ends
+    int score = CountFreeNeighbours(simulation, target) * 4;
+
+    // Regions too small for the whole body are traps
+    score += (analysis.GetRegionSize(analysis.GetRegion(target)) >= snake.length) ? 16 : 0;
+    if (simulation.HasApple())
+    {
+      int const distance = std::abs(state.apple.x - target.x) + std::abs(state.apple.y - target.y);
+      int const currentDistance = std::abs(state.apple.x - head.x) + std::abs(state.apple.y - head.y);
+      score += (distance < currentDistance) ? 3 : 0;
+    }
+    else if (i == 0U)
+    {
+      score += 1;
+    }
+
+    // Items next to the head are taken on the way
+    score += state.items.HasItem(target.y * simulation.GetSize().x + target.x) ? 2 : 0;
+
+    if (score > bestScore)
+    {
+      bestScore = score;
+      best = direction;
+    }
+  }
+
+  return best;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "BoardAnalysis.hpp"
+#include "Simulation.hpp"
+#include <cstddef>
+
+Simulation::Direction ChooseBotDirection(Simulation const & simulation, BoardAnalysis const & analysis, size_t const player);
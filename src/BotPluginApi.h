@@ -0,0 +1,86 @@
+#pragma once
+
+/* Stable C interface of bot plugins, shared libraries loaded with --bot <player>:<library>.
+ *
+ * A plugin exports the four functions below. Every tick the host hands each plugin a view of the board
+ * which points straight into the simulation: nothing is copied, and nothing may be written or kept past
+ * the call. A decision has to return within the deadline given by --bot-deadline, late decisions are
+ * ignored and a plugin which is late too often is replaced by the built-in bot.
+ *
+ * snake_bot_decide runs on a thread of its own for every controlled player, the game only waits for it
+ * until the deadline. Past the deadline the board keeps moving, so the view may change or be freed under
+ * a plugin still deciding; it is not called again before it returns. A plugin which never returns is
+ * left running at exit: its context is not destroyed and its library stays loaded.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNAKE_BOT_ABI_VERSION 1U
+
+/* Directions as returned by snake_bot_decide, a negative value keeps the current direction */
+#define SNAKE_BOT_UP 0
+#define SNAKE_BOT_DOWN 1
+#define SNAKE_BOT_LEFT 2
+#define SNAKE_BOT_RIGHT 3
+
+#define SNAKE_BOT_ITEM_APPLE 0U
+#define SNAKE_BOT_ITEM_GOLDEN_APPLE 1U
+#define SNAKE_BOT_ITEM_SCISSORS 2U
+
+typedef struct SnakeBotPosition
+{
+  int32_t x;
+  int32_t y;
+} SnakeBotPosition;
+
+/* Body parts as a ring of a power of two size, part i counted from the head is ring[(head + i) % ringSize] */
+typedef struct SnakeBotSnake
+{
+  SnakeBotPosition const * ring;
+  uint32_t ringSize;
+  uint32_t head;
+  uint32_t length;
+  uint8_t direction;
+  uint8_t alive;
+} SnakeBotSnake;
+
+/* Items lying on the board, the reserved fields belong to the host */
+typedef struct SnakeBotItem
+{
+  int32_t cell;
+  uint64_t expiryTick;
+  uint8_t type;
+  uint8_t reserved0;
+  uint16_t reserved1[2];
+} SnakeBotItem;
+
+typedef struct SnakeBotView
+{
+  uint32_t abiVersion;
+  int32_t width;
+  int32_t height;
+  /* width * height cells row by row, 0 is free and n is a part of snake n - 1 */
+  uint8_t const * field;
+  SnakeBotSnake const * snakes;
+  uint32_t numberOfSnakes;
+  SnakeBotItem const * items;
+  uint32_t numberOfItems;
+  /* Only valid if hasApple is set */
+  SnakeBotPosition apple;
+  uint8_t hasApple;
+  uint64_t tick;
+} SnakeBotView;
+
+uint32_t snake_bot_abi_version(void);
+/* One context per controlled player, may return NULL if the plugin keeps no state */
+void* snake_bot_create(uint32_t player);
+int32_t snake_bot_decide(void* context, SnakeBotView const * view, uint32_t player);
+void snake_bot_destroy(void* context);
+
+#ifdef __cplusplus
+}
+#endif
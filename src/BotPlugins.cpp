@@ -0,0 +1,279 @@
+#include "BotPlugins.hpp"
+#include "ItemLayer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// The view points into the simulation, so its types have to match the layout of the C interface
+static_assert(sizeof(Position) == sizeof(SnakeBotPosition), "Positions differ from the bot interface");
+static_assert(offsetof(Position, y) == offsetof(SnakeBotPosition, y), "Positions differ from the bot interface");
+static_assert(sizeof(Simulation::Cell) == sizeof(uint8_t), "Cells differ from the bot interface");
+static_assert(sizeof(ItemLayer::Item) == sizeof(SnakeBotItem), "Items differ from the bot interface");
+static_assert(offsetof(ItemLayer::Item, expiry) == offsetof(SnakeBotItem, expiryTick), "Items differ from the bot interface");
+static_assert(offsetof(ItemLayer::Item, type) == offsetof(SnakeBotItem, type), "Items differ from the bot interface");
+
+BotPlugins::BotPlugins(std::vector<Options::BotPlugin> const & plugins, uint32_t const deadline_us)
+: deadline_ns(static_cast<uint64_t>(deadline_us) * 1000UL)
+, libraries()
+, controllers(Simulation::MAX_PLAYERS)
+, snakes()
+, view()
+{
+  // Descriptors of all snakes are rewritten each tick, they never grow
+  snakes.reserve(Simulation::MAX_PLAYERS);
+
+  for (Options::BotPlugin const & plugin : plugins)
+  {
+    Controller & controller = controllers[plugin.player];
+    if (controller.library != NO_LIBRARY)
+    {
+      throw std::runtime_error("BotPlugins::BotPlugins: Player " + std::to_string(plugin.player + 1U) + " has two bots.");
+    }
+    controller.library = Load(plugin.path);
+    controller.pWorker = std::make_shared<Worker>();
+    Worker & worker = *controller.pWorker;
+    worker.decide = libraries[controller.library].decide;
+    worker.pContext = libraries[controller.library].create(plugin.player);
+    worker.player = plugin.player;
+    worker.snakes.reserve(Simulation::MAX_PLAYERS);
+    worker.view = SnakeBotView();
+    worker.requests = 0UL;
+    worker.answers = 0UL;
+    worker.decision = -1;
+    worker.stop = false;
+  }
+
+  // Only once all plugins are loaded, a failed load leaves no thread behind
+  for (Controller & controller : controllers)
+  {
+    if (controller.library != NO_LIBRARY)
+    {
+      controller.thread = std::thread(&BotPlugins::RunWorker, controller.pWorker);
+    }
+  }
+}
+
+
+BotPlugins::~BotPlugins(void)
+{
+  std::vector<bool> librariesInUse(libraries.size(), false);
+  for (size_t player = 0UL; player < controllers.size(); ++player)
+  {
+    Controller & controller = controllers[player];
+    if (controller.library == NO_LIBRARY)
+    {
+      continue;
+    }
+
+    std::cout << "bot " << libraries[controller.library].path << " for player " << (player + 1UL) << ": "
+              << controller.calls << " decisions, "
+              << ((controller.calls > 0UL) ? (controller.total_ns / controller.calls) : 0UL) << " ns avg, "
+              << controller.max_ns << " ns max, " << controller.overruns << " late"
+              << (controller.demoted ? ", demoted" : "") << "\n";
+
+    Worker & worker = *controller.pWorker;
+    bool busy = false;
+    {
+      std::lock_guard<std::mutex> const lock(worker.mutex);
+      busy = (worker.answers != worker.requests);
+      worker.stop = true;
+    }
+    worker.requestCondition.notify_one();
+    if (busy)
+    {
+      // A plugin still deciding may never return, it is left running with its context and its library
+      std::cerr << "Bot " << libraries[controller.library].path << " for player " << (player + 1UL)
+                << " is still deciding and is left behind\n";
+      controller.thread.detach();
+      librariesInUse[controller.library] = true;
+      continue;
+    }
+    controller.thread.join();
+    libraries[controller.library].destroy(worker.pContext);
+  }
+
+  for (size_t library = 0UL; library < libraries.size(); ++library)
+  {
+    if (librariesInUse[library])
+    {
+      continue;
+    }
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(libraries[library].pHandle));
+#else
+    dlclose(libraries[library].pHandle);
+#endif
+  }
+}
+
+
+void BotPlugins::BeginTick(Simulation const & simulation)
+{
+  Simulation::State const & state = simulation.GetState();
+  snakes.clear();
+  for (Simulation::Snake const & snake : state.snakes)
+  {
+    snakes.push_back(SnakeBotSnake{ reinterpret_cast<SnakeBotPosition const *>(snake.ring.data()),
+                                    static_cast<uint32_t>(snake.ring.size()),
+                                    snake.head,
+                                    snake.length,
+                                    static_cast<uint8_t>(snake.snakeDirection),
+                                    static_cast<uint8_t>(snake.alive ? 1U : 0U) });
+  }
+
+  view.abiVersion = SNAKE_BOT_ABI_VERSION;
+  view.width = simulation.GetSize().x;
+  view.height = simulation.GetSize().y;
+  view.field = state.field.data();
+  view.snakes = snakes.data();
+  view.numberOfSnakes = static_cast<uint32_t>(snakes.size());
+  view.numberOfItems = static_cast<uint32_t>(state.items.GetNumberOfItems());
+  view.items = (view.numberOfItems > 0U) ? reinterpret_cast<SnakeBotItem const *>(&state.items.GetItem(0UL)) : nullptr;
+  view.apple = SnakeBotPosition{ state.apple.x, state.apple.y };
+  view.hasApple = simulation.HasApple() ? 1U : 0U;
+  view.tick = state.numberOfMoves;
+}
+
+
+bool BotPlugins::Decide(size_t const player, Simulation::Direction & direction)
+{
+  Controller & controller = controllers[player];
+  if ((controller.library == NO_LIBRARY) || controller.demoted)
+  {
+    return false;
+  }
+
+  // A decision can't be interrupted, the tick waits for it until the deadline and goes on without it
+  std::chrono::steady_clock::time_point const begin = std::chrono::steady_clock::now();
+  Worker & worker = *controller.pWorker;
+  bool answered = false;
+  int32_t decision = -1;
+  {
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    // Still busy with an earlier tick, its view stays untouched until it answers
+    if (worker.answers == worker.requests)
+    {
+      worker.snakes.assign(snakes.begin(), snakes.end());
+      worker.view = view;
+      worker.view.snakes = worker.snakes.data();
+      ++worker.requests;
+      worker.requestCondition.notify_one();
+      answered = worker.answerCondition.wait_until(lock, begin + std::chrono::nanoseconds(deadline_ns),
+                                                   [&worker](){ return worker.answers == worker.requests; });
+      decision = worker.decision;
+    }
+  }
+  uint64_t const duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+  ++controller.calls;
+  controller.total_ns += duration_ns;
+  controller.max_ns = std::max(controller.max_ns, duration_ns);
+  if (!answered || (duration_ns > deadline_ns))
+  {
+    controller.demoted = (++controller.overruns >= MAX_OVERRUNS);
+    if (controller.demoted)
+    {
+      std::cerr << "Bot " << libraries[controller.library].path << " for player " << (player + 1UL)
+                << " was late " << MAX_OVERRUNS << " times and is demoted\n";
+    }
+    return false;
+  }
+
+  // Reversing is never allowed, the snake keeps its direction then like for unknown decisions
+  Simulation::Direction const current = static_cast<Simulation::Direction>(snakes[player].direction);
+  bool const valid = (decision >= SNAKE_BOT_UP) && (decision <= SNAKE_BOT_RIGHT)
+                  && ((static_cast<uint32_t>(decision) ^ 1U) != static_cast<uint32_t>(current));
+  direction = valid ? static_cast<Simulation::Direction>(decision) : current;
+  return true;
+}
+
+
+bool BotPlugins::Controls(size_t const player) const
+{
+  return (controllers[player].library != NO_LIBRARY);
+}
+
+
+size_t BotPlugins::Load(std::string const & path)
+{
+  // Players sharing a library share its handle, each gets an own context
+  for (size_t library = 0UL; library < libraries.size(); ++library)
+  {
+    if (libraries[library].path == path)
+    {
+      return library;
+    }
+  }
+
+#ifdef _WIN32
+  void* const pHandle = reinterpret_cast<void*>(LoadLibraryA(path.c_str()));
+#else
+  void* const pHandle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+  if (pHandle == nullptr)
+  {
+    throw std::runtime_error("BotPlugins::Load: " + path + " could not be loaded.");
+  }
+
+  AbiVersionFunction const abiVersion = reinterpret_cast<AbiVersionFunction>(FindSymbol(pHandle, "snake_bot_abi_version"));
+  Library const library = {
+    path,
+    pHandle,
+    reinterpret_cast<CreateFunction>(FindSymbol(pHandle, "snake_bot_create")),
+    reinterpret_cast<DecideFunction>(FindSymbol(pHandle, "snake_bot_decide")),
+    reinterpret_cast<DestroyFunction>(FindSymbol(pHandle, "snake_bot_destroy"))
+  };
+  if ((abiVersion == nullptr) || (library.create == nullptr) || (library.decide == nullptr) || (library.destroy == nullptr))
+  {
+    throw std::runtime_error("BotPlugins::Load: " + path + " is no bot plugin.");
+  }
+  if (abiVersion() != SNAKE_BOT_ABI_VERSION)
+  {
+    throw std::runtime_error("BotPlugins::Load: " + path + " was built for another bot interface version.");
+  }
+
+  libraries.push_back(library);
+  return libraries.size() - 1UL;
+}
+
+
+void BotPlugins::RunWorker(std::shared_ptr<Worker> const pWorker)
+{
+  Worker & worker = *pWorker;
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  for (;;)
+  {
+    worker.requestCondition.wait(lock, [&worker](){ return worker.stop || (worker.answers != worker.requests); });
+    if (worker.answers == worker.requests)
+    {
+      return;
+    }
+
+    // The view is not touched by the host while the request is open, the lock is only needed for the answer
+    lock.unlock();
+    int32_t const decision = worker.decide(worker.pContext, &worker.view, worker.player);
+    lock.lock();
+    worker.decision = decision;
+    ++worker.answers;
+    worker.answerCondition.notify_one();
+  }
+}
+
+
+void* BotPlugins::FindSymbol(void* const pHandle, char const * const pName)
+{
+#ifdef _WIN32
+  return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(pHandle), pName));
+#else
+  return dlsym(pHandle, pName);
+#endif
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "BotPluginApi.h"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bots from shared libraries, each tick they see the simulation through a view without copies
+class BotPlugins
+{
+public:
+  BotPlugins(std::vector<Options::BotPlugin> const & plugins, uint32_t const deadline_us);
+  ~BotPlugins(void);
+
+  // Points the view at the current state, has to be called each tick before the decisions
+  void BeginTick(Simulation const & simulation);
+  // False for players without plugin, demoted plugins and late decisions, never waits longer than the deadline
+  bool Decide(size_t const player, Simulation::Direction & direction);
+  // True for players given a plugin, even once it is demoted
+  bool Controls(size_t const player) const;
+
+private:
+  // Decisions later than the deadline are ignored, a plugin is demoted after this many
+  static uint32_t constexpr MAX_OVERRUNS = 3U;
+
+  typedef uint32_t (*AbiVersionFunction)(void);
+  typedef void* (*CreateFunction)(uint32_t);
+  typedef int32_t (*DecideFunction)(void*, SnakeBotView const *, uint32_t);
+  typedef void (*DestroyFunction)(void*);
+
+  struct Library
+  {
+    std::string path;
+    void* pHandle;
+    CreateFunction create;
+    DecideFunction decide;
+    DestroyFunction destroy;
+  };
+
+  // Every plugin player decides on an own thread, so a plugin which never returns can't stop the game
+  struct Worker
+  {
+    std::mutex mutex;
+    std::condition_variable requestCondition;
+    std::condition_variable answerCondition;
+    DecideFunction decide;
+    void* pContext;
+    uint32_t player;
+    // The worker's copy of the view, only rewritten once the previous request is answered
+    std::vector<SnakeBotSnake> snakes;
+    SnakeBotView view;
+    uint64_t requests;
+    uint64_t answers;
+    int32_t decision;
+    bool stop;
+  };
+
+  static size_t constexpr NO_LIBRARY = static_cast<size_t>(-1);
+
+  struct Controller
+  {
+    // Index into the libraries, none for players without plugin
+    size_t library = NO_LIBRARY;
+    // Shared with the thread, which keeps it alive when it has to be left behind
+    std::shared_ptr<Worker> pWorker;
+    std::thread thread;
+    bool demoted = false;
+    uint64_t calls = 0UL;
+    uint64_t total_ns = 0UL;
+    uint64_t max_ns = 0UL;
+    uint32_t overruns = 0U;
+  };
+
+  uint64_t deadline_ns;
+  std::vector<Library> libraries;
+  std::vector<Controller> controllers;
+  std::vector<SnakeBotSnake> snakes;
+  SnakeBotView view;
+
+  size_t Load(std::string const & path);
+  static void* FindSymbol(void* const pHandle, char const * const pName);
+  static void RunWorker(std::shared_ptr<Worker> const pWorker);
+};
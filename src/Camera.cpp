@@ -0,0 +1,117 @@
+#include "Camera.hpp"
+#include "Position.hpp"
+#include <algorithm>
+
+Camera::Camera(Position const & boardSize)
+: boardSize(boardSize)
+, viewportPosition{ 0, 0 }
+, viewportScale{ 0, 0 }
+, minCellScale{ MIN_CELL_PIXELS, MIN_CELL_PIXELS }
+, cellScale{ MIN_CELL_PIXELS, MIN_CELL_PIXELS }
+, visibleCells{ 0, 0 }
+, origin{ 0, 0 }
+, following(true)
+{
+}
+
+
+void Camera::SetViewport(Position const & position, Position const & scale)
+{
+  // Boards which fit fill the field as before, zooming out never goes beyond that
+  viewportPosition = position;
+  viewportScale = scale;
+  minCellScale = { std::max(scale.x / boardSize.x, MIN_CELL_PIXELS), std::max(scale.y / boardSize.y, MIN_CELL_PIXELS) };
+  cellScale = minCellScale;
+  Zoom(0);
+}
+
+
+void Camera::Zoom(int const steps)
+{
+  Position const center = { origin.x + visibleCells.x / 2, origin.y + visibleCells.y / 2 };
+
+  for (int step = 0; step < steps; ++step)
+  {
+    if (std::max(cellScale.x, cellScale.y) * 2 > MAX_CELL_PIXELS)
+    {
+      break;
+    }
+    cellScale = { cellScale.x * 2, cellScale.y * 2 };
+  }
+  for (int step = 0; step > steps; --step)
+  {
+    cellScale = { std::max(cellScale.x / 2, minCellScale.x), std::max(cellScale.y / 2, minCellScale.y) };
+  }
+
+  visibleCells = { std::min(std::max(viewportScale.x / cellScale.x, 1), boardSize.x),
+                   std::min(std::max(viewportScale.y / cellScale.y, 1), boardSize.y) };
+  CenterOn(center);
+}
+
+
+void Camera::Follow(Position const & cell)
+{
+  if (following)
+  {
+    CenterOn(cell);
+  }
+}
+
+
+void Camera::LookAt(Position const & screenPosition)
+{
+  following = false;
+  CenterOn({ origin.x + (screenPosition.x - viewportPosition.x) / cellScale.x,
+             origin.y + (screenPosition.y - viewportPosition.y) / cellScale.y });
+}
+
+
+void Camera::SetFollowing(bool const follow)
+{
+  following = follow;
+}
+
+
+bool Camera::IsOnViewport(Position const & screenPosition) const
+{
+  return (screenPosition.x >= viewportPosition.x) && (screenPosition.x < viewportPosition.x + visibleCells.x * cellScale.x)
+      && (screenPosition.y >= viewportPosition.y) && (screenPosition.y < viewportPosition.y + visibleCells.y * cellScale.y);
+}
+
+
+Position Camera::CellToScreen(Position const & cell) const
+{
+  return { viewportPosition.x + (cell.x - origin.x) * cellScale.x,
+           viewportPosition.y + (cell.y - origin.y) * cellScale.y };
+}
+
+
+Position Camera::GetCellScale(void) const
+{
+  return cellScale;
+}
+
+
+Position Camera::GetFirstVisibleCell(void) const
+{
+  return origin;
+}
+
+
+Position Camera::GetEndVisibleCell(void) const
+{
+  return { origin.x + visibleCells.x, origin.y + visibleCells.y };
+}
+
+
+Position Camera::GetViewportScale(void) const
+{
+  return { visibleCells.x * cellScale.x, visibleCells.y * cellScale.y };
+}
+
+
+void Camera::CenterOn(Position const & cell)
+{
+  origin = { std::min(std::max(cell.x - visibleCells.x / 2, 0), boardSize.x - visibleCells.x),
+             std::min(std::max(cell.y - visibleCells.y / 2, 0), boardSize.y - visibleCells.y) };
+}
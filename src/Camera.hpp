@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Position.hpp"
+
+// Window of the board shown in the field, whole cells only so nothing is drawn beyond the field
+class Camera
+{
+public:
+  Camera(Position const & boardSize);
+
+  void SetViewport(Position const & position, Position const & scale);
+  void Zoom(int const steps);
+  void Follow(Position const & cell);
+  void LookAt(Position const & screenPosition);
+  void SetFollowing(bool const follow);
+
+  bool IsOnViewport(Position const & screenPosition) const;
+  Position CellToScreen(Position const & cell) const;
+  Position GetCellScale(void) const;
+  Position GetFirstVisibleCell(void) const;
+  Position GetEndVisibleCell(void) const;
+  Position GetViewportScale(void) const;
+
+private:
+  // Boards larger than the field are shown with cells of readable size
+  static int constexpr MIN_CELL_PIXELS = 8;
+  static int constexpr MAX_CELL_PIXELS = 128;
+
+  Position boardSize;
+  Position viewportPosition;
+  Position viewportScale;
+  Position minCellScale;
+  Position cellScale;
+  Position visibleCells;
+  Position origin;
+  bool following;
+
+  void CenterOn(Position const & cell);
+};
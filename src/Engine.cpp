@@ -1,19 +1,35 @@
 #include "Engine.hpp"
+#include "AudioMixer.hpp"
 #include "Entity.hpp"
+#include "FrameCapture.hpp"
+#include "Metrics.hpp"
 #include "Position.hpp"
+#include "RenderBackend.hpp"
+#include "SdlRenderBackend.hpp"
+#include "SoftwareRenderBackend.hpp"
 
 #include <SDL_error.h>
 #include <SDL_image.h>
 #include <SDL_render.h>
 #include <SDL_ttf.h>
-#include <SDL_mixer.h>
 #include <SDL_video.h>
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
 
-Engine::Engine(char const * const pWindowName, Position const & res)
+static size_t constexpr FRAME_ARENA_CAPACITY = 64UL * 1024UL;
+
+Engine::Engine(char const * const pWindowName, Position const & res, bool const softwareRenderer,
+               int const audioBufferSamples)
 : pWindow(nullptr)
-, pRenderer(nullptr)
+, frameArena(FRAME_ARENA_CAPACITY)
+, pBackend()
 , resolution(res)
+, pCapture(nullptr)
+, pAudio()
+, drawCalls(0UL)
+, numberOfTextures(0UL)
+, rasterizedTexts(0UL)
 {
   // Initialize SDL
   if (SDL_Init(SDL_INIT_VIDEO) < 0)
@@ -34,7 +50,7 @@ Engine::Engine(char const * const pWindowName, Position const & res)
                             SDL_WINDOWPOS_UNDEFINED,
                             resolution.x,
                             resolution.y,
-                            (resolution == Position{ 0, 0 }) ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
+                            (resolution == Position{ 0, 0 }) ? SDL_WINDOW_FULLSCREEN_DESKTOP : SDL_WINDOW_RESIZABLE);
   if (pWindow == nullptr)
     throw std::runtime_error("Game::Game: Window could not be created.");
 
@@ -45,20 +61,27 @@ Engine::Engine(char const * const pWindowName, Position const & res)
     resolution = Position{ mode.w, mode.h };
   }
 
-  // Create renderer
-  pRenderer = SDL_CreateRenderer(pWindow, -1, SDL_RENDERER_ACCELERATED);
-  if (pRenderer == nullptr)
-    throw std::runtime_error("Game::Game: Renderer could not be created.");
+  // Create renderer, the software one renders tiles on all cores
+  if (softwareRenderer)
+  {
+    pBackend.reset(new SoftwareRenderBackend(pWindow, resolution, std::max(std::thread::hardware_concurrency(), 1U)));
+  }
+  else
+  {
+    pBackend.reset(new SdlRenderBackend(pWindow, resolution, frameArena));
+  }
 
-  if (Mix_OpenAudio(48000, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
-    throw std::runtime_error("Game::Game: Audio could not be opened.");
+  pAudio.reset(new AudioMixer(audioBufferSamples));
 }
 
 
 Engine::~Engine(void)
 {
+  // Close audio
+  pAudio.reset();
+
   // Destroy renderer
-  SDL_DestroyRenderer(pRenderer);
+  pBackend.reset();
 
   // Destroy window
   SDL_DestroyWindow(pWindow);
@@ -71,9 +94,12 @@ Engine::~Engine(void)
 }
 
 
-SDL_Texture* Engine::CreatePicTexture(char const * const pFile)
+Texture* Engine::CreatePicTexture(char const * const pFile)
 {
-  SDL_Texture* pTexture = IMG_LoadTexture(pRenderer, pFile);
+  SDL_Surface* pSurface = IMG_Load(pFile);
+  Texture* pTexture = pBackend->CreateTexture(pSurface);
+  SDL_FreeSurface(pSurface);
+  numberOfTextures += (pTexture != nullptr) ? 1UL : 0UL;
   if (pTexture == nullptr)
     throw std::runtime_error("Engine::CreatePicTexture: Failed to load.");
 
@@ -81,18 +107,39 @@ SDL_Texture* Engine::CreatePicTexture(char const * const pFile)
 }
 
 
-SDL_Texture* Engine::CreateTextTexture(char const * const pText, TTF_Font* const font, SDL_Color const textColor)
+Texture* Engine::CreateTextTexture(char const * const pText, TTF_Font* const font, SDL_Color const textColor)
 {
   SDL_Surface* pSurface = TTF_RenderText_Blended( font, pText, textColor);
-  SDL_Texture* pTexture = SDL_CreateTextureFromSurface(pRenderer, pSurface);
+  ++rasterizedTexts;
+  Texture* pTexture = pBackend->CreateTexture(pSurface);
+  SDL_FreeSurface(pSurface);
+  numberOfTextures += (pTexture != nullptr) ? 1UL : 0UL;
+  return pTexture;
+}
+
+
+Texture* Engine::CreatePixelTexture(uint32_t const * const pPixels, Position const & size)
+{
+  // ABGR8888 pixels, the surface only borrows them
+  SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint32_t*>(pPixels), size.x, size.y, 32,
+                                                             size.x * 4, SDL_PIXELFORMAT_ABGR8888);
+  Texture* pTexture = pBackend->CreateTexture(pSurface);
   SDL_FreeSurface(pSurface);
+  numberOfTextures += (pTexture != nullptr) ? 1UL : 0UL;
   return pTexture;
 }
 
 
-void Engine::DestroyTexture(SDL_Texture* pTexture)
+void Engine::UpdatePixelTexture(Texture* const pTexture, uint32_t const * const pPixels)
 {
-  SDL_DestroyTexture(pTexture);
+  pBackend->UpdateTexture(pTexture, pPixels);
+}
+
+
+void Engine::DestroyTexture(Texture* pTexture)
+{
+  numberOfTextures -= (pTexture != nullptr) ? 1UL : 0UL;
+  pBackend->DestroyTexture(pTexture);
 }
 
 
@@ -116,46 +163,21 @@ void Engine::DestroyFont(TTF_Font* pFont)
 
 void Engine::Clean(SDL_Color const & color)
 {
-  // Initialize renderer color blue for the background
-  SDL_SetRenderDrawColor(pRenderer, color.r, color.g, color.b, 255U);
-  // Clear screen
-  SDL_RenderClear(pRenderer);
+  pBackend->Clean(color);
 }
 
 
 void Engine::Render(Entity const & entity)
 {
-  SDL_Rect src = {
-    .x = 0,
-    .y = 0,
-    .w = entity.GetTextureSize().x,
-    .h = entity.GetTextureSize().y
-   };
-
-  SDL_Rect dst = {
-    .x = entity.GetPosition().x,
-    .y = entity.GetPosition().y,
-    .w = entity.GetScale().x,
-    .h = entity.GetScale().y
-  };
-
-  SDL_RenderCopyEx(pRenderer, entity.GetTexture(), &src, &dst, entity.GetAngle(), nullptr, SDL_FLIP_NONE);
+  pBackend->Copy(entity.GetTexture(), entity.GetPosition(), entity.GetScale(), entity.GetAngle());
+  ++drawCalls;
 }
 
 
-void Engine::Render(Position const & position, Position const & scale, SDL_Texture* const pTexture, double angle)
+void Engine::Render(Position const & position, Position const & scale, Texture* const pTexture, double angle)
 {
-  SDL_Rect src = { 0 };
-  SDL_QueryTexture(pTexture, nullptr, nullptr, &src.w, &src.h);
-
-  SDL_Rect dst = {
-    .x = position.x,
-    .y = position.y,
-    .w = scale.x,
-    .h = scale.y
-  };
-
-  SDL_RenderCopyEx(pRenderer, pTexture, &src, &dst, angle, nullptr, SDL_FLIP_NONE);
+  pBackend->Copy(pTexture, position, scale, angle);
+  ++drawCalls;
 }
 
 
@@ -164,48 +186,118 @@ void Engine::RenderText(Position const & position,
                         TTF_Font* const pFont,
                         SDL_Color const & textColor)
 {
-  SDL_Texture* pTexture = CreateTextTexture(pText, pFont, textColor);
-  Position scale = { 0 };
-  SDL_QueryTexture(pTexture, nullptr, nullptr, &scale.x, &scale.y);
-  Render(position, scale, pTexture);
-  SDL_DestroyTexture(pTexture);
+  Texture* pTexture = CreateTextTexture(pText, pFont, textColor);
+  if (pTexture != nullptr)
+  {
+    Render(position, pTexture->size, pTexture);
+  }
+  DestroyTexture(pTexture);
 }
 
 
 void Engine::RenderRect(Position const position, Position const scale, SDL_Color const & color)
 {
-  SDL_SetRenderDrawColor(pRenderer, color.r, color.g, color.b, 255U);
-  SDL_Rect const rectangle = {
-    .x = position.x,
-    .y = position.y,
-    .w = scale.x,
-    .h = scale.y
-  };
-  SDL_RenderFillRect(pRenderer, &rectangle);
+  pBackend->FillRect(position, scale, color);
+  ++drawCalls;
 }
 
 
-void Engine::RenderGeometry(std::vector<Position> const & positions, SDL_Color const & color)
+void Engine::RenderGeometry(Position const * const pPositions, size_t const count, SDL_Color const & color)
 {
-  std::vector<SDL_Vertex> verts(positions.size());
-  for (Position const & position : positions)
-  {
-    verts.push_back(SDL_Vertex{ SDL_FPoint{ static_cast<float>(position.x), static_cast<float>(position.y) },
-                                color,
-                                SDL_FPoint{ 0 } });
-  }
+  pBackend->FillTriangles(pPositions, count, color);
+  ++drawCalls;
+}
+
 
-  SDL_RenderGeometry( pRenderer, nullptr, verts.data(), verts.size(), nullptr, 0 );
+void Engine::RenderColoredGeometry(Position const * const pPositions, SDL_Color const * const pColors, size_t const count)
+{
+  pBackend->FillColoredTriangles(pPositions, pColors, count);
+  ++drawCalls;
 }
 
 
 void Engine::UpdateScreen(void)
 {
-  SDL_RenderPresent(pRenderer);
+  pBackend->Present();
+
+  if (pCapture != nullptr)
+  {
+    ReadCapture(false);
+  }
+
+  frameArena.Reset();
+
+  Metrics::Add(Metrics::Counter::DrawCalls, drawCalls);
+  drawCalls = 0UL;
 }
 
 
 Position Engine::GetResolution(void) const
 {
   return resolution;
-}
\ No newline at end of file
+}
+
+
+void Engine::SetResolution(Position const & res)
+{
+  FinishCapture();
+  resolution = res;
+  pBackend->Resize(res);
+}
+
+
+void Engine::EnableCapture(FrameCapture* const pFrameCapture)
+{
+  pCapture = pFrameCapture;
+  pBackend->EnableCapture();
+}
+
+
+void Engine::FinishCapture(void)
+{
+  if (pCapture != nullptr)
+  {
+    ReadCapture(true);
+  }
+}
+
+
+size_t Engine::GetNumberOfTextures(void) const
+{
+  return numberOfTextures;
+}
+
+
+uint64_t Engine::GetNumberOfRasterizedTexts(void) const
+{
+  return rasterizedTexts;
+}
+
+
+FrameArena & Engine::GetFrameArena(void)
+{
+  return frameArena;
+}
+
+
+AudioMixer & Engine::GetAudio(void)
+{
+  return *pAudio;
+}
+
+
+void Engine::ReadCapture(bool const finish)
+{
+  while (pBackend->HasCapturedFrame(finish))
+  {
+    // The render loop checks for a free buffer before drawing, so there is one
+    FrameCapture::Frame* const pFrame = pCapture->Acquire(resolution);
+    if (pFrame == nullptr)
+    {
+      return;
+    }
+
+    pBackend->ReadCapturedFrame(pFrame->pixels.data());
+    pCapture->Submit(pFrame);
+  }
+}
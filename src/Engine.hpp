@@ -1,41 +1,70 @@
 #pragma once
 
+#include "FrameArena.hpp"
 #include "Position.hpp"
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
 typedef struct SDL_Window SDL_Window;
-typedef struct SDL_Renderer SDL_Renderer;
-typedef struct SDL_Texture SDL_Texture;
 typedef struct SDL_Color SDL_Color;
 typedef struct _TTF_Font TTF_Font;
 
+class AudioMixer;
 class Entity;
+class FrameCapture;
+class RenderBackend;
+struct Texture;
 
 class Engine
 {
 public:
-  Engine(char const * const pWindowName = "", Position const & res = { 0, 0 });
+  Engine(char const * const pWindowName = "", Position const & res = { 0, 0 }, bool const softwareRenderer = false,
+         int const audioBufferSamples = 0);
   ~Engine(void);
 
-  SDL_Texture* CreatePicTexture(char const * const pFile);
-  SDL_Texture* CreateTextTexture(char const * const pText, TTF_Font* const font, SDL_Color const textColor);
-  void DestroyTexture(SDL_Texture* const pTexture);
+  Texture* CreatePicTexture(char const * const pFile);
+  Texture* CreateTextTexture(char const * const pText, TTF_Font* const font, SDL_Color const textColor);
+  Texture* CreatePixelTexture(uint32_t const * const pPixels, Position const & size);
+  // Same size and format as on creation, the texture is kept and only its pixels are replaced
+  void UpdatePixelTexture(Texture* const pTexture, uint32_t const * const pPixels);
+  void DestroyTexture(Texture* const pTexture);
   TTF_Font* CreateFont(char const * const pFile, int const size);
   void DestroyFont(TTF_Font* pFont);
   void Clean(SDL_Color const & color);
   void Render(Entity const & entity);
-  void Render(Position const & position, Position const & scale, SDL_Texture* const pTexture, double const angle = 0.0);
+  void Render(Position const & position, Position const & scale, Texture* const pTexture, double const angle = 0.0);
   void RenderText(Position const & position,
                   char const * const pText,
                   TTF_Font* const pFont,
                   SDL_Color const & textColor);
   void RenderRect(Position const position, Position const scale, SDL_Color const & color);
-  void RenderGeometry(std::vector<Position> const & positions, SDL_Color const & color);
+  void RenderGeometry(Position const * const pPositions, size_t const count, SDL_Color const & color);
+  void RenderColoredGeometry(Position const * const pPositions, SDL_Color const * const pColors, size_t const count);
   void UpdateScreen(void);
   Position GetResolution(void) const;
+  void SetResolution(Position const & res);
+  void EnableCapture(FrameCapture* const pFrameCapture);
+  void FinishCapture(void);
+  size_t GetNumberOfTextures(void) const;
+  // Texts rasterized so far, each one allocates its surface
+  uint64_t GetNumberOfRasterizedTexts(void) const;
+  FrameArena & GetFrameArena(void);
+  AudioMixer & GetAudio(void);
 
 private:
   SDL_Window* pWindow;
-  SDL_Renderer* pRenderer;
+  // Temporaries of the frame being drawn, reset on every screen update
+  FrameArena frameArena;
+  std::unique_ptr<RenderBackend> pBackend;
   Position resolution;
+  FrameCapture* pCapture;
+  std::unique_ptr<AudioMixer> pAudio;
+  // Counted per frame, published to the metrics once per screen update
+  uint64_t drawCalls;
+  // Textures created and not destroyed yet
+  size_t numberOfTextures;
+  uint64_t rasterizedTexts;
+
+  void ReadCapture(bool const finish);
 };
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "Entity.hpp"
-#include <SDL_render.h>
+#include "RenderBackend.hpp"
 
-Entity::Entity(SDL_Texture* const pTexture,
+Entity::Entity(Texture* const pTexture,
                Position const & position,
                Position const & scale,
                double const angle)
@@ -11,13 +11,14 @@ Entity::Entity(SDL_Texture* const pTexture,
 , scale_(scale)
 , angle_(angle)
 {
-  SDL_QueryTexture(pTexture, nullptr, nullptr, &textureSize.x, &textureSize.y);
+  if (pTexture != nullptr)
+    textureSize = pTexture->size;
   if (scale == Position{ 0, 0 })
     scale_ = textureSize;
 }
 
 
-SDL_Texture* Entity::GetTexture(void) const
+Texture* Entity::GetTexture(void) const
 {
   return pTexture_;
 }
@@ -47,10 +48,10 @@ double Entity::GetAngle(void) const
 }
 
 
-void Entity::SetTexture(SDL_Texture* const pTexture)
+void Entity::SetTexture(Texture* const pTexture)
 {
   pTexture_ = pTexture;
-  SDL_QueryTexture(pTexture, nullptr, nullptr, &textureSize.x, &textureSize.y);
+  textureSize = (pTexture != nullptr) ? pTexture->size : Position{ 0, 0 };
 }
 
 
@@ -0,0 +1,44 @@
+#include "FrameArena.hpp"
+
+FrameArena::FrameArena(size_t const capacity)
+: memory(capacity)
+, used(0UL)
+, overflowBlocks()
+, overflowBytes(0UL)
+{
+}
+
+
+void FrameArena::Reset(void)
+{
+  if (!overflowBlocks.empty())
+  {
+    // Grow once, so the following frames fit again
+    memory.resize((memory.size() + overflowBytes) * 2UL);
+    overflowBlocks.clear();
+    overflowBytes = 0UL;
+  }
+  used = 0UL;
+}
+
+
+size_t FrameArena::GetCapacity(void) const
+{
+  return memory.size();
+}
+
+
+void* FrameArena::Allocate(size_t const bytes, size_t const alignment)
+{
+  size_t const offset = (used + alignment - 1UL) & ~(alignment - 1UL);
+  if ((offset + bytes) > memory.size())
+  {
+    // Heap blocks are aligned for any type
+    overflowBlocks.emplace_back(new uint8_t[bytes]);
+    overflowBytes += bytes;
+    return overflowBlocks.back().get();
+  }
+
+  used = offset + bytes;
+  return memory.data() + offset;
+}
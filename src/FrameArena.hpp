@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for the temporaries of one frame, everything is released at once by Reset
+class FrameArena
+{
+public:
+  FrameArena(size_t const capacity);
+  ~FrameArena(void) = default;
+
+  template <typename T>
+  T* Allocate(size_t const count)
+  {
+    static_assert(std::is_trivially_destructible<T>::value, "Frame arena memory is never destructed");
+    return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void Reset(void);
+  size_t GetCapacity(void) const;
+
+private:
+  std::vector<uint8_t> memory;
+  size_t used;
+
+  // Frames which needed more get heap blocks, the next frame starts with a larger arena
+  std::vector<std::unique_ptr<uint8_t[]>> overflowBlocks;
+  size_t overflowBytes;
+
+  void* Allocate(size_t const bytes, size_t const alignment);
+};
@@ -0,0 +1,187 @@
+#include "FrameCapture.hpp"
+#include <SDL_image.h>
+#include <SDL_surface.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+FrameCapture::FrameCapture(std::string const & output, size_t const numberOfWorkers, size_t const numberOfBuffers)
+: directory(output)
+, pStream(nullptr)
+, pCoutBuffer(nullptr)
+, frames(std::max(numberOfBuffers, 2UL))
+, framesMutex()
+, framesCondition()
+, freeFrames()
+, pendingFrames(frames.size(), nullptr)
+, pendingHead(0UL)
+, pendingCount(0UL)
+, nextFrameNumber(0UL)
+, stopWorkers(false)
+, workers()
+, writtenFrames(0UL)
+, failedFrames(0UL)
+, stalls(0UL)
+, encodeTime_us(0UL)
+{
+  size_t workerCount = std::max(numberOfWorkers, 1UL);
+  if (output == "-")
+  {
+    // Stdout belongs to the frames now, so the game's messages go to stderr
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+    pStream = _fdopen(_dup(_fileno(stdout)), "wb");
+#else
+    pStream = fdopen(dup(fileno(stdout)), "wb");
+#endif
+    if (pStream == nullptr)
+      throw std::runtime_error("FrameCapture::FrameCapture: Stdout could not be opened.");
+    pCoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    // A stream is written in order, there is nothing to encode in parallel
+    workerCount = 1UL;
+  }
+
+  for (Frame & frame : frames)
+  {
+    freeFrames.push_back(&frame);
+  }
+
+  for (size_t i = 0UL; i < workerCount; ++i)
+  {
+    workers.emplace_back(&FrameCapture::RunWorker, this);
+  }
+}
+
+
+FrameCapture::~FrameCapture(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(framesMutex);
+    stopWorkers = true;
+  }
+  framesCondition.notify_all();
+
+  // Captured frames are written before leaving
+  for (std::thread & worker : workers)
+  {
+    worker.join();
+  }
+
+  if (pStream != nullptr)
+  {
+    fclose(pStream);
+    std::cout.rdbuf(pCoutBuffer);
+  }
+
+  std::cerr << "capture: " << writtenFrames << " frames written, " << failedFrames << " failed, "
+            << stalls << " stalls, avg "
+            << ((writtenFrames > 0UL) ? encodeTime_us / writtenFrames : 0UL) << " us per frame\n";
+}
+
+
+FrameCapture::Frame* FrameCapture::Acquire(Position const & size)
+{
+  Frame* pFrame = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(framesMutex);
+    if (freeFrames.empty())
+    {
+      return nullptr;
+    }
+    pFrame = freeFrames.back();
+    freeFrames.pop_back();
+    pFrame->number = nextFrameNumber++;
+  }
+
+  // Buffers keep their memory, so after the first frames there are no allocations
+  pFrame->size = size;
+  pFrame->pixels.resize(static_cast<size_t>(size.x) * size.y * 4UL);
+  return pFrame;
+}
+
+
+void FrameCapture::Submit(Frame* const pFrame)
+{
+  {
+    std::lock_guard<std::mutex> lock(framesMutex);
+    pendingFrames[(pendingHead + pendingCount) % pendingFrames.size()] = pFrame;
+    ++pendingCount;
+  }
+  framesCondition.notify_one();
+}
+
+
+bool FrameCapture::HasFreeBuffer(void)
+{
+  std::lock_guard<std::mutex> lock(framesMutex);
+  if (freeFrames.empty())
+  {
+    ++stalls;
+    return false;
+  }
+  return true;
+}
+
+
+void FrameCapture::RunWorker(void)
+{
+  std::unique_lock<std::mutex> lock(framesMutex);
+  while (true)
+  {
+    framesCondition.wait(lock, [this]{ return stopWorkers || (pendingCount > 0UL); });
+    if (pendingCount == 0UL)
+    {
+      break;
+    }
+
+    Frame* const pFrame = pendingFrames[pendingHead];
+    pendingHead = (pendingHead + 1UL) % pendingFrames.size();
+    --pendingCount;
+    lock.unlock();
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    bool const written = Write(*pFrame);
+    uint64_t const duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - start).count();
+
+    lock.lock();
+    written ? ++writtenFrames : ++failedFrames;
+    encodeTime_us += written ? duration_us : 0UL;
+    freeFrames.push_back(pFrame);
+  }
+}
+
+
+bool FrameCapture::Write(Frame const & frame)
+{
+  if (pStream != nullptr)
+  {
+    return fwrite(frame.pixels.data(), 1UL, frame.pixels.size(), pStream) == frame.pixels.size();
+  }
+
+  SDL_Surface* const pSurface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint8_t*>(frame.pixels.data()),
+                                                                   frame.size.x,
+                                                                   frame.size.y,
+                                                                   32,
+                                                                   frame.size.x * 4,
+                                                                   SDL_PIXELFORMAT_RGBA32);
+  if (pSurface == nullptr)
+  {
+    return false;
+  }
+
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "/frame%06llu.png", static_cast<unsigned long long>(frame.number));
+  bool const saved = IMG_SavePNG(pSurface, (directory + fileName).c_str()) == 0;
+  SDL_FreeSurface(pSurface);
+  return saved;
+}
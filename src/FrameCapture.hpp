@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Position.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FrameCapture
+{
+public:
+  struct Frame
+  {
+    std::vector<uint8_t> pixels;
+    Position size;
+    uint64_t number;
+  };
+
+  // Output "-" streams raw RGBA frames to stdout, any other output is the directory of a PNG sequence
+  FrameCapture(std::string const & output, size_t const numberOfWorkers, size_t const numberOfBuffers);
+  ~FrameCapture(void);
+
+  Frame* Acquire(Position const & size);
+  void Submit(Frame* const pFrame);
+  bool HasFreeBuffer(void);
+
+private:
+  std::string directory;
+  FILE* pStream;
+  std::streambuf* pCoutBuffer;
+
+  // Frame buffers are recycled, their number bounds the frames in flight
+  std::vector<Frame> frames;
+  std::mutex framesMutex;
+  std::condition_variable framesCondition;
+  std::vector<Frame*> freeFrames;
+  // Ring of submitted frames, never more than there are buffers
+  std::vector<Frame*> pendingFrames;
+  size_t pendingHead;
+  size_t pendingCount;
+  uint64_t nextFrameNumber;
+  bool stopWorkers;
+  std::vector<std::thread> workers;
+
+  // Statistics, guarded by framesMutex
+  uint64_t writtenFrames;
+  uint64_t failedFrames;
+  uint64_t stalls;
+  uint64_t encodeTime_us;
+
+  void RunWorker(void);
+  bool Write(Frame const & frame);
+};
@@ -1,97 +1,220 @@
 #include "Game.hpp"
+#include "Bot.hpp"
+#include "BotPlugins.hpp"
 #include "Engine.hpp"
 #include "Entity.hpp"
+#include "AllocationCounter.hpp"
+#include "AllocationSelftest.hpp"
+#include "AudioMixer.hpp"
+#include "Camera.hpp"
+#include "FrameCapture.hpp"
+#include "LatencyTracer.hpp"
+#include "Metrics.hpp"
+#include "NetLink.hpp"
+#include "Options.hpp"
 #include "Position.hpp"
+#include "RollbackSession.hpp"
+#include "Simulation.hpp"
+#include "Soak.hpp"
+#include "SpectatorFeed.hpp"
 #include "version.hpp"
 #include <SDL.h>
 #include <SDL_mixer.h>
 #include <algorithm>
+#include <cstdio>
 #include <ctime>
-#include <fstream>
 #include <iostream>
+#include <thread>
+
+// Soak keys per player, in the order of Simulation::Direction
+static SDL_Keycode constexpr SOAK_STEERING_KEYS[2][4] = {
+  { SDLK_UP, SDLK_DOWN, SDLK_LEFT, SDLK_RIGHT },
+  { SDLK_w, SDLK_s, SDLK_a, SDLK_d }
+};
+static SDL_Keycode constexpr SOAK_SCRUB_KEYS[] = { SDLK_HOME, SDLK_PAGEDOWN, SDLK_RIGHT, SDLK_LEFT, SDLK_END };
+static char constexpr SOAK_NAME[] = "Soak";
+
+// Scripted input goes through the event queue like a player's
+static void PushKey(SDL_Keycode const key)
+{
+  SDL_Event event = {};
+  event.type = SDL_KEYDOWN;
+  event.key.keysym.sym = key;
+  (void)SDL_PushEvent(&event);
+}
+
+
+static void PushText(char const character)
+{
+  SDL_Event event = {};
+  event.type = SDL_TEXTINPUT;
+  event.text.text[0] = character;
+  (void)SDL_PushEvent(&event);
+}
+
 
-Game::Game(Position const & res)
-: engine("Ben's Snake Game", res)
+static void PushClick(Entity const & entity)
+{
+  SDL_Event event = {};
+  event.type = SDL_MOUSEBUTTONDOWN;
+  event.button.x = entity.GetPosition().x + entity.GetScale().x / 2;
+  event.button.y = entity.GetPosition().y + entity.GetScale().y / 2;
+  (void)SDL_PushEvent(&event);
+}
+
+
+Game::Game(Options const & options)
+: engine("Ben's Snake Game", options.resolution, options.softwareRenderer, options.audioBufferSamples)
+, resources(engine, static_cast<size_t>(options.memoryBudget_MiB) << 20)
 , resolution(engine.GetResolution())
 , state(State::Init)
 , checkedOnePlayer(true)
 , singlePlayer(checkedOnePlayer)
 , quit(false)
-, scoreCount(0U)
-, numberOfMoves(0UL)
-, field{ { Field::Free }, { Field::Free } }
-, fieldPosition(ConvertFullHd({ 140, 100 }))
-, fieldScale(ConvertFullHd({ 980, 980 }))
-, fieldGridScale{ fieldScale.x / FIELD_WIDTH, fieldScale.y / FIELD_HEIGHT }
+, redraw(true)
+, simulation(options.boardSize)
+, boardAnalysis()
+, pNetLink()
+, pSession()
+, netHost(options.netRole == Options::NetRole::Host)
+, verdictReported(true)
+, arenaPlayers(options.arenaPlayers)
+, pBotPlugins(options.botPlugins.empty() ? nullptr : new BotPlugins(options.botPlugins, options.botDeadline_us))
+, pFrameCapture()
+, captureTickPeriod(SDL_GetPerformanceFrequency() / options.captureFps)
+, layout(resolution)
+, camera(options.boardSize)
+, followedSnake(0UL)
+, minimap(options.boardSize)
+, rewind(options.boardSize, REWIND_TICKS)
+, rewindState()
+, rewindTick(0UL)
+, pSpectatorFeed(options.spectatorFeed.empty() ? nullptr : new SpectatorFeed(options.spectatorFeed, options.boardSize))
+, particles()
+, lastParticleTick(0UL)
+, pAllocationSelftest((options.allocSelftestFrames > 0U)
+                      // Phases in the order of State
+                      ? new AllocationSelftest(options.allocSelftestFrames, { "menu", "match", "game over", "new highscore" })
+                      : nullptr)
+, pSoak(((options.soakMinutes > 0U) || pAllocationSelftest) ? new Soak(options.soakMinutes) : nullptr)
+, soakState(State::Init)
+, soakStep(0U)
+, soakMoveBudget(0UL)
+, soakTargetScore(0U)
+, soakSteeredMove(0UL)
+, nextSoakAction_ms(0UL)
+, pLatencyTracer(options.traceLatency ? new LatencyTracer() : nullptr)
 , currentTick(0UL)
 , lastGameHandleTick(0UL)
 , lastHighScoreHandleTick(0UL)
 , highscoresStr()
 , newHighscoreName()
-, highscoreEntries{ HighscoreEntry{"-", 0}, HighscoreEntry{"-", 0}, HighscoreEntry{"-", 0} }
+, highscoreRankText()
+, gameOverText()
+, highscoreStore(pSoak ? SOAK_HIGHSCORE_PATH : HIGHSCORE_PATH, LEGACY_HIGHSCORE_PATH, "1P-19x19")
+, highscoreTable("1P-" + std::to_string(options.boardSize.x) + "x" + std::to_string(options.boardSize.y))
 , bannerBgColor{ 0 }
 , bannerTxtColor{ 0 }
-, players{ Player(engine.CreatePicTexture("./res/gfx/snakeHead0.png"),
-                  engine.CreatePicTexture("./res/gfx/snakeHeadDead0.png"),
-                  engine.CreatePicTexture("./res/gfx/snakeSkin0.jpg"), fieldGridScale, Field::Snake0),
-           Player(engine.CreatePicTexture("./res/gfx/snakeHead1.png"),
-                  engine.CreatePicTexture("./res/gfx/snakeHeadDead1.png"),
-                  engine.CreatePicTexture("./res/gfx/snakeSkin1.jpg"), fieldGridScale, Field::Snake1) }
-, pFontTitle(engine.CreateFont("./res/font/28DaysLater.ttf", 64))
-, pFontButton(engine.CreateFont("./res/font/GretoonHighlight.ttf", 28))
-, pFontScore(engine.CreateFont("./res/font/TradingPostBold.ttf", 36))
-, pFontHighscores(engine.CreateFont("./res/font/FromCartoonBlocks.ttf", 36))
-, pFontGameOver2P(engine.CreateFont("./res/font/FromCartoonBlocks.ttf", 100))
-, pFontStandard(engine.CreateFont("./res/font/Montserrat.ttf", 36))
-, pFontStandardSmall(engine.CreateFont("./res/font/Montserrat.ttf", 24))
-, pBensGame(engine.CreateTextTexture("Bens Snake Game", pFontTitle, BLACK))
-, pStart(engine.CreateTextTexture("Start", pFontButton, RED))
-, pOnePlayer(engine.CreateTextTexture(" 1 P", pFontButton, RED))
-, pTwoPlayer(engine.CreateTextTexture("2 P", pFontButton, RED))
-, pGameOverTwoPlayers(engine.CreateTextTexture("", pFontGameOver2P, WHITE))
-, pExit(engine.CreateTextTexture("Exit", pFontButton, RED))
-, pScore(engine.CreateTextTexture("x  0", pFontScore, BLACK))
-, pHighscores(engine.CreateTextTexture(highscoresStr.c_str(), pFontHighscores, bannerTxtColor))
-, pNewHighScore(engine.CreateTextTexture("New highscore!", pFontStandard, WHITE))
-, pEnterName(engine.CreateTextTexture("Enter name:", pFontStandard, WHITE))
-, pVersion(engine.CreateTextTexture(VERSION, pFontStandardSmall, BLACK))
-, pTitleBackground(engine.CreatePicTexture("./res/gfx/titleBackground.jpg"))
-, pChecked(engine.CreatePicTexture("./res/gfx/checked.png"))
-, pArrows(engine.CreatePicTexture("./res/gfx/arrows.png"))
-, pWasd(engine.CreatePicTexture("./res/gfx/wasd.png"))
-, pApple(engine.CreatePicTexture("./res/gfx/apple.png"))
-, pGameOver(engine.CreatePicTexture("./res/gfx/gameOver.png"))
-, pPlane(engine.CreatePicTexture("./res/gfx/plane.png"))
-, pTrophy(engine.CreatePicTexture("./res/gfx/trophy.png"))
-, pMusic(Mix_LoadMUS("./res/sfx/music.mp3"))
-, pBiteSound(Mix_LoadWAV("./res/sfx/bite.wav"))
-, pPunchSound(Mix_LoadWAV("./res/sfx/punch.mp3"))
-, pHornSound(Mix_LoadWAV("./res/sfx/horn.mp3"))
-, pCheerSound(Mix_LoadWAV("./res/sfx/cheering.mp3"))
-, pSquashSound(Mix_LoadWAV("./res/sfx/squash.mp3"))
-, bensGame(pBensGame, ConvertFullHd({ 20, 20 }))
-, start(pStart, ConvertFullHd({ 20, 100 }))
-, onePlayer(pOnePlayer, ConvertFullHd({ 20, 160 }))
-, twoPlayer(pTwoPlayer, ConvertFullHd({ 20, 220 }))
-, gameOverTwoPlayers(pGameOverTwoPlayers, fieldPosition + ConvertFullHd({ 180, 400 }))
-, exit(pExit, ConvertFullHd({ 20, 320 }))
-, score(pScore, ConvertFullHd({ 1700, 712 }), { 0, 0 }, SCORE_ANGLE)
-, titleBackground(pTitleBackground, { 0, 0 }, ConvertFullHd({ 1920, 1080 }))
-, checked(pChecked, ConvertFullHd(POS_CHECKED_1P), ConvertFullHd({ 80, 80 }))
-, arrows(pArrows, ConvertFullHd({ 90, 160 }), ConvertFullHd({ 40, 30 }))
-, wasd(pWasd, ConvertFullHd({ 90, 220 }), ConvertFullHd({ 40, 30 }))
-, apple(pApple, { 0, 0 }, fieldGridScale)
-, gameOver(pGameOver, fieldPosition + ConvertFullHd({ 60, 200 }), ConvertFullHd({ 800, 480 }))
-, plane(pPlane, { resolution.x, 0 }, ConvertFullHd({ 219, 102 }))
-, highscores(pHighscores)
-, trophy(pTrophy, gameOver.GetPosition() + ConvertFullHd({ 20, 50 }), ConvertFullHd({ 220, 242 }))
-, newHighscore(pNewHighScore, gameOver.GetPosition() + ConvertFullHd({ 300, 50 }))
-, enterName(pEnterName, gameOver.GetPosition() + ConvertFullHd({ 300, 200 }))
-, version(pVersion, ConvertFullHd({ 1845, 1050 }))
+, players{ Player(resources.Picture("./res/gfx/snakeHead0.png"),
+                  resources.Picture("./res/gfx/snakeHeadDead0.png"),
+                  resources.Picture("./res/gfx/snakeSkin0.jpg"), { 0, 0 }),
+           Player(resources.Picture("./res/gfx/snakeHead1.png"),
+                  resources.Picture("./res/gfx/snakeHeadDead1.png"),
+                  resources.Picture("./res/gfx/snakeSkin1.jpg"), { 0, 0 }) }
+, fontTitle()
+, fontButton()
+, fontScore()
+, fontHighscores()
+, fontGameOver2P()
+, fontStandard()
+, fontStandardSmall()
+, pBensGame(nullptr)
+, pStart(nullptr)
+, pOnePlayer(nullptr)
+, pTwoPlayer(nullptr)
+, pGameOverTwoPlayers(nullptr)
+, pExit(nullptr)
+, pScore(nullptr)
+, pHighscores(nullptr)
+, pNewHighScore(nullptr)
+, pEnterName(nullptr)
+, pHighscoreName(nullptr)
+, pHighscoreRank(nullptr)
+, pMinimap(nullptr)
+, pVersion(nullptr)
+, titleBackgroundPic(resources.Picture("./res/gfx/titleBackground.jpg"))
+, checkedPic(resources.Picture("./res/gfx/checked.png"))
+, arrowsPic(resources.Picture("./res/gfx/arrows.png"))
+, wasdPic(resources.Picture("./res/gfx/wasd.png"))
+, applePic(resources.Picture("./res/gfx/apple.png"))
+, gameOverPic(resources.Picture("./res/gfx/gameOver.png"))
+, planePic(resources.Picture("./res/gfx/plane.png"))
+, trophyPic(resources.Picture("./res/gfx/trophy.png"))
+, pMusic(Mix_LoadMUS(MUSIC_PATH))
+, biteSound(resources.Sound("./res/sfx/bite.wav", MIX_MAX_VOLUME))
+, punchSound(resources.Sound("./res/sfx/punch.mp3", MIX_MAX_VOLUME / 2))
+, hornSound(resources.Sound("./res/sfx/horn.mp3", MIX_MAX_VOLUME / 2))
+, cheerSound(resources.Sound("./res/sfx/cheering.mp3", MIX_MAX_VOLUME))
+, squashSound(resources.Sound("./res/sfx/squash.mp3", MIX_MAX_VOLUME))
+, bensGame(nullptr, layout.bensGamePosition)
+, start(nullptr, layout.startPosition)
+, onePlayer(nullptr, layout.onePlayerPosition)
+, twoPlayer(nullptr, layout.twoPlayerPosition)
+, gameOverTwoPlayers(nullptr, layout.gameOverTwoPlayersPosition)
+, exit(nullptr, layout.exitPosition)
+, score(nullptr, layout.scorePosition, { 0, 0 }, SCORE_ANGLE)
+, titleBackground(nullptr, { 0, 0 }, layout.titleBackgroundScale)
+, checked(nullptr, layout.checkedOnePlayerPosition, layout.checkedScale)
+, arrows(nullptr, layout.arrowsPosition, layout.keysScale)
+, wasd(nullptr, layout.wasdPosition, layout.keysScale)
+, apple(nullptr)
+, gameOver(nullptr, layout.gameOverPosition, layout.gameOverScale)
+, plane(nullptr, { resolution.x, 0 }, layout.planeScale)
+, highscores(nullptr)
+, trophy(nullptr, layout.trophyPosition, layout.trophyScale)
+, newHighscore(nullptr, layout.newHighscorePosition)
+, enterName(nullptr, layout.enterNamePosition)
+, highscoreName(nullptr, layout.newHighscoreNamePosition)
+, highscoreRank(nullptr, layout.highscoreRankPosition)
+, version(nullptr, layout.versionPosition)
 {
+  // Names never outgrow this, typing does not allocate
+  newHighscoreName.reserve(64UL);
+
+  // Minimap colors close to the snake skins
+  minimap.SetColor(Simulation::FREE, DARKBLUE);
+  minimap.SetColor(1U, SNAKE_GREEN);
+  minimap.SetColor(2U, SNAKE_RED);
+  for (size_t player = players.size(); player < Simulation::MAX_PLAYERS; ++player)
+  {
+    minimap.SetColor(static_cast<Simulation::Cell>(player + 1U), ArenaColor(player));
+  }
+
   // use current time as seed for random generator
   std::srand(std::time({}));
 
+  if (options.netRole != Options::NetRole::None)
+  {
+    // Host and client use neighbouring ports on the loopback interface
+    pNetLink.reset(new NetLink(netHost ? options.netPort : options.netPort + 1U,
+                               netHost ? options.netPort + 1U : options.netPort,
+                               options.netMinDelay_ms,
+                               options.netMaxDelay_ms));
+    pSession.reset(new RollbackSession(simulation, *pNetLink, netHost ? 0UL : 1UL));
+    checkedOnePlayer = false;
+    singlePlayer = false;
+    checked.SetPosition(layout.checkedTwoPlayerPosition);
+  }
+
+  if (!options.captureOutput.empty())
+  {
+    // Enough buffers to keep every encoder busy while the next frames are read back
+    size_t const workers = (options.captureWorkers > 0U) ? options.captureWorkers
+                                                         : std::max(std::thread::hardware_concurrency(), 1U);
+    pFrameCapture.reset(new FrameCapture(options.captureOutput, workers, workers * 2UL + 2UL));
+    engine.EnableCapture(pFrameCapture.get());
+  }
+
   // Randomize plane's banner color with contrast text color
   bannerBgColor = { static_cast<uint8_t>(std::rand() % 256),
                     static_cast<uint8_t>(std::rand() % 256),
@@ -100,221 +223,701 @@ Game::Game(Position const & res)
   bannerTxtColor.g = (bannerBgColor.g < 128U) ? 255U : 0U;
   bannerTxtColor.b = (bannerBgColor.b < 128U) ? 255U : 0U;
 
-  ApplyStoredHighscores();
+  // Assets are loaded on their first use, texts only need the fonts of the menu
+  RasterizeTexts();
+  ApplyLayout();
 
   Mix_MasterVolume(MIX_MAX_VOLUME);
-  Mix_VolumeChunk(pBiteSound, MIX_MAX_VOLUME);
-  Mix_VolumeChunk(pPunchSound, MIX_MAX_VOLUME / 2);
-  Mix_VolumeChunk(pHornSound, MIX_MAX_VOLUME / 2);
-  Mix_VolumeChunk(pCheerSound, MIX_MAX_VOLUME);
-  Mix_VolumeChunk(pSquashSound, MIX_MAX_VOLUME);
   Mix_VolumeMusic(MIX_MAX_VOLUME / 4);
   Mix_PlayMusic(pMusic, -1);
 
-  // Adjust font scale relating to resolution
   std::cout << "resolution: " << resolution.x << "x" << resolution.y << "\n";
-  bensGame.SetScale(ConvertFullHd(bensGame.GetTextureSize()));
-  start.SetScale(ConvertFullHd(start.GetTextureSize()));
-  onePlayer.SetScale(ConvertFullHd(onePlayer.GetTextureSize()));
-  twoPlayer.SetScale(ConvertFullHd(twoPlayer.GetTextureSize()));
-  exit.SetScale(ConvertFullHd(exit.GetTextureSize()));
-  score.SetScale(ConvertFullHd(score.GetTextureSize()));
-  newHighscore.SetScale(ConvertFullHd(newHighscore.GetTextureSize()));
-  enterName.SetScale(ConvertFullHd(enterName.GetTextureSize()));
-  version.SetScale(ConvertFullHd(version.GetTextureSize()));
 }
 
 
 Game::~Game(void)
 {
-  Mix_FreeChunk(pCheerSound);
-  Mix_FreeChunk(pHornSound);
-  Mix_FreeChunk(pPunchSound);
-  Mix_FreeChunk(pBiteSound);
   Mix_FreeMusic(pMusic);
 
-  engine.DestroyTexture(pTrophy);
-  engine.DestroyTexture(pPlane);
-  engine.DestroyTexture(pGameOver);
-  engine.DestroyTexture(pApple);
-  engine.DestroyTexture(pChecked);
-  engine.DestroyTexture(pTitleBackground);
+  // Pictures, fonts and sounds belong to the resource manager
   engine.DestroyTexture(pVersion);
+  engine.DestroyTexture(pMinimap);
+  engine.DestroyTexture(pHighscoreRank);
+  engine.DestroyTexture(pHighscoreName);
   engine.DestroyTexture(pEnterName);
   engine.DestroyTexture(pNewHighScore);
   engine.DestroyTexture(pHighscores);
   engine.DestroyTexture(pScore);
   engine.DestroyTexture(pExit);
+  engine.DestroyTexture(pGameOverTwoPlayers);
   engine.DestroyTexture(pTwoPlayer);
   engine.DestroyTexture(pOnePlayer);
   engine.DestroyTexture(pStart);
   engine.DestroyTexture(pBensGame);
-
-  engine.DestroyFont(pFontStandardSmall);
-  engine.DestroyFont(pFontStandard);
-  engine.DestroyFont(pFontGameOver2P);
-  engine.DestroyFont(pFontHighscores);
-  engine.DestroyFont(pFontScore);
-  engine.DestroyFont(pFontButton);
-  engine.DestroyFont(pFontTitle);
-
-  for (Player const & player : players)
-  {
-    engine.DestroyTexture(player.pSnakeSkin);
-    engine.DestroyTexture(player.pSnakeHeadDead);
-    engine.DestroyTexture(player.pSnakeHead);
-  }
 }
 
 
-void Game::Run(void)
+int Game::Run(void)
 {
+  uint64_t frameAllocations = GetThreadAllocations();
+  currentTick = SDL_GetPerformanceCounter();
+  uint64_t lastPresentTick = currentTick;
   while (!quit)
   {
-    currentTick = SDL_GetPerformanceCounter();
+    if (!pFrameCapture)
+    {
+      currentTick = SDL_GetPerformanceCounter();
+    }
+    else if (pFrameCapture->HasFreeBuffer())
+    {
+      // Captured videos run on their own clock, every frame is one frame period later
+      currentTick += captureTickPeriod;
+    }
+    else
+    {
+      // Encoders are behind, hold the game instead of blocking or dropping frames
+      SDL_Delay(1UL);
+      continue;
+    }
+
+    State const frameState = state;
+    uint64_t const frameTexts = engine.GetNumberOfRasterizedTexts();
 
     HandlePlanePosition();
 
+    if (pSoak)
+    {
+      // Scripted input stands in for a player, its own allocations are not the frame's
+      uint64_t const scriptAllocations = GetThreadAllocations();
+      DriveSoak();
+      frameAllocations += GetThreadAllocations() - scriptAllocations;
+    }
+
     HandleEvent();
 
     HandleGame();
 
-    Render();
+    UpdateParticles();
 
-    engine.UpdateScreen();
+    // Running matches and captured videos draw every frame, menus only when something changed
+    bool const onDemand = (state != State::Running) && !pFrameCapture;
+    if (redraw || !onDemand)
+    {
+      if (pLatencyTracer)
+      {
+        pLatencyTracer->Reach(LatencyTracer::Stage::Render, SDL_GetPerformanceCounter());
+      }
 
-    // Just to relax the cpu
-    SDL_Delay(1UL);
+      Render();
+
+      engine.UpdateScreen();
+
+      uint64_t const presentTick = SDL_GetPerformanceCounter();
+      if (pLatencyTracer)
+      {
+        pLatencyTracer->Reach(LatencyTracer::Stage::Present, presentTick);
+      }
+      if (!onDemand)
+      {
+        uint64_t const frameTime_us = ((presentTick - lastPresentTick) * 1000000UL) / SDL_GetPerformanceFrequency();
+        Metrics::Observe(Metrics::Histogram::FrameTime, frameTime_us);
+        if (pSoak && !pAllocationSelftest)
+        {
+          pSoak->AddFrameTime(frameTime_us);
+        }
+      }
+      lastPresentTick = presentTick;
+      redraw = false;
+
+      resources.EndFrame();
+    }
+
+    if (engine.GetAudio().NeedsLargerBuffer())
+    {
+      ReopenAudio();
+    }
+
+    // Counted with COUNT_ALLOCATIONS only, frames after warm up should not touch the heap
+    uint64_t const allocations = GetThreadAllocations();
+    Metrics::Add(Metrics::Counter::Allocations, allocations - frameAllocations);
+    if (pAllocationSelftest)
+    {
+      bool const steady = (state == frameState) && (engine.GetNumberOfRasterizedTexts() == frameTexts);
+      pAllocationSelftest->AddFrame(static_cast<size_t>(state), allocations - frameAllocations, steady);
+      quit = quit || pAllocationSelftest->IsFinished();
+    }
+    frameAllocations = GetThreadAllocations();
+
+    if (pLatencyTracer)
+    {
+      pLatencyTracer->Update(SDL_GetPerformanceCounter());
+    }
+
+    if (pSoak && !pAllocationSelftest && !pSoak->Update(SDL_GetPerformanceCounter() / (SDL_GetPerformanceFrequency() / 1000UL), engine.GetNumberOfTextures()))
+    {
+      quit = true;
+    }
+
+    if (onDemand)
+    {
+      // Sleep until input arrives or the plane moves next
+      uint64_t const frequency = SDL_GetPerformanceFrequency();
+      uint64_t const elapsed_ms = ((SDL_GetPerformanceCounter() - lastHighScoreHandleTick) * 1000UL) / frequency;
+      (void)SDL_WaitEventTimeout(nullptr, static_cast<int>(PLANE_MOVE_PERIOD_MS - std::min(elapsed_ms, PLANE_MOVE_PERIOD_MS)));
+    }
+    else
+    {
+      // Just to relax the cpu
+      SDL_Delay(1UL);
+    }
   }
+
+  engine.FinishCapture();
+
+  if (pAllocationSelftest)
+  {
+    return pAllocationSelftest->Passed() ? 0 : 1;
+  }
+  return (pSoak && !pSoak->Passed()) ? 1 : 0;
+}
+
+
+void Game::ReopenAudio(void)
+{
+  // Music decoders may not outlive the audio device, so the music is loaded again
+  Mix_FreeMusic(pMusic);
+  engine.GetAudio().Reopen();
+  pMusic = Mix_LoadMUS(MUSIC_PATH);
+  Mix_VolumeMusic(MIX_MAX_VOLUME / 4);
+  Mix_PlayMusic(pMusic, -1);
 }
 
 
 void Game::Restart(void)
 {
-  singlePlayer = checkedOnePlayer;
-  memset(field, 0, sizeof(field));
-  for (Player & player : players)
+  uint64_t const seed = (static_cast<uint64_t>(std::rand()) << 32) | static_cast<uint64_t>(std::rand());
+
+  if (pSession)
+  {
+    if (!netHost)
+    {
+      // Network matches are started by the host only
+      return;
+    }
+    pSession->Start(seed);
+  }
+  else if (arenaPlayers > 0UL)
+  {
+    // Player 1 against bots
+    singlePlayer = false;
+    simulation.Restart(arenaPlayers, seed);
+  }
+  else
   {
-    player.snake.clear();
-    player.snakeHead.SetTexture(player.pSnakeHead);
-    player.snakeDirection = Direction::Up;
-    player.pressedDirection = Direction::Up;
+    singlePlayer = checkedOnePlayer;
+    simulation.Restart(singlePlayer ? 1U : 2U, seed);
   }
 
-  if (singlePlayer)
+  BeginMatch();
+}
+
+
+void Game::BeginMatch(void)
+{
+  UpdateScoreDisplay();
+
+  // The camera follows the local player's snake
+  followedSnake = (pSession && !netHost) ? 1UL : 0UL;
+  camera.SetFollowing(true);
+
+  lastGameHandleTick = currentTick;
+  verdictReported = !pSession;
+  particles.Clear();
+
+  // Local games are recorded from their first tick
+  rewind.Clear();
+  if (!pSession)
   {
-    // Start with 3 parts sized snake
-    AddSnakeHead(players[0], {FIELD_WIDTH / 2, FIELD_HEIGHT - 1});
-    AddSnakeHead(players[0], {FIELD_WIDTH / 2, FIELD_HEIGHT - 2});
-    AddSnakeHead(players[0], {FIELD_WIDTH / 2, FIELD_HEIGHT - 3});
+    rewind.Record(simulation.GetState());
+    if (pSpectatorFeed)
+    {
+      pSpectatorFeed->Publish(rewind, simulation.GetState().numberOfMoves);
+    }
+  }
 
-    RandomApplePosition();
+  state = State::Running;
+  Metrics::Set(Metrics::Gauge::ActiveMatches, 1L);
+  engine.GetAudio().Play(hornSound.GetSound());
+}
+
+
+void Game::EndMatch(void)
+{
+  // A new highscore has to beat the last shown entry
+  std::vector<HighscoreStore::Entry> const top = highscoreStore.Top(highscoreTable, NUMBER_OF_SHOWN_HIGHSCORES);
+  uint16_t const lastShownScore = (top.size() < NUMBER_OF_SHOWN_HIGHSCORES) ? 0U : top.back().score;
+  if (singlePlayer && (simulation.GetState().scoreCount > lastShownScore))
+  {
+    newHighscoreName.clear();
+    UpdateHighscoreNameDisplay();
+
+    // Ranked among all entries of the table, not only the shown ones
+    uint16_t const scoreCount = simulation.GetState().scoreCount;
+    highscoreRankText = "Rank " + std::to_string(highscoreStore.Rank(highscoreTable, scoreCount))
+                      + " of " + std::to_string(highscoreStore.Size(highscoreTable) + 1UL);
+    UpdateHighscoreRankDisplay();
+    state = State::NewHighscore;
+    engine.GetAudio().Play(cheerSound.GetSound());
+
+    // Fountains across the screen in gold and the snake's green
+    for (size_t fountain = 0UL; fountain < VICTORY_FOUNTAINS; ++fountain)
+    {
+      Position const center = { resolution.x * static_cast<int>(fountain + 1UL) / static_cast<int>(VICTORY_FOUNTAINS + 1UL),
+                                resolution.y * 2 / 3 };
+      particles.Emit(center, VICTORY_PARTICLES, ((fountain % 2UL) == 0UL) ? GOLD : SNAKE_GREEN,
+                     static_cast<float>(resolution.y), static_cast<float>(resolution.y / 200 + 2));
+    }
   }
   else
   {
-    // Player 1
-    AddSnakeHead(players[0], {FIELD_WIDTH / 2 + 2, FIELD_HEIGHT - 1});
-    AddSnakeHead(players[0], {FIELD_WIDTH / 2 + 2, FIELD_HEIGHT - 2});
-    AddSnakeHead(players[0], {FIELD_WIDTH / 2 + 2, FIELD_HEIGHT - 3});
+    state = State::GameOver;
+  }
+  rewindTick = std::max(rewind.GetNumberOfTicks(), 1UL) - 1UL;
+  Metrics::Add(Metrics::Counter::Games);
+  Metrics::Set(Metrics::Gauge::ActiveMatches, 0L);
+
+  // Update game over text for two player game, single player games never need its large font
+  std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+  std::vector<Simulation::Snake>::const_iterator const winner =
+    std::find_if(snakes.begin(), snakes.end(), [](Simulation::Snake const & snake){ return snake.alive; });
+  gameOverText = singlePlayer ? ""
+               : (winner == snakes.end()) ? "   Draw Game!"
+                                          : "Player " + std::to_string(winner - snakes.begin() + 1) + " wins!";
+  UpdateGameOverDisplay();
+}
+
+
+void Game::Steer(size_t const player, Simulation::Direction const direction)
+{
+  if (state != State::Running)
+  {
+    return;
+  }
 
-    // Payer 2
-    AddSnakeHead(players[1], {FIELD_WIDTH / 2 - 2, FIELD_HEIGHT - 1});
-    AddSnakeHead(players[1], {FIELD_WIDTH / 2 - 2, FIELD_HEIGHT - 2});
-    AddSnakeHead(players[1], {FIELD_WIDTH / 2 - 2, FIELD_HEIGHT - 3});
+  bool steered = false;
+  if (pSession)
+  {
+    // Both key sets control the local snake in a network match
+    steered = pSession->Steer(direction);
+  }
+  else if (player < simulation.GetState().snakes.size())
+  {
+    steered = simulation.Steer(player, direction);
   }
 
-  scoreCount = 0U;
+  if (steered && pLatencyTracer)
+  {
+    pLatencyTracer->Steered(SDL_GetPerformanceCounter());
+  }
+}
+
+
+void Game::Scrub(int64_t const ticks)
+{
+  // Only finished local games are rewound, a network session owns its simulation
+  if ((state != State::GameOver) || pSession || (rewind.GetNumberOfTicks() == 0UL))
+  {
+    return;
+  }
+
+  int64_t const last = static_cast<int64_t>(rewind.GetNumberOfTicks()) - 1;
+  rewindTick = static_cast<size_t>(std::min(std::max(static_cast<int64_t>(rewindTick) + ticks, static_cast<int64_t>(0)), last));
+  rewind.Rebuild(rewindTick, rewindState);
+  simulation.Restore(rewindState);
   UpdateScoreDisplay();
+}
 
-  currentTick = SDL_GetPerformanceCounter();
-  lastGameHandleTick = currentTick;
-  numberOfMoves = 0UL;
 
-  state = State::Running;
-  (void)Mix_PlayChannel(-1, pHornSound, 0);
+Position Game::FieldToScreen(Position const & fieldpos) const
+{
+  return camera.CellToScreen(fieldpos);
+}
+
+
+void Game::EmitBurst(Position const & cell, size_t const number, SDL_Color const & color, float const speed)
+{
+  // Speed in cells per second, so bursts look alike at every zoom
+  Position const cellScale = camera.GetCellScale();
+  Position const corner = FieldToScreen(cell);
+  particles.Emit({ corner.x + cellScale.x / 2, corner.y + cellScale.y / 2 }, number, color,
+                 speed * static_cast<float>(cellScale.x), static_cast<float>(std::max(cellScale.x / 8, 2)));
+}
+
+
+void Game::UpdateParticles(void)
+{
+  float const deltaTime_s = static_cast<float>(currentTick - lastParticleTick) / static_cast<float>(SDL_GetPerformanceFrequency());
+  lastParticleTick = currentTick;
+  if (particles.GetNumberOfParticles() > 0UL)
+  {
+    // Menus are drawn on demand, live particles keep them animated until the last one is gone
+    particles.Update(std::min(deltaTime_s, MAX_PARTICLE_STEP_S));
+    redraw = true;
+  }
+}
+
+
+SDL_Color Game::ArenaColor(size_t const player) const
+{
+  // Distinct bright colors for the arena snakes without an own skin
+  uint32_t const hash = static_cast<uint32_t>(player) * 2654435761U;
+  return { static_cast<uint8_t>(64U + ((hash >> 8) % 192U)),
+           static_cast<uint8_t>(64U + ((hash >> 16) % 192U)),
+           static_cast<uint8_t>(64U + ((hash >> 24) % 192U)) };
+}
+
+
+void Game::Resize(Position const & res)
+{
+  // Only layout and text depend on the resolution, pictures are just scaled differently
+  engine.SetResolution(res);
+  resolution = res;
+  layout = Layout(resolution);
+  RasterizeTexts();
+  ApplyLayout();
+}
+
+
+void Game::RasterizeTexts(void)
+{
+  // Fonts of the previous size lose their handles, so the resource budget can drop them
+  fontTitle = resources.Font("./res/font/28DaysLater.ttf", layout.FontSize(FONT_SIZE_TITLE));
+  fontButton = resources.Font("./res/font/GretoonHighlight.ttf", layout.FontSize(FONT_SIZE_BUTTON));
+  fontScore = resources.Font("./res/font/TradingPostBold.ttf", layout.FontSize(FONT_SIZE_SCORE));
+  fontHighscores = resources.Font("./res/font/FromCartoonBlocks.ttf", layout.FontSize(FONT_SIZE_HIGHSCORES));
+  fontGameOver2P = resources.Font("./res/font/FromCartoonBlocks.ttf", layout.FontSize(FONT_SIZE_GAME_OVER_2P));
+  fontStandard = resources.Font("./res/font/Montserrat.ttf", layout.FontSize(FONT_SIZE_STANDARD));
+  fontStandardSmall = resources.Font("./res/font/Montserrat.ttf", layout.FontSize(FONT_SIZE_STANDARD_SMALL));
+
+  std::array<std::pair<Texture**, Entity*>, 8> const texts = {{
+    { &pBensGame, &bensGame },
+    { &pStart, &start },
+    { &pOnePlayer, &onePlayer },
+    { &pTwoPlayer, &twoPlayer },
+    { &pExit, &exit },
+    { &pNewHighScore, &newHighscore },
+    { &pEnterName, &enterName },
+    { &pVersion, &version }
+  }};
+  char const * const pTexts[] = { "Bens Snake Game", "Start", " 1 P", "2 P", "Exit", "New highscore!", "Enter name:", VERSION };
+  ResourceManager::Handle const * const pFonts[] = { &fontTitle, &fontButton, &fontButton, &fontButton, &fontButton,
+                                                    &fontStandard, &fontStandard, &fontStandardSmall };
+  SDL_Color const colors[] = { BLACK, RED, RED, RED, RED, WHITE, WHITE, BLACK };
+  for (size_t i = 0UL; i < texts.size(); ++i)
+  {
+    engine.DestroyTexture(*texts[i].first);
+    *texts[i].first = engine.CreateTextTexture(pTexts[i], pFonts[i]->GetFont(), colors[i]);
+    texts[i].second->SetTexture(*texts[i].first);
+  }
+
+  UpdateGameOverDisplay();
+  UpdateHighscoreNameDisplay();
+  UpdateHighscoreRankDisplay();
+  UpdateScoreDisplay();
+  UpdateHighscoreBanner();
+}
+
+
+void Game::ApplyLayout(void)
+{
+  for (Entity* const pText : { &bensGame, &start, &onePlayer, &twoPlayer, &exit, &newHighscore, &enterName, &version,
+                               &gameOverTwoPlayers, &score, &highscores })
+  {
+    pText->SetScale(pText->GetTextureSize());
+  }
+
+  bensGame.SetPosition(layout.bensGamePosition);
+  start.SetPosition(layout.startPosition);
+  onePlayer.SetPosition(layout.onePlayerPosition);
+  twoPlayer.SetPosition(layout.twoPlayerPosition);
+  exit.SetPosition(layout.exitPosition);
+  gameOverTwoPlayers.SetPosition(layout.gameOverTwoPlayersPosition);
+  score.SetPosition(layout.scorePosition);
+  titleBackground.SetScale(layout.titleBackgroundScale);
+  checked.SetPosition(checkedOnePlayer ? layout.checkedOnePlayerPosition : layout.checkedTwoPlayerPosition);
+  checked.SetScale(layout.checkedScale);
+  arrows.SetPosition(layout.arrowsPosition);
+  arrows.SetScale(layout.keysScale);
+  wasd.SetPosition(layout.wasdPosition);
+  wasd.SetScale(layout.keysScale);
+  gameOver.SetPosition(layout.gameOverPosition);
+  gameOver.SetScale(layout.gameOverScale);
+  plane.SetScale(layout.planeScale);
+  trophy.SetPosition(layout.trophyPosition);
+  trophy.SetScale(layout.trophyScale);
+  newHighscore.SetPosition(layout.newHighscorePosition);
+  enterName.SetPosition(layout.enterNamePosition);
+  highscoreName.SetPosition(layout.newHighscoreNamePosition);
+  highscoreRank.SetPosition(layout.highscoreRankPosition);
+  version.SetPosition(layout.versionPosition);
+
+  camera.SetViewport(layout.fieldPosition, layout.fieldScale);
+  ApplyCellScale();
 }
 
 
-void Game::AddSnakeHead(Player & player, Position const fieldpos)
+void Game::ApplyCellScale(void)
 {
-  player.snake.push_front(fieldpos);
-  player.snakeHead.SetPosition({ fieldPosition.x + fieldpos.x * fieldGridScale.x,
-                                 fieldPosition.y + fieldpos.y * fieldGridScale.y });
-  field[fieldpos.x][fieldpos.y] = player.fieldMarker;
+  Position const cellScale = camera.GetCellScale();
+  apple.SetScale(cellScale);
+  for (Player & player : players)
+  {
+    player.snakeHead.SetScale({ cellScale.x, static_cast<int>(cellScale.y * 163.0 / 104.0) });
+  }
+}
+
+
+void Game::FollowNextSnake(void)
+{
+  // The camera jumps to the next snake still on the board
+  std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+  for (size_t i = 1UL; i <= snakes.size(); ++i)
+  {
+    size_t const snake = (followedSnake + i) % snakes.size();
+    if (snakes[snake].length > 0U)
+    {
+      followedSnake = snake;
+      break;
+    }
+  }
+  camera.SetFollowing(true);
+}
+
+
+void Game::DriveSoak(void)
+{
+  if (state != soakState)
+  {
+    soakState = state;
+    soakStep = 0U;
+  }
+
+  if (state == State::Running)
+  {
+    // Bots steer once per tick until the game's budget is spent, then the snakes run into something
+    Simulation::State const & simulationState = simulation.GetState();
+    if (simulationState.numberOfMoves == soakSteeredMove)
+    {
+      return;
+    }
+    soakSteeredMove = simulationState.numberOfMoves;
+    if ((simulationState.numberOfMoves >= soakMoveBudget) || (simulationState.scoreCount >= soakTargetScore))
+    {
+      return;
+    }
+
+    boardAnalysis.Analyze(simulationState.field, simulation.GetSize());
+    size_t const steeredSnakes = (arenaPlayers > 0UL) ? 1UL : std::min(simulationState.snakes.size(), players.size());
+    for (size_t i = 0UL; i < steeredSnakes; ++i)
+    {
+      if (simulationState.snakes[i].alive)
+      {
+        Simulation::Direction const direction = ChooseBotDirection(simulation, boardAnalysis, i);
+        if (direction != simulationState.snakes[i].snakeDirection)
+        {
+          PushKey(SOAK_STEERING_KEYS[i][static_cast<size_t>(direction)]);
+        }
+      }
+    }
+    return;
+  }
+
+  // The allocation selftest keeps every menu until enough of its frames were checked
+  if (pAllocationSelftest && !pAllocationSelftest->IsChecked(static_cast<size_t>(state)))
+  {
+    return;
+  }
+
+  // Menus get one action per period, slow enough to see each of them drawn
+  uint64_t const now_ms = currentTick / (SDL_GetPerformanceFrequency() / 1000UL);
+  if (now_ms < nextSoakAction_ms)
+  {
+    return;
+  }
+  nextSoakAction_ms = now_ms + SOAK_ACTION_PERIOD_MS;
+
+  if (state == State::NewHighscore)
+  {
+    // Type the name with a typo, correct it and confirm
+    size_t const nameLength = sizeof(SOAK_NAME) - 1UL;
+    if (soakStep < nameLength)
+    {
+      PushText(SOAK_NAME[soakStep]);
+    }
+    else if (soakStep == nameLength)
+    {
+      PushText('x');
+    }
+    else if (soakStep == nameLength + 1UL)
+    {
+      PushKey(SDLK_BACKSPACE);
+    }
+    else
+    {
+      PushKey(SDLK_RETURN);
+    }
+  }
+  else
+  {
+    // Scrub through the finished game, pick the mode of the next one and start it
+    size_t const scrubSteps = (state == State::GameOver) ? (sizeof(SOAK_SCRUB_KEYS) / sizeof(SOAK_SCRUB_KEYS[0])) : 0UL;
+    if (soakStep < scrubSteps)
+    {
+      PushKey(SOAK_SCRUB_KEYS[soakStep]);
+    }
+    else if (soakStep == scrubSteps)
+    {
+      PrepareSoakGame();
+    }
+    else if ((pSoak->Random() % 2U) == 0U)
+    {
+      PushClick(start);
+    }
+    else
+    {
+      PushKey(SDLK_SPACE);
+    }
+  }
+  ++soakStep;
 }
 
 
-void Game::RemoveSnakeTail(Player & player)
+void Game::PrepareSoakGame(void)
 {
-  field[player.snake.back().x][player.snake.back().y] = Field::Free;
-  player.snake.pop_back();
+  // Every fourth game is for two players, another one sets a new highscore, the others end early
+  uint32_t const cycle = pSoak->NextCycle();
+  bool const single = (cycle % 4U) != 3U;
+  if (single != checkedOnePlayer)
+  {
+    PushClick(single ? onePlayer : twoPlayer);
+  }
+
+  soakSteeredMove = UINT64_MAX;
+  soakMoveBudget = 20UL + pSoak->Random() % 300UL;
+  soakTargetScore = UINT16_MAX;
+  if ((cycle % 4U) == 1U)
+  {
+    std::vector<HighscoreStore::Entry> const top = highscoreStore.Top(highscoreTable, NUMBER_OF_SHOWN_HIGHSCORES);
+    uint16_t lastShownScore = (top.size() < NUMBER_OF_SHOWN_HIGHSCORES) ? 0U : top.back().score;
+    if (lastShownScore >= SOAK_MAX_HIGHSCORE)
+    {
+      // Start over before the bot can't beat the table anymore
+      highscoreStore.Remove(highscoreTable);
+      UpdateHighscoreBanner();
+      lastShownScore = 0U;
+    }
+    soakTargetScore = lastShownScore + 1U;
+    soakMoveBudget = UINT64_MAX;
+  }
 }
 
 
 void Game::RenderBackground(void)
 {
-  engine.Render(titleBackground);
+  RenderPicture(titleBackground, titleBackgroundPic);
   RenderPlane();
   engine.Render(start);
-  engine.Render(checked);
+  RenderPicture(checked, checkedPic);
   engine.Render(onePlayer);
-  engine.Render(arrows);
+  RenderPicture(arrows, arrowsPic);
   engine.Render(twoPlayer);
-  engine.Render(wasd);
+  RenderPicture(wasd, wasdPic);
   engine.Render(exit);
   engine.Render(bensGame);
-  engine.Render(ConvertFullHd({ 1640, 695 }), ConvertFullHd({ 50, 50 }), pApple, SCORE_ANGLE);
+  engine.Render(layout.scoreApplePosition, layout.scoreAppleScale, applePic.GetTexture(), SCORE_ANGLE);
   engine.Render(score);
   engine.Render(version);
 }
 
 
-void Game::RandomApplePosition(void)
+void Game::UpdateScoreDisplay(void)
 {
-  int xRandom = std::rand() % FIELD_WIDTH;
-  int yRandom = std::rand() % FIELD_HEIGHT;
-  Position const randomPosition = {xRandom, yRandom};
-  while (field[xRandom][yRandom] != Field::Free)
-  {
-    // Avoid apple position inside snake, so find next free position
-    xRandom = (xRandom < FIELD_WIDTH - 1) ? xRandom + 1
-                                          : 0;
-    yRandom = (xRandom != 0)               ? yRandom
-            : (yRandom < FIELD_HEIGHT - 1) ? yRandom + 1
-                                           : 0;
+  char scoreText[16];
+  (void)std::snprintf(scoreText, sizeof(scoreText), "x  %u", static_cast<unsigned int>(simulation.GetState().scoreCount));
+  engine.DestroyTexture(pScore);
+  pScore = engine.CreateTextTexture(scoreText, fontScore.GetFont(), BLACK);
+  score.SetTexture(pScore);
+  score.SetScale(score.GetTextureSize());
+}
 
-    if (randomPosition == Position{xRandom, yRandom})
-    {
-      // No free position found, snake everywhere
-      break;
-    }
-  }
 
-  apple.SetPosition({ fieldPosition.x + (xRandom * fieldGridScale.x),
-                      fieldPosition.y + (yRandom * fieldGridScale.y) });
+void Game::UpdateGameOverDisplay(void)
+{
+  engine.DestroyTexture(pGameOverTwoPlayers);
+  pGameOverTwoPlayers = gameOverText.empty() ? nullptr
+                                             : engine.CreateTextTexture(gameOverText.c_str(), fontGameOver2P.GetFont(), WHITE);
+  gameOverTwoPlayers.SetTexture(pGameOverTwoPlayers);
+  gameOverTwoPlayers.SetScale(gameOverTwoPlayers.GetTextureSize());
 }
 
 
-void Game::UpdateScoreDisplay(void)
+void Game::UpdateHighscoreNameDisplay(void)
 {
-  std::string const scoreString = "x  " + std::to_string(scoreCount);
-  engine.DestroyTexture(pScore);
-  pScore = engine.CreateTextTexture(scoreString.c_str(), pFontScore, BLACK);
-  score.SetTexture(pScore);
-  score.SetScale(ConvertFullHd(score.GetTextureSize()));
+  // Rasterized on edits only, not on every frame the name is shown
+  engine.DestroyTexture(pHighscoreName);
+  pHighscoreName = newHighscoreName.empty() ? nullptr
+                                            : engine.CreateTextTexture(newHighscoreName.c_str(), fontStandard.GetFont(), GOLD);
+  highscoreName.SetTexture(pHighscoreName);
+  highscoreName.SetScale(highscoreName.GetTextureSize());
+}
+
+
+void Game::UpdateHighscoreRankDisplay(void)
+{
+  engine.DestroyTexture(pHighscoreRank);
+  pHighscoreRank = highscoreRankText.empty() ? nullptr
+                                             : engine.CreateTextTexture(highscoreRankText.c_str(), fontStandardSmall.GetFont(), WHITE);
+  highscoreRank.SetTexture(pHighscoreRank);
+  highscoreRank.SetScale(highscoreRank.GetTextureSize());
+}
+
+
+void Game::RenderPicture(Entity & entity, ResourceManager::Handle const & picture)
+{
+  // Pictures may have been unloaded since the last frame, so the entity gets the current texture
+  entity.SetTexture(picture.GetTexture());
+  engine.Render(entity);
 }
 
 
 void Game::HandleEvent(void)
 {
   SDL_Event event;
-  SDL_PollEvent(&event);
+  if (SDL_PollEvent(&event) == 0)
+  {
+    return;
+  }
+
+  if (pLatencyTracer && (event.type == SDL_KEYDOWN))
+  {
+    pLatencyTracer->Poll(event.key.timestamp, SDL_GetTicks(), SDL_GetPerformanceCounter());
+  }
+
+  // Input may change anything on screen, only pointer motion never does
+  redraw = redraw || (event.type != SDL_MOUSEMOTION);
   switch (event.type)
   {
     case SDL_QUIT:
       quit = true;
       break;
 
+    case SDL_WINDOWEVENT:
+      if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+      {
+        Resize({ event.window.data1, event.window.data2 });
+      }
+      break;
+
     case SDL_MOUSEBUTTONDOWN:
     {
       Position const mousePos = {
@@ -339,29 +942,40 @@ void Game::HandleEvent(void)
       }
       else if (onePlayer.IsOnPosition(mousePos))
       {
-        if ((state != State::Running) && (checkedOnePlayer == false))
+        if ((state != State::Running) && (checkedOnePlayer == false) && (!pSession))
         {
-          (void)Mix_PlayChannel(-1, pSquashSound, 0);
+          engine.GetAudio().Play(squashSound.GetSound());
           checkedOnePlayer = true;
-          checked.SetPosition(ConvertFullHd(POS_CHECKED_1P));
+          checked.SetPosition(layout.checkedOnePlayerPosition);
         }
       }
       else if (twoPlayer.IsOnPosition(mousePos))
       {
         if ((state != State::Running) && (checkedOnePlayer == true))
         {
-          (void)Mix_PlayChannel(-1, pSquashSound, 0);
+          engine.GetAudio().Play(squashSound.GetSound());
           checkedOnePlayer = false;
-          checked.SetPosition(ConvertFullHd(POS_CHECKED_2P));
+          checked.SetPosition(layout.checkedTwoPlayerPosition);
         }
       }
+      else if ((state != State::Init) && camera.IsOnViewport(mousePos))
+      {
+        // Pan to the clicked cell, the camera stays there until a snake is followed again
+        camera.LookAt(mousePos);
+      }
       break;
     }
 
+    case SDL_MOUSEWHEEL:
+      camera.Zoom(event.wheel.y);
+      ApplyCellScale();
+      break;
+
     case SDL_TEXTINPUT:
       if ((state == State::NewHighscore) && (newHighscoreName.length() < 16U))
       {
         newHighscoreName.append(event.text.text);
+        UpdateHighscoreNameDisplay();
       }
       break;
 
@@ -372,6 +986,7 @@ void Game::HandleEvent(void)
           if ((state == State::NewHighscore) && (!newHighscoreName.empty()))
           {
             newHighscoreName.pop_back();
+            UpdateHighscoreNameDisplay();
           }
           break;
 
@@ -383,6 +998,10 @@ void Game::HandleEvent(void)
           }
           break;
 
+        case SDLK_TAB:
+          FollowNextSnake();
+          break;
+
         case SDLK_SPACE:
           if ((state == State::Init) || (state == State::GameOver) )
           {
@@ -391,59 +1010,53 @@ void Game::HandleEvent(void)
           break;
 
         case SDLK_UP:
-          if ((players[0].snakeDirection == Direction::Left) || (players[0].snakeDirection == Direction::Right))
-          {
-            players[0].pressedDirection = Direction::Up;
-          }
+          Steer(0UL, Simulation::Direction::Up);
           break;
 
         case SDLK_DOWN:
-          if ((players[0].snakeDirection == Direction::Left) || (players[0].snakeDirection == Direction::Right))
-          {
-            players[0].pressedDirection = Direction::Down;
-          }
+          Steer(0UL, Simulation::Direction::Down);
           break;
 
         case SDLK_LEFT:
-          if ((players[0].snakeDirection == Direction::Up) || (players[0].snakeDirection == Direction::Down))
-          {
-            players[0].pressedDirection = Direction::Left;
-          }
+          Steer(0UL, Simulation::Direction::Left);
+          Scrub(-1);
           break;
 
         case SDLK_RIGHT:
-          if ((players[0].snakeDirection == Direction::Up) || (players[0].snakeDirection == Direction::Down))
-          {
-            players[0].pressedDirection = Direction::Right;
-          }
+          Steer(0UL, Simulation::Direction::Right);
+          Scrub(1);
+          break;
+
+        case SDLK_PAGEUP:
+          Scrub(-REWIND_PAGE_TICKS);
+          break;
+
+        case SDLK_PAGEDOWN:
+          Scrub(REWIND_PAGE_TICKS);
+          break;
+
+        case SDLK_HOME:
+          Scrub(-static_cast<int64_t>(REWIND_TICKS));
+          break;
+
+        case SDLK_END:
+          Scrub(static_cast<int64_t>(REWIND_TICKS));
           break;
 
         case SDLK_w:
-          if ((players[1].snakeDirection == Direction::Left) || (players[1].snakeDirection == Direction::Right))
-          {
-            players[1].pressedDirection = Direction::Up;
-          }
+          Steer(1UL, Simulation::Direction::Up);
           break;
 
         case SDLK_s:
-          if ((players[1].snakeDirection == Direction::Left) || (players[1].snakeDirection == Direction::Right))
-          {
-            players[1].pressedDirection = Direction::Down;
-          }
+          Steer(1UL, Simulation::Direction::Down);
           break;
 
         case SDLK_a:
-          if ((players[1].snakeDirection == Direction::Up) || (players[1].snakeDirection == Direction::Down))
-          {
-            players[1].pressedDirection = Direction::Left;
-          }
+          Steer(1UL, Simulation::Direction::Left);
           break;
 
         case SDLK_d:
-          if ((players[1].snakeDirection == Direction::Up) || (players[1].snakeDirection == Direction::Down))
-          {
-            players[1].pressedDirection = Direction::Right;
-          }
+          Steer(1UL, Simulation::Direction::Right);
           break;
 
         default:
@@ -459,7 +1072,13 @@ void Game::HandleEvent(void)
 
 void Game::HandleGame(void)
 {
-  if (state != State::Running)
+  if (pSession && pSession->Poll())
+  {
+    // The host started a new network match
+    BeginMatch();
+  }
+
+  if ((state != State::Running) && verdictReported)
   {
     return;
   }
@@ -467,149 +1086,287 @@ void Game::HandleGame(void)
   uint64_t const deltaTime_ms = ((currentTick - lastGameHandleTick) * 1000UL) / SDL_GetPerformanceFrequency();
   if (deltaTime_ms >= SNAKE_MOVE_PERIOD_MS)
   {
+    uint64_t const deltaTime_us = ((currentTick - lastGameHandleTick) * 1000000UL) / SDL_GetPerformanceFrequency();
+    Metrics::Observe(Metrics::Histogram::TickLateness, deltaTime_us - SNAKE_MOVE_PERIOD_MS * 1000UL);
     lastGameHandleTick = currentTick;
-    ++numberOfMoves;
-
-    // Update and validate new snake's head positions
-    std::array<Position, 2> snakeHeadpos = { Position{ 0 }, Position{ 0 } };
-    for (size_t i = 0UL; i < players.size(); ++i)
+    uint64_t const tickBegin = SDL_GetPerformanceCounter();
+
+    // Bursts start where the apple was eaten and where snakes died, which the step moves or removes
+    std::vector<Simulation::Snake> const & before = simulation.GetState().snakes;
+    Position const appleBefore = simulation.GetState().apple;
+    std::array<Position, Simulation::MAX_PLAYERS> headsBefore;
+    uint64_t aliveBefore = 0UL;
+    for (size_t i = 0UL; i < before.size(); ++i)
     {
-      snakeHeadpos[i] = players[i].snake.front();
-
-      players[i].snakeDirection = players[i].pressedDirection;
+      headsBefore[i] = (before[i].length > 0U) ? before[i].Head() : Position{ 0, 0 };
+      aliveBefore |= before[i].alive ? (static_cast<uint64_t>(1U) << i) : 0UL;
+    }
 
-      switch (players[i].snakeDirection)
+    Simulation::Events events = { false, false, false };
+    bool const stepped = !pSession || pSession->CanAdvance();
+    if (!pSession)
+    {
+      // All arena snakes except player 1 are bots, plugins may take over any player
+      std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+      if ((arenaPlayers > 0UL) || pBotPlugins)
       {
-        case Direction::Up:
-          snakeHeadpos[i].y -= 1;
-          break;
-
-        case Direction::Down:
-          snakeHeadpos[i].y += 1;
-          break;
-
-        case Direction::Left:
-          snakeHeadpos[i].x -= 1;
-          break;
-
-        case Direction::Right:
-          snakeHeadpos[i].x += 1;
-          break;
+        boardAnalysis.Analyze(simulation.GetState().field, simulation.GetSize());
       }
-
-      if (   (snakeHeadpos[i].x >= FIELD_WIDTH)
-          || (snakeHeadpos[i].x < 0)
-          || (snakeHeadpos[i].y >= FIELD_HEIGHT)
-          || (snakeHeadpos[i].y < 0)
-          || (field[snakeHeadpos[i].x][snakeHeadpos[i].y] != Field::Free))
+      if (pBotPlugins)
+      {
+        pBotPlugins->BeginTick(simulation);
+      }
+      for (size_t i = 0UL; i < snakes.size(); ++i)
       {
-        (void)Mix_PlayChannel(-1, pPunchSound, 0);
-        players[i].snakeHead.SetTexture(players[i].pSnakeHeadDead);
-        if (snakeHeadpos[0] == snakeHeadpos[1])
+        if (!snakes[i].alive)
         {
-          // Kill also player 0 if both players hit themself with their head
-          players[0].snakeHead.SetTexture(players[0].pSnakeHeadDead);
+          continue;
         }
-        if (scoreCount > highscoreEntries.back().score)
+        Simulation::Direction direction = snakes[i].pressedDirection;
+        if (pBotPlugins && pBotPlugins->Decide(i, direction))
         {
-          newHighscoreName.clear();
-          state = State::NewHighscore;
-          (void)Mix_PlayChannel(-1, pCheerSound, 0);
+          simulation.SetPressedDirection(i, direction);
         }
-        else
+        else if (((arenaPlayers > 0UL) && (i > 0UL)) || (pBotPlugins && pBotPlugins->Controls(i)))
         {
-          state = State::GameOver;
+          // Also stands in for late and demoted plugins
+          simulation.SetPressedDirection(i, ChooseBotDirection(simulation, boardAnalysis, i));
         }
       }
-      else
+      events = simulation.Step();
+      rewind.Record(simulation.GetState());
+      if (pSpectatorFeed)
       {
-        AddSnakeHead(players[i], snakeHeadpos[i]);
+        pSpectatorFeed->Publish(rewind, simulation.GetState().numberOfMoves);
       }
+    }
+    else if (stepped)
+    {
+      // Remote snake is predicted, late inputs are corrected by rollbacks
+      events = pSession->Advance();
+    }
+    if (stepped && pLatencyTracer)
+    {
+      pLatencyTracer->Reach(LatencyTracer::Stage::Tick, SDL_GetPerformanceCounter());
+    }
+    Metrics::Observe(Metrics::Histogram::TickDuration,
+                     ((SDL_GetPerformanceCounter() - tickBegin) * 1000000UL) / SDL_GetPerformanceFrequency());
+    Metrics::Add(Metrics::Counter::Ticks);
+    redraw = true;
 
-      if (singlePlayer)
+    std::vector<Simulation::Snake> const & after = simulation.GetState().snakes;
+    if (events.death && (state == State::Running))
+    {
+      engine.GetAudio().Play(punchSound.GetSound());
+      for (size_t i = 0UL; i < after.size(); ++i)
       {
-        // Only handle player 0 for single player mode
-        break;
+        if ((((aliveBefore >> i) & 1UL) != 0UL) && !after[i].alive)
+        {
+          EmitBurst(headsBefore[i], DEATH_PARTICLES, SNAKE_RED, 16.0F);
+        }
       }
     }
 
-    // At least one snake died
-    if (state != State::Running)
+    if (events.bite)
     {
-      // Update game over text for two player game
-      engine.DestroyTexture(pGameOverTwoPlayers);
-      char const * const pGameOverText =
-        (   (players[0].snakeHead.GetTexture() == players[0].pSnakeHead)
-         && (players[1].snakeHead.GetTexture() == players[1].pSnakeHeadDead)) ? "Player 1 wins!" :
-        (   (players[0].snakeHead.GetTexture() == players[0].pSnakeHeadDead)
-         && (players[1].snakeHead.GetTexture() == players[1].pSnakeHead))     ? "Player 2 wins!" :
-                                                                                "   Draw Game!";
-      pGameOverTwoPlayers = engine.CreateTextTexture(pGameOverText, pFontGameOver2P, WHITE);
-      gameOverTwoPlayers.SetTexture(pGameOverTwoPlayers);
-      gameOverTwoPlayers.SetScale(ConvertFullHd(gameOverTwoPlayers.GetTextureSize()));
-
-      return;
+      engine.GetAudio().Play(biteSound.GetSound());
+      UpdateScoreDisplay();
+
+      // Items only bite for player one, apples for whoever reached them
+      std::vector<Simulation::Snake>::const_iterator const eater =
+        std::find_if(after.begin(), after.end(),
+                     [&appleBefore](Simulation::Snake const & snake){ return snake.alive && (snake.Head() == appleBefore); });
+      EmitBurst((eater != after.end()) ? appleBefore : after[0].Head(), BITE_PARTICLES, RED, 8.0F);
     }
 
-    // Valid new positions, so handle snake's tail
-    for (size_t i = 0UL; i < players.size(); ++i)
+    if (state == State::Running)
     {
-      if (   (singlePlayer)
-          && (apple.IsOnPosition({ fieldPosition.x + (snakeHeadpos[i].x * fieldGridScale.x) + (fieldGridScale.x / 2),
-                                    fieldPosition.y + (snakeHeadpos[i].y * fieldGridScale.y) + (fieldGridScale.x / 2) })))
+      bool const over = pSession ? pSession->IsConfirmedOver() : !simulation.GetState().running;
+      if (over)
       {
-        // Eat apple
-        (void)Mix_PlayChannel(-1, pBiteSound, 0);
-        RandomApplePosition();
-        ++scoreCount;
-        UpdateScoreDisplay();
-      }
-      else if (singlePlayer || ((numberOfMoves % 3UL) != 0UL))
-      {
-        RemoveSnakeTail(players[i]);
+        // At least one snake died
+        EndMatch();
       }
+    }
 
-      if (singlePlayer)
-      {
-        // Only handle player 0 for single player mode
-        break;
-      }
+    if (pSession && (state != State::Running))
+    {
+      HandleNetVerdict();
     }
+  }
+}
 
+
+void Game::HandleNetVerdict(void)
+{
+  RollbackSession::Verdict const verdict = pSession->GetVerdict();
+  if (verdict == RollbackSession::Verdict::Pending)
+  {
+    return;
   }
+
+  RollbackSession::Stats const & stats = pSession->GetStats();
+  std::cout << "match result "
+            << ((verdict == RollbackSession::Verdict::Identical) ? "identical on both peers" : "DESYNCED") << ", "
+            << stats.rollbacks << " rollbacks, max " << stats.maxRollbackTime_us << " us\n";
+  verdictReported = true;
 }
 
 
 void Game::RenderField(void)
 {
-  for (int line = 0; line < FIELD_WIDTH; ++line)
+  std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+  if ((followedSnake < snakes.size()) && (snakes[followedSnake].length > 0U))
+  {
+    camera.Follow(snakes[followedSnake].Head());
+  }
+
+  // Only the cells in view are drawn, so the cost depends on the screen and not on the board
+  Position const cellScale = camera.GetCellScale();
+  Position const first = camera.GetFirstVisibleCell();
+  Position const end = camera.GetEndVisibleCell();
+  auto const isVisible = [&first, &end](Position const & cell)
+  {
+    return (cell.x >= first.x) && (cell.x < end.x) && (cell.y >= first.y) && (cell.y < end.y);
+  };
+
+  // Draw Grid, the lighter cells are one rectangle below everything
+  engine.RenderRect(FieldToScreen(first), camera.GetViewportScale(), DARKBLUE);
+  for (int line = first.y; line < end.y; ++line)
   {
-    for (int column = 0; column < FIELD_HEIGHT; ++column)
+    for (int column = first.x; column < end.x; ++column)
     {
-      if (field[column][line] != Field::Free)
+      Simulation::Cell const cell = simulation.GetCell({ column, line });
+      if (cell > players.size())
+      {
+        // Draw arena snake
+        engine.RenderRect(FieldToScreen({ column, line }), cellScale, ArenaColor(cell - 1U));
+      }
+      else if (cell != Simulation::FREE)
       {
         // Draw Snake
-        engine.Render({ fieldPosition.x + (column * fieldGridScale.x),
-                        fieldPosition.y + (line * fieldGridScale.y)},
-                      fieldGridScale,
-                      players[(field[column][line] == Field::Snake0) ? 0 : 1].pSnakeSkin);
+        engine.Render(FieldToScreen({ column, line }), cellScale, players[cell - 1U].snakeSkinPic.GetTexture());
       }
-      else
+      else if (((line + column) % 2) != 0)
       {
-        // Draw Grid
-        engine.RenderRect({ fieldPosition.x + (column * fieldGridScale.x),
-                            fieldPosition.y + (line * fieldGridScale.y)},
-                          fieldGridScale,
-                          (((line + column) % 2) == 0) ? DARKBLUE : DARKERBLUE);
+        engine.RenderRect(FieldToScreen({ column, line }), cellScale, DARKERBLUE);
       }
     }
   }
 
-  engine.Render(players[0].snakeHead);
-  if (singlePlayer)
-    engine.Render(apple);
-  else
-   engine.Render(players[1].snakeHead);
+  // Items in one batch of diamonds per type, counted first to take just enough of the frame arena
+  ItemLayer const & items = simulation.GetState().items;
+  int const boardWidth = simulation.GetSize().x;
+  std::array<size_t, ItemLayer::NUMBER_OF_TYPES> itemCounts = {};
+  for (size_t i = 0UL; i < items.GetNumberOfItems(); ++i)
+  {
+    ItemLayer::Item const & item = items.GetItem(i);
+    itemCounts[static_cast<size_t>(item.type)] += isVisible({ item.cell % boardWidth, item.cell / boardWidth }) ? 1UL : 0UL;
+  }
+  SDL_Color const itemColors[ItemLayer::NUMBER_OF_TYPES] = { RED, GOLD, WHITE };
+  Position const inset = { cellScale.x / 6, cellScale.y / 6 };
+  for (size_t type = 0UL; type < ItemLayer::NUMBER_OF_TYPES; ++type)
+  {
+    if (itemCounts[type] == 0UL)
+    {
+      continue;
+    }
+
+    Position* const pVertices = engine.GetFrameArena().Allocate<Position>(itemCounts[type] * 6UL);
+    size_t vertex = 0UL;
+    for (size_t i = 0UL; i < items.GetNumberOfItems(); ++i)
+    {
+      ItemLayer::Item const & item = items.GetItem(i);
+      Position const cell = { item.cell % boardWidth, item.cell / boardWidth };
+      if ((static_cast<size_t>(item.type) != type) || !isVisible(cell))
+      {
+        continue;
+      }
+
+      Position const corner = FieldToScreen(cell);
+      Position const top = { corner.x + cellScale.x / 2, corner.y + inset.y };
+      Position const right = { corner.x + cellScale.x - inset.x, corner.y + cellScale.y / 2 };
+      Position const bottom = { corner.x + cellScale.x / 2, corner.y + cellScale.y - inset.y };
+      Position const left = { corner.x + inset.x, corner.y + cellScale.y / 2 };
+      pVertices[vertex++] = top;
+      pVertices[vertex++] = right;
+      pVertices[vertex++] = bottom;
+      pVertices[vertex++] = bottom;
+      pVertices[vertex++] = left;
+      pVertices[vertex++] = top;
+    }
+    engine.RenderGeometry(pVertices, vertex, itemColors[type]);
+  }
+
+  for (size_t i = 0UL; i < snakes.size(); ++i)
+  {
+    if ((snakes[i].length == 0U) || !isVisible(snakes[i].Head()))
+    {
+      // Dead arena snakes are removed from the board, heads out of view are not drawn
+      continue;
+    }
+
+    Player & player = players[i % players.size()];
+    player.snakeHead.SetPosition(FieldToScreen(snakes[i].Head()));
+    RenderPicture(player.snakeHead, snakes[i].alive ? player.snakeHeadPic : player.snakeHeadDeadPic);
+  }
+
+  if (simulation.HasApple() && isVisible(simulation.GetState().apple))
+  {
+    apple.SetPosition(FieldToScreen(simulation.GetState().apple));
+    RenderPicture(apple, applePic);
+  }
+}
+
+
+void Game::RenderMinimap(void)
+{
+  // Boards which fit into the field need no overview
+  Position const boardSize = simulation.GetSize();
+  Position const first = camera.GetFirstVisibleCell();
+  Position const end = camera.GetEndVisibleCell();
+  if ((end.x - first.x == boardSize.x) && (end.y - first.y == boardSize.y))
+  {
+    return;
+  }
+
+  // The texture is created once, its pixels are only replaced on ticks which changed cells
+  bool const changed = minimap.Update(simulation);
+  if (pMinimap == nullptr)
+  {
+    pMinimap = engine.CreatePixelTexture(minimap.GetPixels(), minimap.GetSize());
+  }
+  else if (changed)
+  {
+    engine.UpdatePixelTexture(pMinimap, minimap.GetPixels());
+  }
+
+  Position const area = layout.minimapScale;
+  Position const scale = (boardSize.x * area.y >= boardSize.y * area.x)
+                       ? Position{ area.x, area.x * boardSize.y / boardSize.x }
+                       : Position{ area.y * boardSize.x / boardSize.y, area.y };
+  engine.Render(layout.minimapPosition, scale, pMinimap);
+
+  auto const cellToMinimap = [this, &scale, &boardSize](Position const & cell)
+  {
+    return Position{ layout.minimapPosition.x + cell.x * scale.x / boardSize.x,
+                     layout.minimapPosition.y + cell.y * scale.y / boardSize.y };
+  };
+
+  if (simulation.HasApple())
+  {
+    Position const marker = { std::max(scale.x / minimap.GetSize().x, 3), std::max(scale.y / minimap.GetSize().y, 3) };
+    engine.RenderRect(cellToMinimap(simulation.GetState().apple), marker, RED);
+  }
+
+  // Outline of the camera's window
+  Position const topLeft = cellToMinimap(first);
+  Position const bottomRight = cellToMinimap(end);
+  int const line = std::max(scale.x / 150, 1);
+  engine.RenderRect(topLeft, { bottomRight.x - topLeft.x, line }, WHITE);
+  engine.RenderRect({ topLeft.x, bottomRight.y - line }, { bottomRight.x - topLeft.x, line }, WHITE);
+  engine.RenderRect(topLeft, { line, bottomRight.y - topLeft.y }, WHITE);
+  engine.RenderRect({ bottomRight.x - line, topLeft.y }, { line, bottomRight.y - topLeft.y }, WHITE);
 }
 
 
@@ -620,13 +1377,14 @@ void Game::Render(void)
   if (state != State::Init)
   {
     RenderField();
+    RenderMinimap();
   }
 
   if (state == State::GameOver)
   {
     if (singlePlayer)
     {
-      engine.Render(gameOver);
+      RenderPicture(gameOver, gameOverPic);
     }
     else
     {
@@ -638,13 +1396,16 @@ void Game::Render(void)
   {
     RenderInputForNewHighscore();
   }
+
+  // All bursts on top in one draw call
+  particles.Render(engine);
 }
 
 
 void Game::HandlePlanePosition(void)
 {
   uint64_t const deltaTime_ms = ((currentTick - lastHighScoreHandleTick) * 1000UL) / SDL_GetPerformanceFrequency();
-  if (deltaTime_ms >= 10UL)
+  if (deltaTime_ms >= PLANE_MOVE_PERIOD_MS)
   {
     lastHighScoreHandleTick = currentTick;
 
@@ -654,36 +1415,33 @@ void Game::HandlePlanePosition(void)
                         plane.GetPosition().y });
 
     highscores.SetPosition({ plane.GetPosition().x + plane.GetScale().x,
-                             plane.GetPosition().y + ConvertFullHdHeight(45) });
+                             plane.GetPosition().y + layout.bannerTextOffset });
+
+    // The banner flies through a gap off the screen, moves there change nothing visible
+    redraw = redraw || ((plane.GetPosition().x <= resolution.x) && (highscores.GetPosition().x + highscores.GetScale().x >= -1));
   }
 }
 
 
 void Game::RenderPlane(void)
 {
-  engine.Render(plane);
+  RenderPicture(plane, planePic);
 
   Position const bannerPos = { plane.GetPosition().x + plane.GetScale().x,
-                               plane.GetPosition().y + ConvertFullHdHeight(26) };
-  Position const bannerScale = { highscores.GetScale().x + ConvertFullHdWidth(20),
-                                 ConvertFullHdHeight(72) };
+                               plane.GetPosition().y + layout.bannerOffset };
+  Position const bannerScale = { highscores.GetScale().x + layout.bannerPadding,
+                                 layout.bannerHeight };
   engine.RenderRect(bannerPos, bannerScale, bannerBgColor);
 
-  std::vector<Position> const bannerTailTop =
-  {{
-    { bannerPos.x + bannerScale.x,      bannerPos.y },
-    { bannerPos.x + bannerScale.x + ConvertFullHdWidth(50), bannerPos.y },
-    { bannerPos.x + bannerScale.x,      bannerPos.y + bannerScale.y / 2 },
-  }};
-  engine.RenderGeometry(bannerTailTop, bannerBgColor);
-
-  std::vector<Position> const bannerTailBottom =
-  {{
-    { bannerPos.x + bannerScale.x,      bannerPos.y + bannerScale.y / 2 },
-    { bannerPos.x + bannerScale.x + ConvertFullHdWidth(50), bannerPos.y + bannerScale.y },
-    { bannerPos.x + bannerScale.x,      bannerPos.y + bannerScale.y },
-  }};
-  engine.RenderGeometry(bannerTailBottom, bannerBgColor);
+  // Both triangles of the banner tail in one batch
+  Position* const pBannerTail = engine.GetFrameArena().Allocate<Position>(6UL);
+  pBannerTail[0] = { bannerPos.x + bannerScale.x,      bannerPos.y };
+  pBannerTail[1] = { bannerPos.x + bannerScale.x + layout.bannerTailWidth, bannerPos.y };
+  pBannerTail[2] = { bannerPos.x + bannerScale.x,      bannerPos.y + bannerScale.y / 2 };
+  pBannerTail[3] = { bannerPos.x + bannerScale.x,      bannerPos.y + bannerScale.y / 2 };
+  pBannerTail[4] = { bannerPos.x + bannerScale.x + layout.bannerTailWidth, bannerPos.y + bannerScale.y };
+  pBannerTail[5] = { bannerPos.x + bannerScale.x,      bannerPos.y + bannerScale.y };
+  engine.RenderGeometry(pBannerTail, 6UL, bannerBgColor);
 
   engine.Render(highscores);
 }
@@ -691,20 +1449,15 @@ void Game::RenderPlane(void)
 
 void Game::RenderInputForNewHighscore(void)
 {
-  engine.RenderRect(gameOver.GetPosition() - ConvertFullHd({ 10, 10 }),
-                    gameOver.GetScale() + ConvertFullHd({ 20, 20 }),
-                    GOLD);
+  engine.RenderRect(layout.highscoreFramePosition, layout.highscoreFrameScale, GOLD);
   engine.RenderRect(gameOver.GetPosition(), gameOver.GetScale(), BLACK);
-  engine.Render(trophy);
+  RenderPicture(trophy, trophyPic);
   engine.Render(newHighscore);
+  engine.Render(highscoreRank);
   engine.Render(enterName);
 
   // Render player input
-  SDL_Texture* const pNewHSName(engine.CreateTextTexture(newHighscoreName.c_str(), pFontStandard, GOLD));
-  Entity newHSName(pNewHSName, gameOver.GetPosition() + ConvertFullHd({ 300, 300 }));
-  newHSName.SetScale(ConvertFullHd(newHSName.GetTextureSize()));
-  engine.Render(newHSName);
-  engine.DestroyTexture(pNewHSName);
+  engine.Render(highscoreName);
 }
 
 
@@ -712,88 +1465,26 @@ void Game::UpdateHighscoreBanner(void)
 {
   engine.DestroyTexture(pHighscores);
   highscoresStr = "Highscores:  ";
-  for (uint8_t i = 0U; i < highscoreEntries.size(); ++i)
+  std::vector<HighscoreStore::Entry> const top = highscoreStore.Top(highscoreTable, NUMBER_OF_SHOWN_HIGHSCORES);
+  for (uint8_t i = 0U; i < NUMBER_OF_SHOWN_HIGHSCORES; ++i)
   {
     highscoresStr.append("#");
     highscoresStr.append(std::to_string(i + 1U));
     highscoresStr.append("  ");
-    highscoresStr.append(highscoreEntries[i].name);
+    highscoresStr.append((i < top.size()) ? top[i].name : "-");
     highscoresStr.append(" (");
-    highscoresStr.append(std::to_string(highscoreEntries[i].score));
+    highscoresStr.append(std::to_string((i < top.size()) ? top[i].score : 0U));
     highscoresStr.append(")    ");
   }
-  pHighscores = engine.CreateTextTexture(highscoresStr.c_str(), pFontHighscores, bannerTxtColor);
+  pHighscores = engine.CreateTextTexture(highscoresStr.c_str(), fontHighscores.GetFont(), bannerTxtColor);
   highscores.SetTexture(pHighscores);
-  highscores.SetScale(ConvertFullHd(highscores.GetTextureSize()));
+  highscores.SetScale(highscores.GetTextureSize());
 }
 
 
-void Game::StoreHighscores()
-{
-  std::ofstream file(HIGHSCORE_PATH);
-  for (auto highscoreEntry : highscoreEntries)
-  {
-    file << highscoreEntry.name << ";" << highscoreEntry.score << "\n";
-  }
-  file.close();
-}
-
 void Game::ApplyNewHighscore(void)
 {
-  highscoreEntries.back().name = newHighscoreName;
-  highscoreEntries.back().score = scoreCount;
-  std::sort(highscoreEntries.begin(),
-            highscoreEntries.end(),
-            [](HighscoreEntry const & a, HighscoreEntry const & b){ return a.score > b.score; });
-  StoreHighscores();
+  // Written to the journal in the background, never stalls a frame
+  highscoreStore.Add(highscoreTable, newHighscoreName, simulation.GetState().scoreCount);
   UpdateHighscoreBanner();
 }
-
-
-void Game::ApplyStoredHighscores(void)
-{
-  std::ifstream file(HIGHSCORE_PATH);
-  if (file.is_open())
-  {
-    for (HighscoreEntry & highscoreEntry : highscoreEntries)
-    {
-      std::getline(file, highscoreEntry.name, ';');
-      std::string score;
-      std::getline(file, score, '\n');
-      try
-      {
-        highscoreEntry.score = std::stoul(score);
-      }
-      catch (...)
-      {
-        highscoreEntry.score = 0U;
-      }
-    }
-    file.close();
-  }
-  else
-  {
-    // No highscores present, so store default highscores
-    StoreHighscores();
-  }
-  UpdateHighscoreBanner();
-}
-
-
-Position Game::ConvertFullHd(Position const & fhdPosition)
-{
-  return { static_cast<int>(static_cast<float>(resolution.x) / 1920.0 * static_cast<float>(fhdPosition.x)),
-           static_cast<int>(static_cast<float>(resolution.y) / 1080.0 * static_cast<float>(fhdPosition.y)) };
-}
-
-
-int Game::ConvertFullHdWidth(int const fhdWidth)
-{
-  return static_cast<int>(static_cast<float>(resolution.x) / 1920.0 * static_cast<float>(fhdWidth));
-}
-
-
-int Game::ConvertFullHdHeight(int const fhdHeight)
-{
-  return static_cast<int>(static_cast<float>(resolution.y) / 1080.0 * static_cast<float>(fhdHeight));
-}
\ No newline at end of file
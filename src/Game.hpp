@@ -1,34 +1,45 @@
 #pragma once
 
+#include "BoardAnalysis.hpp"
+#include "Camera.hpp"
 #include "Engine.hpp"
 #include "Entity.hpp"
+#include "HighscoreStore.hpp"
+#include "Layout.hpp"
+#include "Minimap.hpp"
+#include "ParticleSystem.hpp"
 #include "Position.hpp"
+#include "ResourceManager.hpp"
+#include "RewindBuffer.hpp"
+#include "Simulation.hpp"
 #include <SDL_pixels.h>
-#include <deque>
 #include <string>
 #include <array>
 #include <cstdint>
+#include <memory>
 
 typedef struct _Mix_Music Mix_Music;
-typedef struct Mix_Chunk Mix_Chunk;
+
+struct Options;
+class AllocationSelftest;
+class BotPlugins;
+class FrameCapture;
+class LatencyTracer;
+class NetLink;
+class RollbackSession;
+class Soak;
+class SpectatorFeed;
 
 class Game
 {
 public:
-  Game(Position const & res = { 0, 0 });
+  Game(Options const & options);
   ~Game(void);
 
-  void Run(void);
+  // Nonzero when a soak or the allocation selftest failed
+  int Run(void);
 
 private:
-  enum class Direction
-  {
-    Up,
-    Down,
-    Left,
-    Right
-  };
-
   enum class State
   {
     Init,
@@ -37,121 +48,161 @@ private:
     NewHighscore
   };
 
-  enum class Field
-  {
-    Free,
-    Snake0,
-    Snake1
-  };
-
-  struct HighscoreEntry
-  {
-    std::string name;
-    uint16_t score;
-  };
-
   struct Player
   {
-    Player(SDL_Texture* const pSnakeHead, SDL_Texture* const pSnakeHeadDead, SDL_Texture* const pSnakeSkin,
-           Position const & fieldGridScale, Field const fieldMarker)
-    : snake()
-    , snakeDirection(Direction::Up)
-    , pressedDirection(Direction::Up)
-    , pSnakeHead(pSnakeHead)
-    , pSnakeHeadDead(pSnakeHeadDead)
-    , pSnakeSkin(pSnakeSkin)
-    , snakeHead(pSnakeHead, { 0, 0 }, { fieldGridScale.x, static_cast<int>(fieldGridScale.y * 163.0 / 104.0) })
-    , fieldMarker(fieldMarker)
+    Player(ResourceManager::Handle const & snakeHeadPic, ResourceManager::Handle const & snakeHeadDeadPic,
+           ResourceManager::Handle const & snakeSkinPic, Position const & snakeHeadScale)
+    : snakeHeadPic(snakeHeadPic)
+    , snakeHeadDeadPic(snakeHeadDeadPic)
+    , snakeSkinPic(snakeSkinPic)
+    , snakeHead(nullptr, { 0, 0 }, snakeHeadScale)
     {
     }
 
-    std::deque<Position> snake;
-    Direction snakeDirection;
-    Direction pressedDirection;
-    SDL_Texture* pSnakeHead;
-    SDL_Texture* pSnakeHeadDead;
-    SDL_Texture* pSnakeSkin;
+    ResourceManager::Handle snakeHeadPic;
+    ResourceManager::Handle snakeHeadDeadPic;
+    ResourceManager::Handle snakeSkinPic;
     Entity snakeHead;
-    Field fieldMarker;
   };
 
-  static int constexpr FIELD_WIDTH = 19;
-  static int constexpr FIELD_HEIGHT = 19;
   static double constexpr SCORE_ANGLE = 10.0;
   static uint64_t constexpr SNAKE_MOVE_PERIOD_MS = 100UL;
-  static char constexpr HIGHSCORE_PATH[] = "./highscores.txt";
-  static Position constexpr POS_CHECKED_1P = { 12, 140 };
-  static Position constexpr POS_CHECKED_2P = { 12, 200 };
+  static uint64_t constexpr PLANE_MOVE_PERIOD_MS = 10UL;
+  // Ten minutes can be rewound, paging jumps ten seconds
+  static size_t constexpr REWIND_TICKS = 600000UL / SNAKE_MOVE_PERIOD_MS;
+  static int64_t constexpr REWIND_PAGE_TICKS = 10000L / static_cast<int64_t>(SNAKE_MOVE_PERIOD_MS);
+  static char constexpr HIGHSCORE_PATH[] = "./highscores.journal";
+  // Soaks keep their highscores apart from the players'
+  static char constexpr SOAK_HIGHSCORE_PATH[] = "./soak-highscores.journal";
+  static uint64_t constexpr SOAK_ACTION_PERIOD_MS = 200UL;
+  static uint16_t constexpr SOAK_MAX_HIGHSCORE = 25U;
+  // Particles per burst, a victory bursts from every fountain
+  static size_t constexpr BITE_PARTICLES = 400UL;
+  static size_t constexpr DEATH_PARTICLES = 3000UL;
+  static size_t constexpr VICTORY_PARTICLES = 6000UL;
+  static size_t constexpr VICTORY_FOUNTAINS = 5UL;
+  // Longer frames are simulated as this one, sparks do not jump after a stall
+  static float constexpr MAX_PARTICLE_STEP_S = 0.1F;
+  static char constexpr LEGACY_HIGHSCORE_PATH[] = "./highscores.txt";
+  static char constexpr MUSIC_PATH[] = "./res/sfx/music.mp3";
+  static size_t constexpr NUMBER_OF_SHOWN_HIGHSCORES = 3UL;
+  static int constexpr FONT_SIZE_TITLE = 64;
+  static int constexpr FONT_SIZE_BUTTON = 28;
+  static int constexpr FONT_SIZE_SCORE = 36;
+  static int constexpr FONT_SIZE_HIGHSCORES = 36;
+  static int constexpr FONT_SIZE_GAME_OVER_2P = 100;
+  static int constexpr FONT_SIZE_STANDARD = 36;
+  static int constexpr FONT_SIZE_STANDARD_SMALL = 24;
   static constexpr SDL_Color BLACK = { 0U, 0U, 0U };
   static constexpr SDL_Color WHITE = { 255U, 255U, 255U };
   static constexpr SDL_Color RED = { 180U, 0U, 0U };
   static constexpr SDL_Color GOLD = { 255, 215U, 0U };
   static constexpr SDL_Color DARKBLUE = { 0U, 0U, 50U };
   static constexpr SDL_Color DARKERBLUE = { 0U, 0U, 40U };
+  static constexpr SDL_Color SNAKE_GREEN = { 80U, 180U, 40U };
+  static constexpr SDL_Color SNAKE_RED = { 200U, 20U, 20U };
 
   Engine engine;
+  ResourceManager resources;
   Position resolution;
   State state;
   bool checkedOnePlayer;
   bool singlePlayer;
   bool quit;
-  uint16_t scoreCount;
-  size_t numberOfMoves;
-  Field field[FIELD_WIDTH][FIELD_HEIGHT];
-  Position fieldPosition;
-  Position fieldScale;
-  Position fieldGridScale;
+  // Something visible changed since the last frame, menus are only drawn then
+  bool redraw;
+  Simulation simulation;
+  BoardAnalysis boardAnalysis;
+  std::unique_ptr<NetLink> pNetLink;
+  std::unique_ptr<RollbackSession> pSession;
+  bool netHost;
+  bool verdictReported;
+  size_t arenaPlayers;
+  // Players decided by shared libraries instead of keys or the built-in bot
+  std::unique_ptr<BotPlugins> pBotPlugins;
+  std::unique_ptr<FrameCapture> pFrameCapture;
+  uint64_t captureTickPeriod;
+  Layout layout;
+  Camera camera;
+  size_t followedSnake;
+  Minimap minimap;
+  RewindBuffer rewind;
+  Simulation::State rewindState;
+  size_t rewindTick;
+  // Other processes watch local games through the records of the rewind buffer
+  std::unique_ptr<SpectatorFeed> pSpectatorFeed;
+  // Bursts of bites, deaths and victories, in screen coordinates
+  ParticleSystem particles;
+  uint64_t lastParticleTick;
+  // Plays the soak's script and checks that steady frames do not allocate, with --alloc-selftest only
+  std::unique_ptr<AllocationSelftest> pAllocationSelftest;
+  // Scripted input of a soak, steps count the actions since the last state change
+  std::unique_ptr<Soak> pSoak;
+  State soakState;
+  uint32_t soakStep;
+  uint64_t soakMoveBudget;
+  uint16_t soakTargetScore;
+  uint64_t soakSteeredMove;
+  uint64_t nextSoakAction_ms;
+  // Turn keys followed up to the screen, with --latency only
+  std::unique_ptr<LatencyTracer> pLatencyTracer;
 
   uint64_t currentTick;
   uint64_t lastGameHandleTick;
   uint64_t lastHighScoreHandleTick;
   std::string highscoresStr;
   std::string newHighscoreName;
-  std::array<HighscoreEntry, 3> highscoreEntries;
+  std::string highscoreRankText;
+  std::string gameOverText;
+  HighscoreStore highscoreStore;
+  std::string highscoreTable;
   SDL_Color bannerBgColor;
   SDL_Color bannerTxtColor;
 
   std::array<Player, 2> players;
 
-  // Fonts
-  TTF_Font* pFontTitle;
-  TTF_Font* pFontButton;
-  TTF_Font* pFontScore;
-  TTF_Font* pFontHighscores;
-  TTF_Font* pFontGameOver2P;
-  TTF_Font* pFontStandard;
-  TTF_Font* pFontStandardSmall;
+  // Fonts, in the size of the current layout
+  ResourceManager::Handle fontTitle;
+  ResourceManager::Handle fontButton;
+  ResourceManager::Handle fontScore;
+  ResourceManager::Handle fontHighscores;
+  ResourceManager::Handle fontGameOver2P;
+  ResourceManager::Handle fontStandard;
+  ResourceManager::Handle fontStandardSmall;
 
   // Font Textures
-  SDL_Texture* pBensGame;
-  SDL_Texture* pStart;
-  SDL_Texture* pOnePlayer;
-  SDL_Texture* pTwoPlayer;
-  SDL_Texture* pGameOverTwoPlayers;
-  SDL_Texture* pExit;
-  SDL_Texture* pScore;
-  SDL_Texture* pHighscores;
-  SDL_Texture* pNewHighScore;
-  SDL_Texture* pEnterName;
-  SDL_Texture* pVersion;
+  Texture* pBensGame;
+  Texture* pStart;
+  Texture* pOnePlayer;
+  Texture* pTwoPlayer;
+  Texture* pGameOverTwoPlayers;
+  Texture* pExit;
+  Texture* pScore;
+  Texture* pHighscores;
+  Texture* pNewHighScore;
+  Texture* pEnterName;
+  Texture* pHighscoreName;
+  Texture* pHighscoreRank;
+  Texture* pMinimap;
+  Texture* pVersion;
 
   // Pic Textures
-  SDL_Texture* pTitleBackground;
-  SDL_Texture* pChecked;
-  SDL_Texture* pArrows;
-  SDL_Texture* pWasd;
-  SDL_Texture* pApple;
-  SDL_Texture* pGameOver;
-  SDL_Texture* pPlane;
-  SDL_Texture* pTrophy;
+  ResourceManager::Handle titleBackgroundPic;
+  ResourceManager::Handle checkedPic;
+  ResourceManager::Handle arrowsPic;
+  ResourceManager::Handle wasdPic;
+  ResourceManager::Handle applePic;
+  ResourceManager::Handle gameOverPic;
+  ResourceManager::Handle planePic;
+  ResourceManager::Handle trophyPic;
 
   // Sounds
   Mix_Music* pMusic;
-  Mix_Chunk* pBiteSound;
-  Mix_Chunk* pPunchSound;
-  Mix_Chunk* pHornSound;
-  Mix_Chunk* pCheerSound;
-  Mix_Chunk* pSquashSound;
+  ResourceManager::Handle biteSound;
+  ResourceManager::Handle punchSound;
+  ResourceManager::Handle hornSound;
+  ResourceManager::Handle cheerSound;
+  ResourceManager::Handle squashSound;
 
   // Entities
   Entity bensGame;
@@ -172,27 +223,43 @@ private:
   Entity trophy;
   Entity newHighscore;
   Entity enterName;
+  Entity highscoreName;
+  Entity highscoreRank;
   Entity version;
 
+  void ReopenAudio(void);
   void Restart(void);
-  void AddSnakeHead(Player & player, Position const fieldpos);
-  void RemoveSnakeTail(Player & player);
+  void BeginMatch(void);
+  void EndMatch(void);
+  void Steer(size_t const player, Simulation::Direction const direction);
+  void Scrub(int64_t const ticks);
+  Position FieldToScreen(Position const & fieldpos) const;
+  void EmitBurst(Position const & cell, size_t const number, SDL_Color const & color, float const speed);
+  void UpdateParticles(void);
+  SDL_Color ArenaColor(size_t const player) const;
   void RenderBackground(void);
-  void RandomApplePosition(void);
   void UpdateScoreDisplay(void);
+  void UpdateGameOverDisplay(void);
+  void UpdateHighscoreNameDisplay(void);
+  void UpdateHighscoreRankDisplay(void);
+  void RenderPicture(Entity & entity, ResourceManager::Handle const & picture);
   void HandleEvent(void);
   void HandleGame(void);
+  void HandleNetVerdict(void);
   void RenderField(void);
+  void RenderMinimap(void);
   void Render(void);
   void HandlePlanePosition(void);
   void RenderPlane(void);
   void HandleNewHighscore(void);
   void RenderInputForNewHighscore(void);
   void UpdateHighscoreBanner(void);
-  void StoreHighscores();
   void ApplyNewHighscore(void);
-  void ApplyStoredHighscores(void);
-  Position ConvertFullHd(Position const & fhdPosition);
-  int ConvertFullHdWidth(int const fhdWidth);
-  int ConvertFullHdHeight(int const fhdHeight);
+  void Resize(Position const & res);
+  void RasterizeTexts(void);
+  void ApplyLayout(void);
+  void ApplyCellScale(void);
+  void FollowNextSnake(void);
+  void DriveSoak(void);
+  void PrepareSoakGame(void);
 };
\ No newline at end of file
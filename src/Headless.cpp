@@ -0,0 +1,119 @@
+#include "Headless.hpp"
+#include "BoardAnalysis.hpp"
+#include "AllocationCounter.hpp"
+#include "Bot.hpp"
+#include "BotPlugins.hpp"
+#include "Metrics.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+static uint64_t constexpr NOT_TRAPPED = std::numeric_limits<uint64_t>::max();
+
+int RunHeadless(Options const & options)
+{
+  size_t const numberOfPlayers = std::max(options.arenaPlayers, 1U);
+  Simulation simulation(options.boardSize);
+  uint64_t seed = 1UL;
+  simulation.Restart(numberOfPlayers, seed);
+
+  std::vector<uint32_t> tickDurations_ns;
+  tickDurations_ns.reserve(options.headlessTicks);
+  uint64_t games = 0UL;
+
+  // A snake is trapped once fewer free cells are reachable than its length
+  BoardAnalysis analysis;
+  BotPlugins plugins(options.botPlugins, options.botDeadline_us);
+  std::vector<uint64_t> trappedSince(numberOfPlayers, NOT_TRAPPED);
+  std::vector<uint8_t> alive(numberOfPlayers, 0U);
+  uint64_t deaths = 0UL;
+  uint64_t foreseenDeaths = 0UL;
+  uint64_t totalLeadTicks = 0UL;
+
+  Metrics::Set(Metrics::Gauge::ActiveMatches, 1L);
+  uint64_t allocations = GetThreadAllocations();
+  for (uint64_t tick = 0UL; tick < options.headlessTicks; ++tick)
+  {
+    std::chrono::steady_clock::time_point const begin = std::chrono::steady_clock::now();
+
+    // Every snake is a bot, a tick includes their decisions
+    std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+    analysis.Analyze(simulation.GetState().field, simulation.GetSize());
+    plugins.BeginTick(simulation);
+    for (size_t i = 0UL; i < snakes.size(); ++i)
+    {
+      if (snakes[i].alive)
+      {
+        Simulation::Direction direction = snakes[i].pressedDirection;
+        simulation.SetPressedDirection(i, plugins.Decide(i, direction) ? direction
+                                                                        : ChooseBotDirection(simulation, analysis, i));
+
+        // Remember when the current trap closed, escaping from it resets that
+        bool const trapped = analysis.GetReachableCells(snakes[i].Head()) < snakes[i].length;
+        trappedSince[i] = !trapped ? NOT_TRAPPED : std::min(trappedSince[i], tick);
+      }
+      alive[i] = snakes[i].alive;
+    }
+    Simulation::Events const events = simulation.Step();
+
+    tickDurations_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - begin).count());
+    Metrics::Observe(Metrics::Histogram::TickDuration, tickDurations_ns.back() / 1000U);
+    Metrics::Add(Metrics::Counter::Ticks);
+    Metrics::Add(Metrics::Counter::Allocations, GetThreadAllocations() - allocations);
+    allocations = GetThreadAllocations();
+
+    for (size_t i = 0UL; i < snakes.size(); ++i)
+    {
+      if (alive[i] && !snakes[i].alive)
+      {
+        ++deaths;
+        if (trappedSince[i] != NOT_TRAPPED)
+        {
+          ++foreseenDeaths;
+          totalLeadTicks += tick + 1UL - trappedSince[i];
+        }
+      }
+    }
+
+    if (events.over)
+    {
+      ++games;
+      Metrics::Add(Metrics::Counter::Games);
+      simulation.Restart(numberOfPlayers, ++seed);
+      std::fill(trappedSince.begin(), trappedSince.end(), NOT_TRAPPED);
+    }
+  }
+
+  Metrics::Set(Metrics::Gauge::ActiveMatches, 0L);
+
+  if (tickDurations_ns.empty())
+  {
+    return 0;
+  }
+
+  uint64_t total_ns = 0UL;
+  for (uint32_t const duration_ns : tickDurations_ns)
+  {
+    total_ns += duration_ns;
+  }
+  std::sort(tickDurations_ns.begin(), tickDurations_ns.end());
+
+  std::cout << tickDurations_ns.size() << " ticks, " << numberOfPlayers << " players, "
+            << options.boardSize.x << "x" << options.boardSize.y << " board, " << games << " games finished\n"
+            << "tick avg " << (total_ns / tickDurations_ns.size()) << " ns, "
+            << "p99 " << tickDurations_ns[tickDurations_ns.size() * 99U / 100U] << " ns, "
+            << "max " << tickDurations_ns.back() << " ns\n"
+            << deaths << " deaths, " << foreseenDeaths << " foreseen by trap detection";
+  if (foreseenDeaths > 0UL)
+  {
+    std::cout << ", " << (totalLeadTicks / foreseenDeaths) << " ticks ahead on average";
+  }
+  std::cout << "\n";
+
+  return 0;
+}
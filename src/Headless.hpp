@@ -0,0 +1,5 @@
+#pragma once
+
+struct Options;
+
+int RunHeadless(Options const & options);
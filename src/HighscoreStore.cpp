@@ -0,0 +1,390 @@
+#include "HighscoreStore.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static uint32_t RecordChecksum(char const * const pData, size_t const length)
+{
+  // FNV-1a, detects records torn by a crash in the middle of a write
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0UL; i < length; ++i)
+  {
+    hash = (hash ^ static_cast<uint8_t>(pData[i])) * 16777619U;
+  }
+  return hash;
+}
+
+
+static char const * FindLast(char const * const pData, size_t const length, char const character)
+{
+  for (size_t i = length; i > 0UL; --i)
+  {
+    if (pData[i - 1UL] == character)
+    {
+      return pData + i - 1UL;
+    }
+  }
+  return nullptr;
+}
+
+
+static void SyncFile(FILE* const pFile)
+{
+  fflush(pFile);
+#ifdef _WIN32
+  _commit(_fileno(pFile));
+#else
+  fsync(fileno(pFile));
+#endif
+}
+
+
+HighscoreStore::HighscoreStore(char const * const pJournalPath, char const * const pLegacyPath,
+                               std::string const & legacyTable)
+: journalPath(pJournalPath)
+, tables()
+, queueMutex()
+, queueCondition()
+, queue()
+, stopWriter(false)
+, writtenTables()
+, journalRecords(0UL)
+, compactionPending(false)
+, writer()
+{
+  Load(pLegacyPath, legacyTable);
+  writtenTables = tables;
+  writer = std::thread(&HighscoreStore::RunWriter, this);
+}
+
+
+HighscoreStore::~HighscoreStore(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stopWriter = true;
+  }
+  queueCondition.notify_one();
+
+  // Pending highscores are written before leaving
+  writer.join();
+}
+
+
+void HighscoreStore::Add(std::string const & table, std::string const & name, uint16_t const score)
+{
+  Record record = { table, name, score };
+  for (char & character : record.name)
+  {
+    // Tabs and line breaks are part of the journal's format
+    if ((character == '\t') || (character == '\n') || (character == '\r'))
+    {
+      character = ' ';
+    }
+  }
+
+  (void)Insert(tables, record);
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back(record);
+  }
+  queueCondition.notify_one();
+}
+
+
+void HighscoreStore::Remove(std::string const & table)
+{
+  // Journaled as a record without a name, names entered by players are never empty
+  Record const record = { table, "", 0U };
+  (void)Insert(tables, record);
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back(record);
+  }
+  queueCondition.notify_one();
+}
+
+
+std::vector<HighscoreStore::Entry> HighscoreStore::Top(std::string const & table, size_t const count) const
+{
+  std::vector<Entry> top;
+  std::map<std::string, Table>::const_iterator const found = tables.find(table);
+  if (found != tables.end())
+  {
+    for (auto entry = found->second.entries.begin();
+         (entry != found->second.entries.end()) && (top.size() < count);
+         ++entry)
+    {
+      top.push_back({ entry->second, entry->first });
+    }
+  }
+  return top;
+}
+
+
+size_t HighscoreStore::Rank(std::string const & table, uint16_t const score) const
+{
+  std::map<std::string, Table>::const_iterator const found = tables.find(table);
+  if (found == tables.end())
+  {
+    return 1UL;
+  }
+
+  // Entries with at most this score, summed up by the Fenwick tree
+  std::vector<uint32_t> const & scoreCounts = found->second.scoreCounts;
+  size_t atMost = 0UL;
+  for (size_t i = score + 1UL; i > 0UL; i -= i & (~i + 1UL))
+  {
+    atMost += scoreCounts[i];
+  }
+  return found->second.entries.size() - atMost + 1UL;
+}
+
+
+size_t HighscoreStore::Size(std::string const & table) const
+{
+  std::map<std::string, Table>::const_iterator const found = tables.find(table);
+  return (found != tables.end()) ? found->second.entries.size() : 0UL;
+}
+
+
+bool HighscoreStore::Insert(std::map<std::string, Table> & tables, Record const & record)
+{
+  if (record.name.empty())
+  {
+    (void)tables.erase(record.table);
+    return true;
+  }
+
+  Table & table = tables[record.table];
+  if (table.scoreCounts.empty())
+  {
+    table.scoreCounts.resize(SCORE_RANGE + 1UL, 0U);
+  }
+
+  table.entries.emplace(record.score, record.name);
+  for (size_t i = record.score + 1UL; i <= SCORE_RANGE; i += i & (~i + 1UL))
+  {
+    ++table.scoreCounts[i];
+  }
+
+  if (table.entries.size() <= MAX_ENTRIES_PER_TABLE)
+  {
+    return true;
+  }
+
+  // Table is full, forget the worst entry
+  auto const worst = std::prev(table.entries.end());
+  for (size_t i = worst->first + 1UL; i <= SCORE_RANGE; i += i & (~i + 1UL))
+  {
+    --table.scoreCounts[i];
+  }
+  table.entries.erase(worst);
+  return false;
+}
+
+
+size_t HighscoreStore::CountEntries(std::map<std::string, Table> const & tables)
+{
+  size_t entries = 0UL;
+  for (auto const & table : tables)
+  {
+    entries += table.second.entries.size();
+  }
+  return entries;
+}
+
+
+void HighscoreStore::Load(char const * const pLegacyPath, std::string const & legacyTable)
+{
+  std::ifstream journal(journalPath, std::ios::binary);
+  if (journal.is_open())
+  {
+    std::string const content((std::istreambuf_iterator<char>(journal)), std::istreambuf_iterator<char>());
+    size_t begin = 0UL;
+    while (begin < content.size())
+    {
+      size_t end = content.find('\n', begin);
+      Record record;
+      ++journalRecords;
+      if ((end == std::string::npos) || !Parse(content.data() + begin, end - begin, record))
+      {
+        // Torn or damaged record, rewrite the journal without it
+        compactionPending = true;
+      }
+      else if (!Insert(tables, record))
+      {
+        compactionPending = true;
+      }
+      begin = (end == std::string::npos) ? content.size() : end + 1UL;
+    }
+  }
+  else
+  {
+    // First start with a journal, take over the highscores of older versions
+    std::ifstream legacy(pLegacyPath);
+    std::string line;
+    while (std::getline(legacy, line))
+    {
+      size_t const separator = line.rfind(';');
+      if (separator == std::string::npos)
+      {
+        continue;
+      }
+      Record const record = { legacyTable, line.substr(0UL, separator),
+                              static_cast<uint16_t>(std::strtoul(line.c_str() + separator + 1UL, nullptr, 10)) };
+      // Older versions filled empty places with "-;0", those are no highscores
+      if ((record.name != "-") || (record.score != 0U))
+      {
+        Insert(tables, record);
+      }
+    }
+    compactionPending = true;
+  }
+
+  // Evicted entries and removed tables stay in the journal until it is compacted
+  compactionPending = compactionPending || (journalRecords > COMPACTION_FACTOR * CountEntries(tables) + COMPACTION_SLACK);
+}
+
+
+void HighscoreStore::RunWriter(void)
+{
+  FILE* pFile = nullptr;
+  std::unique_lock<std::mutex> lock(queueMutex, std::defer_lock);
+  while (true)
+  {
+    if (compactionPending)
+    {
+      if (pFile != nullptr)
+      {
+        fclose(pFile);
+      }
+      Compact();
+      compactionPending = false;
+      pFile = nullptr;
+    }
+    if (pFile == nullptr)
+    {
+      pFile = fopen(journalPath.c_str(), "ab");
+    }
+
+    lock.lock();
+    queueCondition.wait(lock, [this]{ return stopWriter || !queue.empty(); });
+    if (queue.empty())
+    {
+      break;
+    }
+    std::vector<Record> records;
+    records.swap(queue);
+    lock.unlock();
+
+    // Append only, a crash can at most tear the last record
+    if (pFile != nullptr)
+    {
+      for (Record const & record : records)
+      {
+        std::string const line = Serialize(record);
+        fwrite(line.data(), 1UL, line.size(), pFile);
+      }
+      SyncFile(pFile);
+    }
+
+    for (Record const & record : records)
+    {
+      (void)Insert(writtenTables, record);
+    }
+    journalRecords += records.size();
+    compactionPending = (journalRecords > COMPACTION_FACTOR * CountEntries(writtenTables) + COMPACTION_SLACK);
+  }
+
+  if (pFile != nullptr)
+  {
+    fclose(pFile);
+  }
+}
+
+
+void HighscoreStore::Compact(void)
+{
+  // Write a complete new journal aside, then replace the old one atomically
+  std::string const temporaryPath = journalPath + ".tmp";
+  FILE* const pFile = fopen(temporaryPath.c_str(), "wb");
+  if (pFile == nullptr)
+  {
+    return;
+  }
+
+  for (auto const & table : writtenTables)
+  {
+    for (auto const & entry : table.second.entries)
+    {
+      std::string const line = Serialize({ table.first, entry.second, entry.first });
+      fwrite(line.data(), 1UL, line.size(), pFile);
+    }
+  }
+  SyncFile(pFile);
+  fclose(pFile);
+
+  // Replacing has to be a single step on every platform, removing the journal first could lose it
+#ifdef _WIN32
+  bool const replaced = MoveFileExA(temporaryPath.c_str(), journalPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  bool const replaced = std::rename(temporaryPath.c_str(), journalPath.c_str()) == 0;
+#endif
+  if (replaced)
+  {
+    journalRecords = CountEntries(writtenTables);
+  }
+}
+
+
+std::string HighscoreStore::Serialize(Record const & record)
+{
+  std::string line = record.table + "\t" + record.name + "\t" + std::to_string(record.score);
+  char checksum[16];
+  snprintf(checksum, sizeof(checksum), "\t%08x\n", RecordChecksum(line.data(), line.size()));
+  line.append(checksum);
+  return line;
+}
+
+
+bool HighscoreStore::Parse(char const * pLine, size_t const length, Record & record)
+{
+  // <table> \t <name> \t <score> \t <checksum>
+  char const * const pEnd = pLine + length;
+  char const * const pChecksum = FindLast(pLine, length, '\t');
+  if ((pChecksum == nullptr) || ((pEnd - pChecksum) != 9))
+  {
+    return false;
+  }
+
+  char* pChecksumEnd = nullptr;
+  uint32_t const checksum = std::strtoul(pChecksum + 1, &pChecksumEnd, 16);
+  if ((pChecksumEnd != pEnd) || (checksum != RecordChecksum(pLine, pChecksum - pLine)))
+  {
+    return false;
+  }
+
+  char const * const pName = static_cast<char const *>(memchr(pLine, '\t', pChecksum - pLine));
+  char const * const pScore = FindLast(pLine, pChecksum - pLine, '\t');
+  if ((pName == nullptr) || (pScore == pName))
+  {
+    return false;
+  }
+
+  record.table.assign(pLine, pName);
+  record.name.assign(pName + 1, pScore);
+  record.score = static_cast<uint16_t>(std::strtoul(pScore + 1, nullptr, 10));
+  return true;
+}
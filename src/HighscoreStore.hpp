@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class HighscoreStore
+{
+public:
+  struct Entry
+  {
+    std::string name;
+    uint16_t score;
+  };
+
+  HighscoreStore(char const * const pJournalPath, char const * const pLegacyPath, std::string const & legacyTable);
+  ~HighscoreStore(void);
+
+  void Add(std::string const & table, std::string const & name, uint16_t const score);
+  void Remove(std::string const & table);
+  std::vector<Entry> Top(std::string const & table, size_t const count) const;
+  size_t Rank(std::string const & table, uint16_t const score) const;
+  size_t Size(std::string const & table) const;
+
+private:
+  static size_t constexpr MAX_ENTRIES_PER_TABLE = 1000000UL;
+  // The journal is compacted once it holds this many times more records than there are entries, plus a few
+  static size_t constexpr COMPACTION_FACTOR = 2UL;
+  static size_t constexpr COMPACTION_SLACK = 64UL;
+  static size_t constexpr SCORE_RANGE = 65536UL;
+
+  struct Record
+  {
+    std::string table;
+    std::string name;
+    uint16_t score;
+  };
+
+  struct Table
+  {
+    // Entries sorted by score, best first, plus a Fenwick tree over the scores for ranks
+    std::multimap<uint16_t, std::string, std::greater<uint16_t>> entries;
+    std::vector<uint32_t> scoreCounts;
+  };
+
+  std::string journalPath;
+  std::map<std::string, Table> tables;
+
+  // Shared with the writer thread
+  std::mutex queueMutex;
+  std::condition_variable queueCondition;
+  std::vector<Record> queue;
+  bool stopWriter;
+
+  // Owned by the writer thread once it runs, it compacts from its own copy of the tables
+  std::map<std::string, Table> writtenTables;
+  size_t journalRecords;
+  bool compactionPending;
+  std::thread writer;
+
+  static bool Insert(std::map<std::string, Table> & tables, Record const & record);
+  static size_t CountEntries(std::map<std::string, Table> const & tables);
+  void Load(char const * const pLegacyPath, std::string const & legacyTable);
+  void RunWriter(void);
+  void Compact(void);
+  static std::string Serialize(Record const & record);
+  static bool Parse(char const * pLine, size_t const length, Record & record);
+};
@@ -0,0 +1,208 @@
+#include "ItemLayer.hpp"
+#include <algorithm>
+
+// Lifetimes have to stay below one turn of the wheel
+static size_t constexpr WHEEL_SLOTS = 1024UL;
+// Spawn rates are items per tick and 2^20 cells
+static uint32_t constexpr SPAWN_RATE_SHIFT = 20U;
+
+struct TypeInfo
+{
+  uint32_t spawnRate;
+  uint32_t lifetime;
+};
+
+// About 190 apples, 3 golden apples and 20 scissors lie on a 128x128 board
+static std::array<TypeInfo, ItemLayer::NUMBER_OF_TYPES> constexpr TYPE_INFOS = {{
+  { 20U, 600U },
+  { 2U, 100U },
+  { 4U, 300U }
+}};
+
+static_assert(std::max({ TYPE_INFOS[0].lifetime, TYPE_INFOS[1].lifetime, TYPE_INFOS[2].lifetime }) < WHEEL_SLOTS,
+              "Items must expire within one turn of the wheel");
+
+ItemLayer::ItemLayer(void)
+: numberOfCells(0UL)
+, cellItems()
+, items()
+, wheel()
+, spawnCredits{}
+, changes()
+, reset(true)
+{
+}
+
+
+void ItemLayer::Reset(size_t const numberOfCells)
+{
+  this->numberOfCells = numberOfCells;
+  cellItems.assign(numberOfCells, NO_ITEM);
+  items.clear();
+  wheel.assign((numberOfCells > 0UL) ? WHEEL_SLOTS : 0UL, NO_ITEM);
+  spawnCredits.fill(0UL);
+  changes.clear();
+  reset = true;
+}
+
+
+bool ItemLayer::IsEnabled(void) const
+{
+  return numberOfCells > 0UL;
+}
+
+
+uint32_t ItemLayer::GetLifetime(Type const type)
+{
+  return TYPE_INFOS[static_cast<size_t>(type)].lifetime;
+}
+
+
+bool ItemLayer::Spawn(int32_t const cell, Type const type, uint64_t const expiry)
+{
+  if ((cellItems[cell] != NO_ITEM) || (items.size() >= MAX_ITEMS))
+  {
+    return false;
+  }
+
+  // New items go to the front of their slot's list
+  uint16_t const index = static_cast<uint16_t>(items.size());
+  uint16_t & slot = wheel[expiry & (WHEEL_SLOTS - 1UL)];
+  items.push_back({ cell, expiry, type, NO_ITEM, slot });
+  if (slot != NO_ITEM)
+  {
+    items[slot].previous = index;
+  }
+  slot = index;
+  cellItems[cell] = index;
+  changes.push_back({ cell, expiry, type, true });
+  return true;
+}
+
+
+bool ItemLayer::Take(int32_t const cell, Type & type)
+{
+  if (!HasItem(cell))
+  {
+    return false;
+  }
+
+  uint16_t const index = cellItems[cell];
+  type = items[index].type;
+  Remove(index);
+  return true;
+}
+
+
+void ItemLayer::Expire(uint64_t const tick)
+{
+  // Only the items of this tick's slot are visited, however many lie on the board
+  uint16_t index = wheel.empty() ? NO_ITEM : wheel[tick & (WHEEL_SLOTS - 1UL)];
+  while (index != NO_ITEM)
+  {
+    // Removing moves the last item, so the next one is found again by its cell
+    uint16_t const next = items[index].next;
+    int32_t const nextCell = (next != NO_ITEM) ? items[next].cell : -1;
+    if (items[index].expiry <= tick)
+    {
+      Remove(index);
+    }
+    index = (nextCell >= 0) ? cellItems[nextCell] : NO_ITEM;
+  }
+}
+
+
+uint32_t ItemLayer::TakeSpawns(Type const type)
+{
+  uint64_t & credit = spawnCredits[static_cast<size_t>(type)];
+  credit += static_cast<uint64_t>(numberOfCells) * TYPE_INFOS[static_cast<size_t>(type)].spawnRate;
+  uint32_t const spawns = static_cast<uint32_t>(credit >> SPAWN_RATE_SHIFT);
+  credit &= (static_cast<uint64_t>(1U) << SPAWN_RATE_SHIFT) - 1UL;
+  return spawns;
+}
+
+
+bool ItemLayer::HasItem(int32_t const cell) const
+{
+  return (static_cast<size_t>(cell) < cellItems.size()) && (cellItems[cell] != NO_ITEM);
+}
+
+
+size_t ItemLayer::GetNumberOfItems(void) const
+{
+  return items.size();
+}
+
+
+ItemLayer::Item const & ItemLayer::GetItem(size_t const index) const
+{
+  return items[index];
+}
+
+
+std::vector<ItemLayer::Change> const & ItemLayer::GetChanges(void) const
+{
+  return changes;
+}
+
+
+bool ItemLayer::IsReset(void) const
+{
+  return reset;
+}
+
+
+void ItemLayer::ClearChanges(void)
+{
+  changes.clear();
+  reset = false;
+}
+
+
+void ItemLayer::Remove(uint16_t const index)
+{
+  Item const removed = items[index];
+  Unlink(index);
+  cellItems[removed.cell] = NO_ITEM;
+  changes.push_back({ removed.cell, removed.expiry, removed.type, false });
+
+  // The last item fills the gap, its neighbours and cell follow it
+  uint16_t const last = static_cast<uint16_t>(items.size() - 1UL);
+  if (index != last)
+  {
+    Item & moved = items[index];
+    moved = items[last];
+    cellItems[moved.cell] = index;
+    if (moved.previous != NO_ITEM)
+    {
+      items[moved.previous].next = index;
+    }
+    else
+    {
+      wheel[moved.expiry & (WHEEL_SLOTS - 1UL)] = index;
+    }
+    if (moved.next != NO_ITEM)
+    {
+      items[moved.next].previous = index;
+    }
+  }
+  items.pop_back();
+}
+
+
+void ItemLayer::Unlink(uint16_t const index)
+{
+  Item const & item = items[index];
+  if (item.previous != NO_ITEM)
+  {
+    items[item.previous].next = item.next;
+  }
+  else
+  {
+    wheel[item.expiry & (WHEEL_SLOTS - 1UL)] = item.next;
+  }
+  if (item.next != NO_ITEM)
+  {
+    items[item.next].previous = item.previous;
+  }
+}
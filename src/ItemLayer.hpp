@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Items lying on board cells, found by cell in constant time and expired by a timing wheel
+class ItemLayer
+{
+public:
+  enum class Type : uint8_t
+  {
+    Apple,
+    GoldenApple,
+    Scissors
+  };
+  static size_t constexpr NUMBER_OF_TYPES = 3UL;
+
+  struct Item
+  {
+    int32_t cell;
+    uint64_t expiry;
+    Type type;
+    // Neighbours in the list of the wheel slot the item expires in
+    uint16_t previous;
+    uint16_t next;
+  };
+
+  // What a tick spawned and removed, rewinds replay these instead of storing all items
+  struct Change
+  {
+    int32_t cell;
+    uint64_t expiry;
+    Type type;
+    bool spawned;
+  };
+
+  ItemLayer(void);
+
+  // Removes all items, a layer without cells never holds any
+  void Reset(size_t const numberOfCells);
+  bool IsEnabled(void) const;
+
+  static uint32_t GetLifetime(Type const type);
+
+  bool Spawn(int32_t const cell, Type const type, uint64_t const expiry);
+  bool Take(int32_t const cell, Type & type);
+  void Expire(uint64_t const tick);
+  // Number of items of the type due this tick, their rate is given per cell
+  uint32_t TakeSpawns(Type const type);
+
+  bool HasItem(int32_t const cell) const;
+  size_t GetNumberOfItems(void) const;
+  Item const & GetItem(size_t const index) const;
+
+  std::vector<Change> const & GetChanges(void) const;
+  bool IsReset(void) const;
+  void ClearChanges(void);
+
+private:
+  static uint16_t constexpr NO_ITEM = 0xFFFFU;
+  static size_t constexpr MAX_ITEMS = NO_ITEM;
+
+  size_t numberOfCells;
+  // Index into items per cell, items are kept dense so drawing walks them only
+  std::vector<uint16_t> cellItems;
+  std::vector<Item> items;
+  std::vector<uint16_t> wheel;
+  std::array<uint64_t, NUMBER_OF_TYPES> spawnCredits;
+  std::vector<Change> changes;
+  bool reset;
+
+  void Remove(uint16_t const index);
+  void Unlink(uint16_t const index);
+};
@@ -0,0 +1,192 @@
+#include "LatencyTracer.hpp"
+#include "Metrics.hpp"
+#include <SDL_timer.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+static char const * const STAGE_NAMES[] = { "queue", "handling", "tick", "render", "present", "total" };
+
+static Metrics::Histogram constexpr STAGE_HISTOGRAMS[] = {
+  Metrics::Histogram::InputQueue,
+  Metrics::Histogram::InputHandling,
+  Metrics::Histogram::InputTick,
+  Metrics::Histogram::InputRender,
+  Metrics::Histogram::InputPresent,
+  Metrics::Histogram::InputToPhoton
+};
+
+LatencyTracer::LatencyTracer(void)
+: frequency(SDL_GetPerformanceFrequency())
+, polled(false)
+, pollQueue_us(0U)
+, pollTick(0UL)
+, traces()
+, numberOfTraces(0UL)
+, dropped(0UL)
+, buckets(NUMBER_OF_STAGES * NUMBER_OF_BUCKETS, 0U)
+, maxima_us()
+, sums_us()
+, completed(0UL)
+, periodSums_us()
+, periodCompleted(0UL)
+, nextReadout(0UL)
+{
+}
+
+
+LatencyTracer::~LatencyTracer(void)
+{
+  std::cout << "input latency: " << completed << " turns traced, " << dropped << " dropped\n";
+  if (completed == 0UL)
+  {
+    return;
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+  for (size_t stage = 0UL; stage < NUMBER_OF_STAGES; ++stage)
+  {
+    Stage const current = static_cast<Stage>(stage);
+    std::cout << "  " << std::setw(8) << std::left << STAGE_NAMES[stage] << std::right
+              << " mean " << (static_cast<double>(sums_us[stage]) / completed / 1000.0) << " ms"
+              << ", p50 " << (Percentile(current, 50UL) / 1000.0) << " ms"
+              << ", p99 " << (Percentile(current, 99UL) / 1000.0) << " ms"
+              << ", max " << (maxima_us[stage] / 1000.0) << " ms\n";
+  }
+  std::cout << std::defaultfloat;
+}
+
+
+void LatencyTracer::Poll(uint32_t const eventTimestamp_ms, uint32_t const now_ms, uint64_t const now)
+{
+  // SDL stamps events in milliseconds only, the queue stage is as coarse
+  polled = true;
+  pollQueue_us = (now_ms - eventTimestamp_ms) * 1000U;
+  pollTick = now;
+}
+
+
+void LatencyTracer::Steered(uint64_t const now)
+{
+  if (!polled)
+  {
+    return;
+  }
+  polled = false;
+
+  if (numberOfTraces == MAX_TRACES)
+  {
+    ++dropped;
+    return;
+  }
+  Trace & trace = traces[numberOfTraces++];
+  trace.stage = Stage::Handling;
+  trace.stamps[static_cast<size_t>(Stage::Queue)] = pollTick;
+  trace.stamps[static_cast<size_t>(Stage::Handling)] = now;
+  trace.queue_us = pollQueue_us;
+}
+
+
+void LatencyTracer::Reach(Stage const stage, uint64_t const now)
+{
+  size_t const index = static_cast<size_t>(stage);
+  for (size_t i = 0UL; i < numberOfTraces; )
+  {
+    Trace & trace = traces[i];
+    if (static_cast<size_t>(trace.stage) + 1UL != index)
+    {
+      ++i;
+      continue;
+    }
+
+    trace.stage = stage;
+    trace.stamps[index] = now;
+    if (stage != Stage::Present)
+    {
+      ++i;
+      continue;
+    }
+
+    // Stages are only observed once the turn is on screen, so all histograms count the same turns
+    Observe(Stage::Queue, trace.queue_us);
+    for (size_t observed = static_cast<size_t>(Stage::Handling); observed <= index; ++observed)
+    {
+      Observe(static_cast<Stage>(observed), ToMicroseconds(trace.stamps[observed] - trace.stamps[observed - 1UL]));
+    }
+    Observe(Stage::Total, trace.queue_us + ToMicroseconds(now - trace.stamps[static_cast<size_t>(Stage::Queue)]));
+    ++completed;
+    ++periodCompleted;
+    trace = traces[--numberOfTraces];
+  }
+}
+
+
+void LatencyTracer::Update(uint64_t const now)
+{
+  for (size_t i = 0UL; i < numberOfTraces; )
+  {
+    if (ToMicroseconds(now - traces[i].stamps[static_cast<size_t>(traces[i].stage)]) > STALE_MS * 1000UL)
+    {
+      ++dropped;
+      traces[i] = traces[--numberOfTraces];
+    }
+    else
+    {
+      ++i;
+    }
+  }
+
+  if (now < nextReadout)
+  {
+    return;
+  }
+  nextReadout = now + frequency * LIVE_PERIOD_MS / 1000UL;
+
+  // Means of the turns of the last period, quiet while nobody steers
+  if (periodCompleted > 0UL)
+  {
+    std::cout << std::fixed << std::setprecision(1) << "input latency of " << periodCompleted << " turns:";
+    for (size_t stage = 0UL; stage < NUMBER_OF_STAGES; ++stage)
+    {
+      std::cout << " " << STAGE_NAMES[stage] << " " << (static_cast<double>(periodSums_us[stage]) / periodCompleted / 1000.0);
+    }
+    std::cout << " ms" << std::defaultfloat << std::endl;
+  }
+  periodSums_us.fill(0UL);
+  periodCompleted = 0UL;
+}
+
+
+uint64_t LatencyTracer::ToMicroseconds(uint64_t const ticks) const
+{
+  return ticks * 1000000UL / frequency;
+}
+
+
+void LatencyTracer::Observe(Stage const stage, uint64_t const value_us)
+{
+  size_t const index = static_cast<size_t>(stage);
+  ++buckets[index * NUMBER_OF_BUCKETS + std::min(value_us / BUCKET_US, static_cast<uint64_t>(NUMBER_OF_BUCKETS - 1UL))];
+  maxima_us[index] = std::max(maxima_us[index], value_us);
+  sums_us[index] += value_us;
+  periodSums_us[index] += value_us;
+  Metrics::Observe(STAGE_HISTOGRAMS[index], value_us);
+}
+
+
+uint64_t LatencyTracer::Percentile(Stage const stage, uint64_t const percent) const
+{
+  // Upper bound of the bucket holding the percentile, the maximum for the last bucket
+  size_t const index = static_cast<size_t>(stage);
+  uint64_t const rank = (completed * percent + 99UL) / 100UL;
+  uint64_t count = 0UL;
+  for (size_t bucket = 0UL; bucket < NUMBER_OF_BUCKETS - 1UL; ++bucket)
+  {
+    count += buckets[index * NUMBER_OF_BUCKETS + bucket];
+    if (count >= rank)
+    {
+      return std::min((bucket + 1UL) * BUCKET_US, maxima_us[index]);
+    }
+  }
+  return maxima_us[index];
+}
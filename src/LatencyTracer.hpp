@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Follows turn keys from the event queue to the presented frame which first shows them
+class LatencyTracer
+{
+public:
+  // Stages in the order a turn passes them, the last one spans all
+  enum class Stage : size_t
+  {
+    Queue,
+    Handling,
+    Tick,
+    Render,
+    Present,
+    Total,
+    Count
+  };
+
+  LatencyTracer(void);
+  ~LatencyTracer(void);
+
+  // Times are performance counter ticks, the event timestamp is in SDL milliseconds
+  void Poll(uint32_t const eventTimestamp_ms, uint32_t const now_ms, uint64_t const now);
+  void Steered(uint64_t const now);
+  // Moves every turn waiting for the stage on, a present completes them
+  void Reach(Stage const stage, uint64_t const now);
+  // Prints the means of the last period, once per period
+  void Update(uint64_t const now);
+
+private:
+  static size_t constexpr NUMBER_OF_STAGES = static_cast<size_t>(Stage::Count);
+  // Turns pressed faster than frames are drawn, more are dropped
+  static size_t constexpr MAX_TRACES = 16UL;
+  static uint64_t constexpr BUCKET_US = 100UL;
+  static size_t constexpr NUMBER_OF_BUCKETS = 5000UL;
+  static uint64_t constexpr LIVE_PERIOD_MS = 1000UL;
+  // Turns never applied, like those of a match which just ended, are dropped after this
+  static uint64_t constexpr STALE_MS = 1000UL;
+
+  struct Trace
+  {
+    // The last stage passed, stamps are taken at the end of each stage with the poll as end of the queue
+    Stage stage;
+    std::array<uint64_t, NUMBER_OF_STAGES> stamps;
+    uint32_t queue_us;
+  };
+
+  uint64_t frequency;
+  // Poll of the event being handled, until it steers or the next one is polled
+  bool polled;
+  uint32_t pollQueue_us;
+  uint64_t pollTick;
+  std::array<Trace, MAX_TRACES> traces;
+  size_t numberOfTraces;
+  uint64_t dropped;
+  // Buckets of 0.1 ms per stage, the last one takes everything above
+  std::vector<uint32_t> buckets;
+  std::array<uint64_t, NUMBER_OF_STAGES> maxima_us;
+  std::array<uint64_t, NUMBER_OF_STAGES> sums_us;
+  uint64_t completed;
+  std::array<uint64_t, NUMBER_OF_STAGES> periodSums_us;
+  uint64_t periodCompleted;
+  uint64_t nextReadout;
+
+  uint64_t ToMicroseconds(uint64_t const ticks) const;
+  void Observe(Stage const stage, uint64_t const value_us);
+  uint64_t Percentile(Stage const stage, uint64_t const percent) const;
+};
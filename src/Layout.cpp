@@ -0,0 +1,72 @@
+#include "Layout.hpp"
+#include "Position.hpp"
+#include <algorithm>
+
+Layout::Layout(Position const & resolution)
+: resolution(resolution)
+, fontScale(std::min(resolution.x / 1920.0, resolution.y / 1080.0))
+, fieldPosition(ConvertFullHd({ 140, 100 }))
+, fieldScale(ConvertFullHd({ 980, 980 }))
+, titleBackgroundScale(ConvertFullHd({ 1920, 1080 }))
+, bensGamePosition(ConvertFullHd({ 20, 20 }))
+, startPosition(ConvertFullHd({ 20, 100 }))
+, onePlayerPosition(ConvertFullHd({ 20, 160 }))
+, twoPlayerPosition(ConvertFullHd({ 20, 220 }))
+, exitPosition(ConvertFullHd({ 20, 320 }))
+, checkedOnePlayerPosition(ConvertFullHd({ 12, 140 }))
+, checkedTwoPlayerPosition(ConvertFullHd({ 12, 200 }))
+, checkedScale(ConvertFullHd({ 80, 80 }))
+, arrowsPosition(ConvertFullHd({ 90, 160 }))
+, wasdPosition(ConvertFullHd({ 90, 220 }))
+, keysScale(ConvertFullHd({ 40, 30 }))
+, scorePosition(ConvertFullHd({ 1700, 712 }))
+, scoreApplePosition(ConvertFullHd({ 1640, 695 }))
+, scoreAppleScale(ConvertFullHd({ 50, 50 }))
+, minimapPosition(ConvertFullHd({ 1560, 380 }))
+, minimapScale(ConvertFullHd({ 300, 300 }))
+, versionPosition(ConvertFullHd({ 1845, 1050 }))
+, gameOverPosition(fieldPosition + ConvertFullHd({ 60, 200 }))
+, gameOverScale(ConvertFullHd({ 800, 480 }))
+, gameOverTwoPlayersPosition(fieldPosition + ConvertFullHd({ 180, 400 }))
+, highscoreFramePosition(gameOverPosition - ConvertFullHd({ 10, 10 }))
+, highscoreFrameScale(gameOverScale + ConvertFullHd({ 20, 20 }))
+, trophyPosition(gameOverPosition + ConvertFullHd({ 20, 50 }))
+, trophyScale(ConvertFullHd({ 220, 242 }))
+, newHighscorePosition(gameOverPosition + ConvertFullHd({ 300, 50 }))
+, enterNamePosition(gameOverPosition + ConvertFullHd({ 300, 200 }))
+, newHighscoreNamePosition(gameOverPosition + ConvertFullHd({ 300, 300 }))
+, highscoreRankPosition(gameOverPosition + ConvertFullHd({ 300, 115 }))
+, planeScale(ConvertFullHd({ 219, 102 }))
+, bannerOffset(ConvertFullHdHeight(26))
+, bannerTextOffset(ConvertFullHdHeight(45))
+, bannerPadding(ConvertFullHdWidth(20))
+, bannerHeight(ConvertFullHdHeight(72))
+, bannerTailWidth(ConvertFullHdWidth(50))
+{
+}
+
+
+int Layout::FontSize(int const fhdSize) const
+{
+  // Text is rasterized for the resolution instead of scaling the full HD text
+  return std::max(static_cast<int>(fhdSize * fontScale), 1);
+}
+
+
+Position Layout::ConvertFullHd(Position const & fhdPosition) const
+{
+  return { static_cast<int>(static_cast<float>(resolution.x) / 1920.0 * static_cast<float>(fhdPosition.x)),
+           static_cast<int>(static_cast<float>(resolution.y) / 1080.0 * static_cast<float>(fhdPosition.y)) };
+}
+
+
+int Layout::ConvertFullHdWidth(int const fhdWidth) const
+{
+  return static_cast<int>(static_cast<float>(resolution.x) / 1920.0 * static_cast<float>(fhdWidth));
+}
+
+
+int Layout::ConvertFullHdHeight(int const fhdHeight) const
+{
+  return static_cast<int>(static_cast<float>(resolution.y) / 1080.0 * static_cast<float>(fhdHeight));
+}
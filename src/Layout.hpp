@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Position.hpp"
+
+// Screen rectangles of all widgets, designed for full HD and computed once per resolution
+struct Layout
+{
+  Layout(Position const & resolution);
+
+  Position resolution;
+  double fontScale;
+
+  Position fieldPosition;
+  Position fieldScale;
+
+  Position titleBackgroundScale;
+  Position bensGamePosition;
+  Position startPosition;
+  Position onePlayerPosition;
+  Position twoPlayerPosition;
+  Position exitPosition;
+  Position checkedOnePlayerPosition;
+  Position checkedTwoPlayerPosition;
+  Position checkedScale;
+  Position arrowsPosition;
+  Position wasdPosition;
+  Position keysScale;
+  Position scorePosition;
+  Position scoreApplePosition;
+  Position scoreAppleScale;
+  Position minimapPosition;
+  Position minimapScale;
+  Position versionPosition;
+
+  Position gameOverPosition;
+  Position gameOverScale;
+  Position gameOverTwoPlayersPosition;
+  Position highscoreFramePosition;
+  Position highscoreFrameScale;
+  Position trophyPosition;
+  Position trophyScale;
+  Position newHighscorePosition;
+  Position enterNamePosition;
+  Position newHighscoreNamePosition;
+  Position highscoreRankPosition;
+
+  Position planeScale;
+  int bannerOffset;
+  int bannerTextOffset;
+  int bannerPadding;
+  int bannerHeight;
+  int bannerTailWidth;
+
+  int FontSize(int const fhdSize) const;
+
+private:
+  Position ConvertFullHd(Position const & fhdPosition) const;
+  int ConvertFullHdWidth(int const fhdWidth) const;
+  int ConvertFullHdHeight(int const fhdHeight) const;
+};
@@ -0,0 +1,118 @@
+#include "LockstepSelftest.hpp"
+#include "LockstepSimulation.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static uint32_t constexpr SELFTEST_TICKS = 4000U;
+// Comparing every cell of every game is slower than stepping, so boards are compared now and then
+static uint32_t constexpr BOARD_CHECK_PERIOD = 64U;
+
+static bool IsIdentical(Simulation const & simulation, LockstepSimulation const & lockstep, size_t const game, bool const checkBoard)
+{
+  Simulation::State const & state = simulation.GetState();
+  Simulation::Snake const & snake = state.snakes[0];
+  bool identical =    (state.running == lockstep.IsRunning(game))
+                   && (snake.Head() == lockstep.GetHead(game))
+                   && (snake.length == lockstep.GetLength(game))
+                   && (state.apple == lockstep.GetApple(game))
+                   && (state.scoreCount == lockstep.GetScore(game))
+                   && (state.numberOfMoves == lockstep.GetNumberOfMoves(game))
+                   && (state.randomState == lockstep.GetRandomState(game));
+
+  Position const size = simulation.GetSize();
+  for (int y = 0; checkBoard && identical && (y < size.y); ++y)
+  {
+    for (int x = 0; identical && (x < size.x); ++x)
+    {
+      identical = (simulation.IsFree({ x, y }) != lockstep.IsOccupied(game, { x, y }));
+    }
+  }
+  return identical;
+}
+
+
+int RunLockstepSelftest(Options const & options)
+{
+  size_t const numberOfGames = options.lockstepGames;
+  std::vector<Simulation> simulations(numberOfGames, Simulation(options.boardSize));
+  LockstepSimulation lockstep(options.boardSize, numberOfGames);
+  std::mt19937 random(1U);
+  for (size_t game = 0UL; game < numberOfGames; ++game)
+  {
+    uint64_t const seed = random();
+    simulations[game].Restart(1UL, seed);
+    lockstep.Restart(game, seed);
+  }
+
+  std::chrono::steady_clock::duration scalarTime(0);
+  std::chrono::steady_clock::duration lockstepTime(0);
+  std::chrono::steady_clock::duration appleTime(0);
+  uint64_t games = 0UL;
+  uint64_t apples = 0UL;
+  size_t mismatches = 0UL;
+  for (uint32_t tick = 0U; (tick < SELFTEST_TICKS) && (mismatches == 0UL); ++tick)
+  {
+    // Random turns like a nervous player, finished games start over with a fresh seed
+    for (size_t game = 0UL; game < numberOfGames; ++game)
+    {
+      if (!simulations[game].GetState().running)
+      {
+        // Every point was an apple eaten and another one placed
+        apples += lockstep.GetScore(game);
+        uint64_t const seed = random();
+        simulations[game].Restart(1UL, seed);
+        lockstep.Restart(game, seed);
+        ++games;
+      }
+      Simulation::Direction const direction = static_cast<Simulation::Direction>(random() % 4U);
+      if (((random() % 4U) == 0U) && simulations[game].Steer(0UL, direction))
+      {
+        lockstep.SetPressedDirection(game, direction);
+      }
+    }
+
+    std::chrono::steady_clock::time_point const scalarStart = std::chrono::steady_clock::now();
+    for (Simulation & simulation : simulations)
+    {
+      (void)simulation.Step();
+    }
+    std::chrono::steady_clock::time_point const lockstepStart = std::chrono::steady_clock::now();
+    lockstep.Move();
+    std::chrono::steady_clock::time_point const appleStart = std::chrono::steady_clock::now();
+    lockstep.PlaceApples();
+    std::chrono::steady_clock::time_point const lockstepEnd = std::chrono::steady_clock::now();
+    scalarTime += lockstepStart - scalarStart;
+    lockstepTime += lockstepEnd - lockstepStart;
+    appleTime += lockstepEnd - appleStart;
+
+    bool const checkBoard = ((tick % BOARD_CHECK_PERIOD) == 0U);
+    for (size_t game = 0UL; game < numberOfGames; ++game)
+    {
+      if (!IsIdentical(simulations[game], lockstep, game, checkBoard))
+      {
+        std::cerr << "Game " << game << " differs after tick " << tick << "\n";
+        ++mismatches;
+      }
+    }
+  }
+
+  for (size_t game = 0UL; game < numberOfGames; ++game)
+  {
+    apples += lockstep.GetScore(game);
+  }
+
+  double const scalar_ms = std::chrono::duration<double, std::milli>(scalarTime).count();
+  double const lockstep_ms = std::chrono::duration<double, std::milli>(lockstepTime).count();
+  double const apple_ms = std::chrono::duration<double, std::milli>(appleTime).count();
+  std::cout << numberOfGames << " games, " << SELFTEST_TICKS << " ticks, " << games << " restarts: "
+            << "scalar " << scalar_ms << " ms, lockstep " << lockstep_ms << " ms, "
+            << (scalar_ms / lockstep_ms) << "x speedup, " << ((mismatches == 0UL) ? "identical" : "MISMATCH") << "\n";
+  // Placing an apple analyzes the whole board in both simulations, so it is the same work and shown on its own
+  std::cout << "lockstep moves " << (lockstep_ms - apple_ms) << " ms, apple placement " << apple_ms << " ms for "
+            << apples << " apples\n";
+  return (mismatches == 0UL) ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+struct Options;
+
+// Plays the same games on Simulation and LockstepSimulation, compares them tick by tick and times both
+int RunLockstepSelftest(Options const & options);
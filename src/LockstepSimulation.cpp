@@ -0,0 +1,352 @@
+#include "LockstepSimulation.hpp"
+#include "Position.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOCKSTEP_SSE2
+#endif
+
+static size_t constexpr LANES_PER_VECTOR = 4UL;
+// Rings start like Simulation's and double when full
+static size_t constexpr INITIAL_RING_SIZE = 16UL;
+
+LockstepSimulation::LockstepSimulation(Position const & boardSize, size_t const numberOfGames)
+: size(boardSize)
+, games(numberOfGames)
+, lanes(((numberOfGames + LANES_PER_VECTOR - 1UL) / LANES_PER_VECTOR) * LANES_PER_VECTOR)
+, cells(static_cast<size_t>(boardSize.x) * boardSize.y)
+, wordsPerCell((lanes + 63UL) / 64UL)
+, wordsPerGame((cells + 63UL) / 64UL)
+, headX(lanes, 0)
+, headY(lanes, 0)
+, headCell(lanes, 0)
+, appleCell(lanes, 0)
+, direction(lanes, 0)
+, pressedDirection(lanes, 0)
+, running(lanes, 0)
+, length(lanes, 0U)
+, scoreCount(lanes, 0U)
+, numberOfMoves(lanes, 0UL)
+, randomState(lanes, 1UL)
+, bodies(games, std::vector<int32_t>(INITIAL_RING_SIZE, 0))
+, headCursor(lanes, 0U)
+, tailCursor(lanes, 0U)
+, occupancy(cells * wordsPerCell, 0UL)
+, nextCell(lanes, 0)
+, eats(lanes, 0)
+, eaters()
+, gameOccupancy(wordsPerGame, 0UL)
+, analysis()
+{
+  eaters.reserve(games);
+}
+
+
+void LockstepSimulation::Restart(size_t const game, uint64_t const seed)
+{
+  // Rings keep their size, like Simulation's
+  while (length[game] > 0U)
+  {
+    RemoveTail(game);
+  }
+  tailCursor[game] = 0U;
+  headCursor[game] = static_cast<uint32_t>(bodies[game].size() - 1UL);
+  direction[game] = static_cast<int32_t>(Simulation::Direction::Up);
+  pressedDirection[game] = static_cast<int32_t>(Simulation::Direction::Up);
+  running[game] = -1;
+  scoreCount[game] = 0U;
+  numberOfMoves[game] = 0UL;
+  randomState[game] = (seed != 0UL) ? seed : 1UL;
+
+  // Start with 3 parts sized snake, like Simulation::Restart
+  headX[game] = size.x / 2;
+  for (int part = 1; part <= 3; ++part)
+  {
+    headY[game] = size.y - part;
+    AddHead(game, headY[game] * size.x + headX[game]);
+  }
+  RandomApplePosition(game);
+}
+
+
+void LockstepSimulation::SetPressedDirection(size_t const game, Simulation::Direction const newDirection)
+{
+  pressedDirection[game] = static_cast<int32_t>(newDirection);
+}
+
+
+void LockstepSimulation::Step(void)
+{
+  Move();
+  PlaceApples();
+}
+
+
+void LockstepSimulation::Move(void)
+{
+  // Directions, next heads, bounds, occupancy and apples of four games per vector, finished and blocked games stay put
+  size_t lane = 0UL;
+#ifdef LOCKSTEP_SSE2
+  __m128i const up = _mm_set1_epi32(static_cast<int32_t>(Simulation::Direction::Up));
+  __m128i const down = _mm_set1_epi32(static_cast<int32_t>(Simulation::Direction::Down));
+  __m128i const left = _mm_set1_epi32(static_cast<int32_t>(Simulation::Direction::Left));
+  __m128i const right = _mm_set1_epi32(static_cast<int32_t>(Simulation::Direction::Right));
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const minusOne = _mm_set1_epi32(-1);
+  __m128i const laneBits = _mm_set_epi32(8, 4, 2, 1);
+  __m128i const width = _mm_set1_epi32(size.x);
+  __m128i const height = _mm_set1_epi32(size.y);
+  alignas(16) int32_t testCells[LANES_PER_VECTOR];
+  for (; lane < lanes; lane += LANES_PER_VECTOR)
+  {
+    __m128i const laneRunning = _mm_loadu_si128(reinterpret_cast<__m128i const *>(running.data() + lane));
+    __m128i const laneDirection = _mm_or_si128(
+      _mm_and_si128(laneRunning, _mm_loadu_si128(reinterpret_cast<__m128i const *>(pressedDirection.data() + lane))),
+      _mm_andnot_si128(laneRunning, _mm_loadu_si128(reinterpret_cast<__m128i const *>(direction.data() + lane))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(direction.data() + lane), laneDirection);
+
+    // Compares give -1 for true, so their differences are the steps
+    __m128i const isUp = _mm_cmpeq_epi32(laneDirection, up);
+    __m128i const isDown = _mm_cmpeq_epi32(laneDirection, down);
+    __m128i const dx = _mm_sub_epi32(_mm_cmpeq_epi32(laneDirection, left), _mm_cmpeq_epi32(laneDirection, right));
+    __m128i const dy = _mm_sub_epi32(isUp, isDown);
+    __m128i const laneX = _mm_loadu_si128(reinterpret_cast<__m128i const *>(headX.data() + lane));
+    __m128i const laneY = _mm_loadu_si128(reinterpret_cast<__m128i const *>(headY.data() + lane));
+    __m128i const x = _mm_add_epi32(laneX, dx);
+    __m128i const y = _mm_add_epi32(laneY, dy);
+    __m128i const cell = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(headCell.data() + lane)),
+                                       _mm_add_epi32(dx, _mm_sub_epi32(_mm_and_si128(isDown, width), _mm_and_si128(isUp, width))));
+    __m128i const inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(x, minusOne), _mm_cmpgt_epi32(width, x)),
+                                         _mm_and_si128(_mm_cmpgt_epi32(y, minusOne), _mm_cmpgt_epi32(height, y)));
+
+    // SSE2 has no gather, so the words of the cells' bit planes are loaded per lane, lanes which test nothing load cell 0
+    __m128i const active = _mm_and_si128(laneRunning, inside);
+    _mm_store_si128(reinterpret_cast<__m128i*>(testCells), _mm_and_si128(active, cell));
+    __m128i const words = _mm_set_epi32(LoadOccupancyHalf(lane + 3UL, testCells[3]), LoadOccupancyHalf(lane + 2UL, testCells[2]),
+                                        LoadOccupancyHalf(lane + 1UL, testCells[1]), LoadOccupancyHalf(lane, testCells[0]));
+    // The four lanes have neighbouring bits in the same half of every plane word
+    __m128i const bits = _mm_sll_epi32(laneBits, _mm_cvtsi32_si128(static_cast<int>(lane & 31UL)));
+    __m128i const moving = _mm_and_si128(active, _mm_cmpeq_epi32(_mm_and_si128(words, bits), zero));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(headX.data() + lane),
+                     _mm_or_si128(_mm_and_si128(moving, x), _mm_andnot_si128(moving, laneX)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(headY.data() + lane),
+                     _mm_or_si128(_mm_and_si128(moving, y), _mm_andnot_si128(moving, laneY)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(nextCell.data() + lane), cell);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(eats.data() + lane),
+                     _mm_and_si128(moving, _mm_cmpeq_epi32(cell, _mm_loadu_si128(reinterpret_cast<__m128i const *>(appleCell.data() + lane)))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(running.data() + lane), moving);
+
+    // Every game running before the step made a move, blocked ones included, -1 per lane widened to 64 bits
+    __m128i* const pMoves = reinterpret_cast<__m128i*>(numberOfMoves.data() + lane);
+    _mm_storeu_si128(pMoves, _mm_sub_epi64(_mm_loadu_si128(pMoves), _mm_unpacklo_epi32(laneRunning, laneRunning)));
+    _mm_storeu_si128(pMoves + 1, _mm_sub_epi64(_mm_loadu_si128(pMoves + 1), _mm_unpackhi_epi32(laneRunning, laneRunning)));
+  }
+#endif
+  for (; lane < lanes; ++lane)
+  {
+    direction[lane] = (running[lane] != 0) ? pressedDirection[lane] : direction[lane];
+    Simulation::Direction const laneDirection = static_cast<Simulation::Direction>(direction[lane]);
+    int32_t const dx = (laneDirection == Simulation::Direction::Right) ? 1 : (laneDirection == Simulation::Direction::Left) ? -1 : 0;
+    int32_t const dy = (laneDirection == Simulation::Direction::Down) ? 1 : (laneDirection == Simulation::Direction::Up) ? -1 : 0;
+    int32_t const x = headX[lane] + dx;
+    int32_t const y = headY[lane] + dy;
+    int32_t const cell = headCell[lane] + dx + dy * size.x;
+    bool const inside = (x >= 0) && (x < size.x) && (y >= 0) && (y < size.y);
+    bool const moving = (running[lane] != 0) && inside && !TestCell(lane, cell);
+
+    numberOfMoves[lane] += (running[lane] != 0) ? 1UL : 0UL;
+    headX[lane] = moving ? x : headX[lane];
+    headY[lane] = moving ? y : headY[lane];
+    nextCell[lane] = cell;
+    eats[lane] = (moving && (cell == appleCell[lane])) ? -1 : 0;
+    running[lane] = moving ? -1 : 0;
+  }
+
+  // Blocked games are over with the board as it was, the moved ones grow a head and eat or lose their tail
+  eaters.clear();
+  for (size_t game = 0UL; game < games; ++game)
+  {
+    if (running[game] == 0)
+    {
+      continue;
+    }
+
+    AddHead(game, nextCell[game]);
+    if (eats[game] != 0)
+    {
+      eaters.push_back(static_cast<uint32_t>(game));
+      ++scoreCount[game];
+    }
+    else
+    {
+      RemoveTail(game);
+    }
+  }
+}
+
+
+void LockstepSimulation::PlaceApples(void)
+{
+  for (uint32_t const game : eaters)
+  {
+    RandomApplePosition(game);
+  }
+  eaters.clear();
+}
+
+
+size_t LockstepSimulation::GetNumberOfGames(void) const
+{
+  return games;
+}
+
+
+bool LockstepSimulation::IsRunning(size_t const game) const
+{
+  return running[game] != 0;
+}
+
+
+bool LockstepSimulation::IsOccupied(size_t const game, Position const & cell) const
+{
+  return TestCell(game, cell.y * size.x + cell.x);
+}
+
+
+Position LockstepSimulation::GetHead(size_t const game) const
+{
+  return { headX[game], headY[game] };
+}
+
+
+Position LockstepSimulation::GetApple(size_t const game) const
+{
+  return { appleCell[game] % size.x, appleCell[game] / size.x };
+}
+
+
+uint32_t LockstepSimulation::GetLength(size_t const game) const
+{
+  return length[game];
+}
+
+
+uint16_t LockstepSimulation::GetScore(size_t const game) const
+{
+  return scoreCount[game];
+}
+
+
+uint64_t LockstepSimulation::GetNumberOfMoves(size_t const game) const
+{
+  return numberOfMoves[game];
+}
+
+
+uint64_t LockstepSimulation::GetRandomState(size_t const game) const
+{
+  return randomState[game];
+}
+
+
+void LockstepSimulation::AddHead(size_t const game, int32_t const cell)
+{
+  std::vector<int32_t> & ring = bodies[game];
+  if (length[game] == ring.size())
+  {
+    // Ring is full, so unroll it from the tail into a ring of double size
+    std::vector<int32_t> grown(ring.size() * 2UL);
+    for (uint32_t i = 0U; i < length[game]; ++i)
+    {
+      grown[i] = ring[(tailCursor[game] + i) & (ring.size() - 1UL)];
+    }
+    ring.swap(grown);
+    tailCursor[game] = 0U;
+    headCursor[game] = length[game] - 1U;
+  }
+
+  headCursor[game] = (headCursor[game] + 1U) & static_cast<uint32_t>(ring.size() - 1UL);
+  ring[headCursor[game]] = cell;
+  headCell[game] = cell;
+  ++length[game];
+  OccupancyWord(game, cell) |= static_cast<uint64_t>(1U) << (game % 64UL);
+}
+
+
+void LockstepSimulation::RemoveTail(size_t const game)
+{
+  std::vector<int32_t> const & ring = bodies[game];
+  int32_t const cell = ring[tailCursor[game]];
+  tailCursor[game] = (tailCursor[game] + 1U) & static_cast<uint32_t>(ring.size() - 1UL);
+  --length[game];
+  OccupancyWord(game, cell) &= ~(static_cast<uint64_t>(1U) << (game % 64UL));
+}
+
+
+void LockstepSimulation::RandomApplePosition(size_t const game)
+{
+  // The analysis wants the game's own rows of bits, which its body gives quicker than the planes of all cells
+  std::fill(gameOccupancy.begin(), gameOccupancy.end(), 0UL);
+  std::vector<int32_t> const & ring = bodies[game];
+  for (uint32_t i = 0U; i < length[game]; ++i)
+  {
+    size_t const cell = static_cast<size_t>(ring[(tailCursor[game] + i) & (ring.size() - 1UL)]);
+    gameOccupancy[cell / 64UL] |= static_cast<uint64_t>(1U) << (cell % 64UL);
+  }
+
+  // Same draws and scan as Simulation::RandomApplePosition, so both place every apple alike
+  analysis.Analyze(gameOccupancy.data(), size);
+  Position const head = GetHead(game);
+  bool const reachableOnly = analysis.GetReachableCells(head) > 0U;
+
+  int xRandom = Random(game) % size.x;
+  int yRandom = Random(game) % size.y;
+  Position const randomPosition = {xRandom, yRandom};
+  while (TestCell(game, yRandom * size.x + xRandom) || (reachableOnly && !analysis.IsReachable(head, { xRandom, yRandom })))
+  {
+    xRandom = (xRandom < size.x - 1) ? xRandom + 1
+                                     : 0;
+    yRandom = (xRandom != 0)         ? yRandom
+            : (yRandom < size.y - 1) ? yRandom + 1
+                                     : 0;
+
+    if (randomPosition == Position{xRandom, yRandom})
+    {
+      break;
+    }
+  }
+
+  appleCell[game] = yRandom * size.x + xRandom;
+}
+
+
+uint32_t LockstepSimulation::Random(size_t const game)
+{
+  // xorshift64* like Simulation::Random
+  uint64_t & x = randomState[game];
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  return static_cast<uint32_t>((x * 2685821657736338717UL) >> 32);
+}
+
+
+uint64_t & LockstepSimulation::OccupancyWord(size_t const game, int32_t const cell)
+{
+  return occupancy[static_cast<size_t>(cell) * wordsPerCell + game / 64UL];
+}
+
+
+bool LockstepSimulation::TestCell(size_t const game, int32_t const cell) const
+{
+  return ((occupancy[static_cast<size_t>(cell) * wordsPerCell + game / 64UL] >> (game % 64UL)) & 1UL) != 0UL;
+}
+
+
+int32_t LockstepSimulation::LoadOccupancyHalf(size_t const game, int32_t const cell) const
+{
+  // The 32 bits of the cell's plane word around the game, so the game is bit game % 32
+  return static_cast<int32_t>(static_cast<uint32_t>(occupancy[static_cast<size_t>(cell) * wordsPerCell + game / 64UL] >> (game & 32UL)));
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "BoardAnalysis.hpp"
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Many one player games with the rules of Simulation, stored as arrays per property and stepped together
+class LockstepSimulation
+{
+public:
+  LockstepSimulation(Position const & boardSize, size_t const numberOfGames);
+
+  void Restart(size_t const game, uint64_t const seed);
+  void SetPressedDirection(size_t const game, Simulation::Direction const direction);
+  // Moves all games, then places the apples of those which ate
+  void Step(void);
+  // The two halves of a step, apart only to time them apart
+  void Move(void);
+  void PlaceApples(void);
+
+  size_t GetNumberOfGames(void) const;
+  bool IsRunning(size_t const game) const;
+  bool IsOccupied(size_t const game, Position const & cell) const;
+  Position GetHead(size_t const game) const;
+  Position GetApple(size_t const game) const;
+  uint32_t GetLength(size_t const game) const;
+  uint16_t GetScore(size_t const game) const;
+  uint64_t GetNumberOfMoves(size_t const game) const;
+  uint64_t GetRandomState(size_t const game) const;
+
+private:
+  Position size;
+  size_t games;
+  // Games are padded to whole vectors of four lanes
+  size_t lanes;
+  size_t cells;
+  // Words of a cell's bit plane, one bit per lane
+  size_t wordsPerCell;
+  size_t wordsPerGame;
+
+  // Lane arrays, directions as in Simulation::Direction and running as all bits set or clear
+  std::vector<int32_t> headX;
+  std::vector<int32_t> headY;
+  std::vector<int32_t> headCell;
+  std::vector<int32_t> appleCell;
+  std::vector<int32_t> direction;
+  std::vector<int32_t> pressedDirection;
+  std::vector<int32_t> running;
+  std::vector<uint32_t> length;
+  std::vector<uint16_t> scoreCount;
+  std::vector<uint64_t> numberOfMoves;
+  std::vector<uint64_t> randomState;
+
+  // Bodies as rings of cells from the tail cursor to the head cursor, doubled when full like Simulation's rings
+  std::vector<std::vector<int32_t>> bodies;
+  std::vector<uint32_t> headCursor;
+  std::vector<uint32_t> tailCursor;
+  // Bit planes, the lanes of a vector test their cells with one constant bit each
+  std::vector<uint64_t> occupancy;
+
+  // Scratch of a step, eats as all bits set or clear
+  std::vector<int32_t> nextCell;
+  std::vector<int32_t> eats;
+  std::vector<uint32_t> eaters;
+  // One game's occupancy as rows of bits for the analysis of free regions
+  std::vector<uint64_t> gameOccupancy;
+  BoardAnalysis analysis;
+
+  void AddHead(size_t const game, int32_t const cell);
+  void RemoveTail(size_t const game);
+  void RandomApplePosition(size_t const game);
+  uint32_t Random(size_t const game);
+  uint64_t & OccupancyWord(size_t const game, int32_t const cell);
+  bool TestCell(size_t const game, int32_t const cell) const;
+  int32_t LoadOccupancyHalf(size_t const game, int32_t const cell) const;
+};
@@ -0,0 +1,206 @@
+#include "Metrics.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+static size_t constexpr NUMBER_OF_COUNTERS = static_cast<size_t>(Metrics::Counter::Count);
+static size_t constexpr NUMBER_OF_GAUGES = static_cast<size_t>(Metrics::Gauge::Count);
+static size_t constexpr NUMBER_OF_HISTOGRAMS = static_cast<size_t>(Metrics::Histogram::Count);
+
+// Upper bounds of the histogram buckets, a last bucket takes everything above
+static std::array<uint64_t, 12> constexpr BUCKET_BOUNDS_US = {
+  50UL, 100UL, 250UL, 500UL, 1000UL, 2500UL, 5000UL, 10000UL, 25000UL, 50000UL, 100000UL, 250000UL
+};
+static size_t constexpr NUMBER_OF_BUCKETS = BUCKET_BOUNDS_US.size() + 1UL;
+
+struct Description
+{
+  char const * pName;
+  char const * pHelp;
+};
+
+static std::array<Description, NUMBER_OF_COUNTERS> constexpr COUNTERS = {{
+  { "snake_ticks_total", "Simulation ticks." },
+  { "snake_games_total", "Finished games." },
+  { "snake_draw_calls_total", "Draw calls of the engine." },
+  { "snake_allocations_total", "Heap allocations of frames and ticks, counted in COUNT_ALLOCATIONS builds only." }
+}};
+
+static std::array<Description, NUMBER_OF_GAUGES> constexpr GAUGES = {{
+  { "snake_active_matches", "Matches being played." },
+  { "snake_texture_bytes", "Texture memory of the loaded assets." }
+}};
+
+static std::array<Description, NUMBER_OF_HISTOGRAMS> constexpr HISTOGRAMS = {{
+  { "snake_tick_duration_seconds", "Time to decide and simulate one tick." },
+  { "snake_tick_lateness_seconds", "Delay of a tick behind its period." },
+  { "snake_frame_time_seconds", "Time between two frames." },
+  { "snake_input_queue_seconds", "Time of a turn key in the event queue, with the millisecond resolution of SDL." },
+  { "snake_input_handling_seconds", "Time from polling a turn key to the turn being steered." },
+  { "snake_input_tick_seconds", "Time from a steered turn to the tick which applies it." },
+  { "snake_input_render_seconds", "Time from the tick applying a turn to the frame which draws it." },
+  { "snake_input_present_seconds", "Time from drawing a turn to its frame being presented." },
+  { "snake_input_to_photon_seconds", "Time from a turn key being pressed to its frame being presented." }
+}};
+
+struct Metrics::Shard
+{
+  // Written by the owning thread only, so a relaxed load and store replaces an atomic add
+  std::array<std::atomic<uint64_t>, NUMBER_OF_COUNTERS> counters;
+  std::array<std::atomic<int64_t>, NUMBER_OF_GAUGES> gauges;
+  std::array<std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS>, NUMBER_OF_HISTOGRAMS> buckets;
+  std::array<std::atomic<uint64_t>, NUMBER_OF_HISTOGRAMS> sums_us;
+
+  Shard(void)
+  {
+    for (std::atomic<uint64_t> & counter : counters)
+    {
+      counter.store(0UL, std::memory_order_relaxed);
+    }
+    for (std::atomic<int64_t> & gauge : gauges)
+    {
+      gauge.store(0L, std::memory_order_relaxed);
+    }
+    for (std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> & histogram : buckets)
+    {
+      for (std::atomic<uint64_t> & bucket : histogram)
+      {
+        bucket.store(0UL, std::memory_order_relaxed);
+      }
+    }
+    for (std::atomic<uint64_t> & sum_us : sums_us)
+    {
+      sum_us.store(0UL, std::memory_order_relaxed);
+    }
+  }
+};
+
+static std::mutex shardsMutex;
+
+template <typename T>
+static void Increase(std::atomic<T> & value, T const amount)
+{
+  value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+
+void Metrics::Add(Counter const counter, uint64_t const value)
+{
+  Increase(GetShard().counters[static_cast<size_t>(counter)], value);
+}
+
+
+void Metrics::Set(Gauge const gauge, int64_t const value)
+{
+  GetShard().gauges[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+}
+
+
+void Metrics::Observe(Histogram const histogram, uint64_t const value_us)
+{
+  size_t bucket = 0UL;
+  while ((bucket < BUCKET_BOUNDS_US.size()) && (value_us > BUCKET_BOUNDS_US[bucket]))
+  {
+    ++bucket;
+  }
+
+  Shard & shard = GetShard();
+  Increase(shard.buckets[static_cast<size_t>(histogram)][bucket], 1UL);
+  Increase(shard.sums_us[static_cast<size_t>(histogram)], value_us);
+}
+
+
+std::string Metrics::Expose(void)
+{
+  std::array<uint64_t, NUMBER_OF_COUNTERS> counters = {};
+  std::array<int64_t, NUMBER_OF_GAUGES> gauges = {};
+  std::array<std::array<uint64_t, NUMBER_OF_BUCKETS>, NUMBER_OF_HISTOGRAMS> buckets = {};
+  std::array<uint64_t, NUMBER_OF_HISTOGRAMS> sums_us = {};
+  {
+    std::lock_guard<std::mutex> const lock(shardsMutex);
+    for (std::unique_ptr<Shard> const & pShard : GetShards())
+    {
+      for (size_t i = 0UL; i < NUMBER_OF_COUNTERS; ++i)
+      {
+        counters[i] += pShard->counters[i].load(std::memory_order_relaxed);
+      }
+      // Gauges are summed over the threads which set them
+      for (size_t i = 0UL; i < NUMBER_OF_GAUGES; ++i)
+      {
+        gauges[i] += pShard->gauges[i].load(std::memory_order_relaxed);
+      }
+      for (size_t i = 0UL; i < NUMBER_OF_HISTOGRAMS; ++i)
+      {
+        for (size_t bucket = 0UL; bucket < NUMBER_OF_BUCKETS; ++bucket)
+        {
+          buckets[i][bucket] += pShard->buckets[i][bucket].load(std::memory_order_relaxed);
+        }
+        sums_us[i] += pShard->sums_us[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::ostringstream text;
+  text.precision(12);
+  for (size_t i = 0UL; i < NUMBER_OF_COUNTERS; ++i)
+  {
+    text << "# HELP " << COUNTERS[i].pName << " " << COUNTERS[i].pHelp << "\n"
+         << "# TYPE " << COUNTERS[i].pName << " counter\n"
+         << COUNTERS[i].pName << " " << counters[i] << "\n";
+  }
+  for (size_t i = 0UL; i < NUMBER_OF_GAUGES; ++i)
+  {
+    text << "# HELP " << GAUGES[i].pName << " " << GAUGES[i].pHelp << "\n"
+         << "# TYPE " << GAUGES[i].pName << " gauge\n"
+         << GAUGES[i].pName << " " << gauges[i] << "\n";
+  }
+  for (size_t i = 0UL; i < NUMBER_OF_HISTOGRAMS; ++i)
+  {
+    // Buckets are cumulative in the exposition
+    text << "# HELP " << HISTOGRAMS[i].pName << " " << HISTOGRAMS[i].pHelp << "\n"
+         << "# TYPE " << HISTOGRAMS[i].pName << " histogram\n";
+    uint64_t count = 0UL;
+    for (size_t bucket = 0UL; bucket < NUMBER_OF_BUCKETS; ++bucket)
+    {
+      count += buckets[i][bucket];
+      text << HISTOGRAMS[i].pName << "_bucket{le=\"";
+      if (bucket < BUCKET_BOUNDS_US.size())
+      {
+        text << (static_cast<double>(BUCKET_BOUNDS_US[bucket]) / 1e6);
+      }
+      else
+      {
+        text << "+Inf";
+      }
+      text << "\"} " << count << "\n";
+    }
+    text << HISTOGRAMS[i].pName << "_sum " << (static_cast<double>(sums_us[i]) / 1e6) << "\n"
+         << HISTOGRAMS[i].pName << "_count " << count << "\n";
+  }
+  return text.str();
+}
+
+
+Metrics::Shard & Metrics::GetShard(void)
+{
+  // Threads register their shard on first use, every later call is lock free
+  static thread_local Shard* pThreadShard = nullptr;
+  if (pThreadShard == nullptr)
+  {
+    std::lock_guard<std::mutex> const lock(shardsMutex);
+    GetShards().emplace_back(new Shard());
+    pThreadShard = GetShards().back().get();
+  }
+  return *pThreadShard;
+}
+
+
+std::vector<std::unique_ptr<Metrics::Shard>> & Metrics::GetShards(void)
+{
+  // Shards outlive their threads, so counters never go backwards
+  static std::vector<std::unique_ptr<Shard>> shards;
+  return shards;
+}
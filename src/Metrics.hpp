@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Counters, gauges and histograms of the game, every thread writes its own shard without locks or read-modify-writes
+class Metrics
+{
+public:
+  enum class Counter : size_t
+  {
+    Ticks,
+    Games,
+    DrawCalls,
+    Allocations,
+    Count
+  };
+
+  enum class Gauge : size_t
+  {
+    ActiveMatches,
+    TextureBytes,
+    Count
+  };
+
+  enum class Histogram : size_t
+  {
+    TickDuration,
+    TickLateness,
+    FrameTime,
+    InputQueue,
+    InputHandling,
+    InputTick,
+    InputRender,
+    InputPresent,
+    InputToPhoton,
+    Count
+  };
+
+  static void Add(Counter const counter, uint64_t const value = 1UL);
+  static void Set(Gauge const gauge, int64_t const value);
+  static void Observe(Histogram const histogram, uint64_t const value_us);
+
+  // Sums up the shards of all threads in Prometheus text format
+  static std::string Expose(void);
+
+private:
+  struct Shard;
+
+  static Shard & GetShard(void);
+  static std::vector<std::unique_ptr<Shard>> & GetShards(void);
+};
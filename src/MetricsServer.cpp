@@ -0,0 +1,155 @@
+#include "MetricsServer.hpp"
+#include "Metrics.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static void CloseSocket(intptr_t const socketFd)
+{
+#ifdef _WIN32
+  closesocket(socketFd);
+#else
+  close(socketFd);
+#endif
+}
+
+
+static void ThrowClosing(intptr_t const socketFd, char const * const pMessage)
+{
+  // The destructor won't run, so the socket is given back here
+  CloseSocket(socketFd);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+  throw std::runtime_error(pMessage);
+}
+
+
+static bool WaitReadable(intptr_t const socketFd, uint32_t const timeout_ms)
+{
+  fd_set sockets;
+  FD_ZERO(&sockets);
+  FD_SET(socketFd, &sockets);
+  timeval timeout = { 0, static_cast<long>(timeout_ms) * 1000L };
+  return select(static_cast<int>(socketFd) + 1, &sockets, nullptr, nullptr, &timeout) > 0;
+}
+
+
+MetricsServer::MetricsServer(uint16_t const port)
+: socketFd(-1)
+, stop(false)
+, thread()
+{
+#ifdef _WIN32
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    throw std::runtime_error("MetricsServer::MetricsServer: Winsock could not be initialized.");
+#endif
+
+  socketFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (socketFd < 0)
+    throw std::runtime_error("MetricsServer::MetricsServer: Socket could not be created.");
+
+  int const reuse = 1;
+  (void)setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const *>(&reuse), sizeof(reuse));
+
+  // Only the loopback interface, the metrics are not meant to leave the host
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(socketFd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) < 0)
+    ThrowClosing(socketFd, "MetricsServer::MetricsServer: Socket could not be bound.");
+  if (listen(socketFd, 4) < 0)
+    ThrowClosing(socketFd, "MetricsServer::MetricsServer: Socket could not listen.");
+
+  thread = std::thread(&MetricsServer::Run, this);
+}
+
+
+MetricsServer::~MetricsServer(void)
+{
+  stop = true;
+  thread.join();
+  CloseSocket(socketFd);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+
+void MetricsServer::Run(void)
+{
+  while (!stop)
+  {
+    // Wake up now and then to notice the stop
+    if (!WaitReadable(socketFd, POLL_PERIOD_MS))
+    {
+      continue;
+    }
+
+    intptr_t const connectionFd = accept(socketFd, nullptr, nullptr);
+    if (connectionFd >= 0)
+    {
+      Answer(connectionFd);
+      CloseSocket(connectionFd);
+    }
+  }
+}
+
+
+void MetricsServer::Answer(intptr_t const connectionFd)
+{
+  // A client sending nothing must not keep the thread from stopping
+  uint32_t waited_ms = 0U;
+  while (!WaitReadable(connectionFd, POLL_PERIOD_MS))
+  {
+    waited_ms += POLL_PERIOD_MS;
+    if (stop || (waited_ms >= REQUEST_TIMEOUT_MS))
+    {
+      return;
+    }
+  }
+
+  // Requests are short, the first segment holds the request line
+  char request[1024];
+  long const received = recv(connectionFd, request, sizeof(request) - 1U, 0);
+  if (received <= 0)
+  {
+    return;
+  }
+  request[received] = '\0';
+
+  bool const found = (std::strncmp(request, "GET /metrics ", 13U) == 0) || (std::strncmp(request, "GET / ", 6U) == 0);
+  std::string const body = found ? Metrics::Expose() : "not found\n";
+  std::string const response = std::string(found ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 404 Not Found\r\n")
+                             + "Content-Type: text/plain; version=0.0.4\r\n"
+                             + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                             + "Connection: close\r\n\r\n"
+                             + body;
+
+  size_t sent = 0UL;
+  while (sent < response.size())
+  {
+    long const result = send(connectionFd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+    if (result <= 0)
+    {
+      return;
+    }
+    sent += static_cast<size_t>(result);
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Serves the metrics on http://127.0.0.1:<port>/metrics, scrapes are answered by an own thread
+class MetricsServer
+{
+public:
+  MetricsServer(uint16_t const port);
+  ~MetricsServer(void);
+
+private:
+  static uint32_t constexpr POLL_PERIOD_MS = 100U;
+  // Clients which connect but send no request are dropped after this
+  static uint32_t constexpr REQUEST_TIMEOUT_MS = 2000U;
+
+  intptr_t socketFd;
+  std::atomic<bool> stop;
+  std::thread thread;
+
+  void Run(void);
+  void Answer(intptr_t const connectionFd);
+};
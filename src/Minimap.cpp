@@ -0,0 +1,125 @@
+#include "Minimap.hpp"
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <SDL_pixels.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MINIMAP_SSE2
+#endif
+
+Minimap::Minimap(Position const & boardSize)
+: boardSize(boardSize)
+, blockSize{ (boardSize.x + MAX_SIZE - 1) / MAX_SIZE, (boardSize.y + MAX_SIZE - 1) / MAX_SIZE }
+, size{ (boardSize.x + blockSize.x - 1) / blockSize.x, (boardSize.y + blockSize.y - 1) / blockSize.y }
+, palette()
+, pixels(static_cast<size_t>(size.x) * size.y, 0U)
+, dirty(pixels.size(), 0U)
+, dirtyPixels()
+{
+  // Every pixel may become dirty at once, marking them never allocates
+  dirtyPixels.reserve(pixels.size());
+}
+
+
+void Minimap::SetColor(Simulation::Cell const cell, SDL_Color const & color)
+{
+  // ABGR8888, alpha in the high byte
+  palette[cell] = 0xFF000000U | (static_cast<uint32_t>(color.b) << 16) | (static_cast<uint32_t>(color.g) << 8) | color.r;
+}
+
+
+bool Minimap::Update(Simulation & simulation)
+{
+  std::vector<Simulation::Cell> const & field = simulation.GetState().field;
+  if (simulation.IsFieldChanged())
+  {
+    for (size_t pixel = 0UL; pixel < pixels.size(); ++pixel)
+    {
+      pixels[pixel] = palette[PoolBlock(field, pixel)];
+      dirty[pixel] = 0U;
+    }
+    dirtyPixels.clear();
+    simulation.ClearChangedCells();
+    return true;
+  }
+
+  // Only the blocks of written cells are pooled again
+  for (Position const & cell : simulation.GetChangedCells())
+  {
+    MarkDirty(cell);
+  }
+  simulation.ClearChangedCells();
+
+  bool const changed = !dirtyPixels.empty();
+  for (size_t const pixel : dirtyPixels)
+  {
+    pixels[pixel] = palette[PoolBlock(field, pixel)];
+    dirty[pixel] = 0U;
+  }
+  dirtyPixels.clear();
+  return changed;
+}
+
+
+Position Minimap::GetSize(void) const
+{
+  return size;
+}
+
+
+uint32_t const * Minimap::GetPixels(void) const
+{
+  return pixels.data();
+}
+
+
+void Minimap::MarkDirty(Position const & cell)
+{
+  size_t const pixel = static_cast<size_t>(cell.y / blockSize.y) * size.x + (cell.x / blockSize.x);
+  if (dirty[pixel] == 0U)
+  {
+    dirty[pixel] = 1U;
+    dirtyPixels.push_back(pixel);
+  }
+}
+
+
+uint8_t Minimap::PoolBlock(std::vector<Simulation::Cell> const & field, size_t const pixel) const
+{
+  int const x0 = static_cast<int>(pixel % size.x) * blockSize.x;
+  int const y0 = static_cast<int>(pixel / size.x) * blockSize.y;
+  int const x1 = std::min(x0 + blockSize.x, boardSize.x);
+  int const y1 = std::min(y0 + blockSize.y, boardSize.y);
+
+  uint8_t result = Simulation::FREE;
+#ifdef MINIMAP_SSE2
+  __m128i maximum = _mm_setzero_si128();
+#endif
+  for (int y = y0; y < y1; ++y)
+  {
+    Simulation::Cell const * const pRow = field.data() + static_cast<size_t>(y) * boardSize.x;
+    int x = x0;
+#ifdef MINIMAP_SSE2
+    for (; x + 16 <= x1; x += 16)
+    {
+      maximum = _mm_max_epu8(maximum, _mm_loadu_si128(reinterpret_cast<__m128i const *>(pRow + x)));
+    }
+#endif
+    for (; x < x1; ++x)
+    {
+      result = std::max(result, pRow[x]);
+    }
+  }
+
+#ifdef MINIMAP_SSE2
+  // Fold the 16 lanes down to one
+  maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 8));
+  maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 4));
+  maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 2));
+  maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 1));
+  result = std::max(result, static_cast<uint8_t>(_mm_cvtsi128_si32(maximum) & 0xFF));
+#endif
+  return result;
+}
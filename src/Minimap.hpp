@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef struct SDL_Color SDL_Color;
+
+// Overview of the whole board, every pixel shows the highest cell of its block of cells
+class Minimap
+{
+public:
+  Minimap(Position const & boardSize);
+
+  void SetColor(Simulation::Cell const cell, SDL_Color const & color);
+  bool Update(Simulation & simulation);
+
+  Position GetSize(void) const;
+  uint32_t const * GetPixels(void) const;
+
+private:
+  static int constexpr MAX_SIZE = 128;
+
+  Position boardSize;
+  Position blockSize;
+  Position size;
+  std::array<uint32_t, 256> palette;
+  std::vector<uint32_t> pixels;
+  std::vector<uint8_t> dirty;
+  std::vector<size_t> dirtyPixels;
+
+  void MarkDirty(Position const & cell);
+  uint8_t PoolBlock(std::vector<Simulation::Cell> const & field, size_t const pixel) const;
+};
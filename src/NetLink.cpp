@@ -0,0 +1,117 @@
+#include "NetLink.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static sockaddr_in LoopbackAddress(uint16_t const port)
+{
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+
+NetLink::NetLink(uint16_t const localPort, uint16_t const remotePort,
+                 uint32_t const minDelay_ms, uint32_t const maxDelay_ms)
+: socketFd(-1)
+, remotePort(remotePort)
+, minDelay_ms(minDelay_ms)
+, maxDelay_ms((maxDelay_ms < minDelay_ms) ? minDelay_ms : maxDelay_ms)
+, delayRandom(localPort)
+, delayedPackets()
+{
+#ifdef _WIN32
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    throw std::runtime_error("NetLink::NetLink: Winsock could not be initialized.");
+#endif
+
+  socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (socketFd < 0)
+    throw std::runtime_error("NetLink::NetLink: Socket could not be created.");
+
+  // Only the loopback interface, the link is not meant to leave the host
+  sockaddr_in const address = LoopbackAddress(localPort);
+  if (bind(socketFd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) < 0)
+    throw std::runtime_error("NetLink::NetLink: Socket could not be bound.");
+
+#ifdef _WIN32
+  u_long nonBlocking = 1UL;
+  ioctlsocket(socketFd, FIONBIO, &nonBlocking);
+#else
+  fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+
+NetLink::~NetLink(void)
+{
+#ifdef _WIN32
+  closesocket(socketFd);
+  WSACleanup();
+#else
+  close(socketFd);
+#endif
+}
+
+
+void NetLink::Send(void const * const pData, size_t const size)
+{
+  if (maxDelay_ms == 0U)
+  {
+    SendNow(pData, size);
+    return;
+  }
+
+  // Emulate a slow link, jitter may reorder packets like a real network
+  uint32_t const delay_ms = minDelay_ms + (delayRandom() % (maxDelay_ms - minDelay_ms + 1U));
+  uint8_t const * const pBytes = static_cast<uint8_t const *>(pData);
+  delayedPackets.push_back({ std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms),
+                             std::vector<uint8_t>(pBytes, pBytes + size) });
+  Flush();
+}
+
+
+size_t NetLink::Receive(void* const pData, size_t const size)
+{
+  Flush();
+
+  long const received = recv(socketFd, static_cast<char*>(pData), size, 0);
+  return (received > 0) ? static_cast<size_t>(received) : 0UL;
+}
+
+
+void NetLink::Flush(void)
+{
+  std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now();
+  for (size_t i = 0UL; i < delayedPackets.size();)
+  {
+    if (delayedPackets[i].due <= now)
+    {
+      SendNow(delayedPackets[i].data.data(), delayedPackets[i].data.size());
+      delayedPackets.erase(delayedPackets.begin() + i);
+    }
+    else
+    {
+      ++i;
+    }
+  }
+}
+
+
+void NetLink::SendNow(void const * const pData, size_t const size)
+{
+  sockaddr_in const address = LoopbackAddress(remotePort);
+  (void)sendto(socketFd, static_cast<char const *>(pData), size, 0,
+               reinterpret_cast<sockaddr const *>(&address), sizeof(address));
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+class NetLink
+{
+public:
+  NetLink(uint16_t const localPort, uint16_t const remotePort,
+          uint32_t const minDelay_ms = 0U, uint32_t const maxDelay_ms = 0U);
+  ~NetLink(void);
+
+  void Send(void const * const pData, size_t const size);
+  size_t Receive(void* const pData, size_t const size);
+  void Flush(void);
+
+private:
+  struct DelayedPacket
+  {
+    std::chrono::steady_clock::time_point due;
+    std::vector<uint8_t> data;
+  };
+
+  intptr_t socketFd;
+  uint16_t remotePort;
+  uint32_t minDelay_ms;
+  uint32_t maxDelay_ms;
+  std::minstd_rand delayRandom;
+  std::vector<DelayedPacket> delayedPackets;
+
+  void SendNow(void const * const pData, size_t const size);
+};
@@ -0,0 +1,135 @@
+#include "NetSelftest.hpp"
+#include "NetLink.hpp"
+#include "RollbackSession.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Faster than the game's tick, so the delay covers several ticks and forces rollbacks
+static uint32_t constexpr SELFTEST_TICK_PERIOD_MS = 10U;
+static uint32_t constexpr SELFTEST_MATCH_TIMEOUT_MS = 30000U;
+
+static int RunPeer(bool const host, uint16_t const port, uint32_t const matches,
+                   uint32_t const minDelay_ms, uint32_t const maxDelay_ms)
+{
+  char const * const pName = host ? "host" : "client";
+  NetLink link(host ? port : port + 1U, host ? port + 1U : port, minDelay_ms, maxDelay_ms);
+  Simulation simulation({ 19, 19 });
+  RollbackSession session(simulation, link, host ? 0UL : 1UL);
+  std::mt19937 random(host ? 1U : 2U);
+
+  uint32_t identical = 0U;
+  uint32_t desyncs = 0U;
+  bool matchActive = false;
+  std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point matchStart = nextTick;
+  std::chrono::steady_clock::time_point verdictTime = nextTick;
+
+  while ((identical + desyncs) < matches)
+  {
+    std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now();
+
+    if (host && (!matchActive) && (now >= verdictTime))
+    {
+      session.Start(random());
+      matchActive = true;
+      matchStart = now;
+    }
+
+    if (session.Poll())
+    {
+      matchActive = true;
+      matchStart = now;
+    }
+
+    if (matchActive && (now >= nextTick))
+    {
+      nextTick = now + std::chrono::milliseconds(SELFTEST_TICK_PERIOD_MS);
+
+      // Random turns like a nervous player
+      if ((random() % 4U) == 0U)
+      {
+        (void)session.Steer(static_cast<Simulation::Direction>(random() % 4U));
+      }
+      if (session.CanAdvance())
+      {
+        (void)session.Advance();
+      }
+
+      RollbackSession::Verdict const verdict = session.GetVerdict();
+      if (verdict != RollbackSession::Verdict::Pending)
+      {
+        matchActive = false;
+        (verdict == RollbackSession::Verdict::Identical) ? ++identical : ++desyncs;
+        std::cout << pName << ": match " << (identical + desyncs) << " after "
+                  << simulation.GetState().numberOfMoves << " ticks "
+                  << ((verdict == RollbackSession::Verdict::Identical) ? "identical" : "DESYNC") << "\n";
+
+        // Give the peer time to receive the last checksum before the next match starts
+        verdictTime = now + std::chrono::milliseconds(2U * maxDelay_ms + 50U);
+      }
+    }
+
+    if (matchActive && ((now - matchStart) > std::chrono::milliseconds(SELFTEST_MATCH_TIMEOUT_MS)))
+    {
+      std::cout << pName << ": match timed out" << std::endl;
+      return 1;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Stay a while, delayed packets for the peer are still on their way
+  std::chrono::steady_clock::time_point const lingerEnd =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(2U * maxDelay_ms + 50U);
+  while (std::chrono::steady_clock::now() < lingerEnd)
+  {
+    link.Flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  RollbackSession::Stats const & stats = session.GetStats();
+  std::cout << pName << ": " << identical << " identical, " << desyncs << " desynced, "
+            << stats.rollbacks << " rollbacks, " << stats.resimulatedTicks << " resimulated ticks, "
+            << "avg " << ((stats.rollbacks > 0UL) ? stats.rollbackTime_us / stats.rollbacks : 0UL) << " us, "
+            << "max " << stats.maxRollbackTime_us << " us per rollback" << std::endl;
+
+  return (desyncs == 0U) ? 0 : 1;
+}
+
+
+int RunNetSelftest(uint16_t const port, uint32_t const matches, uint32_t const minDelay_ms, uint32_t const maxDelay_ms)
+{
+#ifdef _WIN32
+  std::cerr << "Net selftest needs fork(), it is not supported on this platform.\n";
+  return 1;
+#else
+  // Two processes like two players, the client is a forked copy
+  pid_t const pid = fork();
+  if (pid < 0)
+  {
+    std::cerr << "Net selftest: fork failed.\n";
+    return 1;
+  }
+
+  if (pid == 0)
+  {
+    _exit(RunPeer(false, port, matches, minDelay_ms, maxDelay_ms));
+  }
+
+  int const hostResult = RunPeer(true, port, matches, minDelay_ms, maxDelay_ms);
+  int clientStatus = 0;
+  (void)waitpid(pid, &clientStatus, 0);
+  bool const clientOk = WIFEXITED(clientStatus) && (WEXITSTATUS(clientStatus) == 0);
+
+  std::cout << "Net selftest " << (((hostResult == 0) && clientOk) ? "passed" : "FAILED") << "\n";
+  return ((hostResult == 0) && clientOk) ? 0 : 1;
+#endif
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <cstdint>
+
+int RunNetSelftest(uint16_t const port, uint32_t const matches, uint32_t const minDelay_ms, uint32_t const maxDelay_ms);
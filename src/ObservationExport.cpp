@@ -0,0 +1,292 @@
+#include "ObservationExport.hpp"
+#include "BoardAnalysis.hpp"
+#include "Bot.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+enum Plane : size_t
+{
+  OWN_BODY,
+  ENEMY_BODY,
+  HEADS,
+  APPLES,
+  NUMBER_OF_PLANES
+};
+
+static float constexpr EAT_REWARD = 1.0F;
+static float constexpr DEATH_REWARD = -1.0F;
+// Pages already written are dropped from the mapping in windows of this size, the page cache writes them back
+static size_t constexpr RELEASE_WINDOW_BYTES = 64UL << 20;
+// Numpy aligns the data behind the header to this
+static size_t constexpr NPY_ALIGNMENT = 64UL;
+
+// Where a worker writes to, the records follow the .npy header back to back
+struct ExportFile
+{
+  std::string path;
+  uint8_t* pMemory;
+  size_t bytes;
+  size_t headerBytes;
+  size_t recordBytes;
+  uint64_t records;
+  // Statistics
+  uint64_t games;
+  uint64_t ticks;
+  bool failed;
+};
+
+static std::string BuildHeader(Position const & size, uint64_t const records)
+{
+  // One structured record per observation, np.load(path, mmap_mode='r')['planes'] gives the board planes
+  std::string header = "{'descr': [('planes', '|u1', (" + std::to_string(NUMBER_OF_PLANES) + ", "
+                     + std::to_string(size.y) + ", " + std::to_string(size.x) + ")), ('action', '|u1'), ('reward', '<f4')], "
+                     + "'fortran_order': False, 'shape': (" + std::to_string(records) + ",), }";
+  size_t const prefixBytes = 10UL;
+  size_t const paddedBytes = (prefixBytes + header.size() + 1UL + NPY_ALIGNMENT - 1UL) / NPY_ALIGNMENT * NPY_ALIGNMENT;
+  header.append(paddedBytes - prefixBytes - header.size() - 1UL, ' ');
+  header.push_back('\n');
+
+  // Magic, version 1.0 and the little endian length of the dictionary
+  std::string const prefix = { '\x93', 'N', 'U', 'M', 'P', 'Y', '\x01', '\x00',
+                               static_cast<char>(header.size() & 0xFFU), static_cast<char>(header.size() >> 8) };
+  return prefix + header;
+}
+
+
+#ifndef _WIN32
+static bool OpenFile(ExportFile & file, Position const & size)
+{
+  std::string const header = BuildHeader(size, file.records);
+  file.headerBytes = header.size();
+  file.bytes = file.headerBytes + file.records * file.recordBytes;
+
+  // The space is allocated up front, a full disk can't hit the mapped pages later
+  int const descriptor = open(file.path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (descriptor < 0)
+  {
+    return false;
+  }
+  bool const allocated = (posix_fallocate(descriptor, 0, static_cast<off_t>(file.bytes)) == 0);
+  void* const pMemory = allocated ? mmap(nullptr, file.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+  (void)close(descriptor);
+  if (pMemory == MAP_FAILED)
+  {
+    return false;
+  }
+
+  file.pMemory = static_cast<uint8_t*>(pMemory);
+  (void)madvise(file.pMemory, file.bytes, MADV_SEQUENTIAL);
+  std::memcpy(file.pMemory, header.data(), header.size());
+  return true;
+}
+
+
+static void ReleaseWritten(ExportFile & file, size_t & released, size_t const written)
+{
+  // Only whole windows before the next record, their records are complete and never touched again
+  size_t const end = written / RELEASE_WINDOW_BYTES * RELEASE_WINDOW_BYTES;
+  if (end > released)
+  {
+    (void)madvise(file.pMemory + released, end - released, MADV_DONTNEED);
+    released = end;
+  }
+}
+
+
+static void WriteObservation(Simulation const & simulation, size_t const player, uint8_t* const pRecord)
+{
+  Simulation::State const & state = simulation.GetState();
+  size_t const cells = state.field.size();
+  Simulation::Cell const own = static_cast<Simulation::Cell>(player + 1UL);
+
+  // Both body planes are written in full, so the record needs no clearing for them
+  uint8_t* const pOwn = pRecord + OWN_BODY * cells;
+  uint8_t* const pEnemy = pRecord + ENEMY_BODY * cells;
+  Simulation::Cell const * const pField = state.field.data();
+  for (size_t cell = 0UL; cell < cells; ++cell)
+  {
+    pOwn[cell] = (pField[cell] == own) ? 1U : 0U;
+    pEnemy[cell] = ((pField[cell] != Simulation::FREE) && (pField[cell] != own)) ? 1U : 0U;
+  }
+
+  uint8_t* const pHeads = pRecord + HEADS * cells;
+  uint8_t* const pApples = pRecord + APPLES * cells;
+  std::memset(pHeads, 0, 2UL * cells);
+  int const width = simulation.GetSize().x;
+  for (Simulation::Snake const & snake : state.snakes)
+  {
+    if (snake.alive)
+    {
+      pHeads[static_cast<size_t>(snake.Head().y) * width + snake.Head().x] = 1U;
+    }
+  }
+  if (simulation.HasApple())
+  {
+    pApples[static_cast<size_t>(state.apple.y) * width + state.apple.x] = 1U;
+  }
+  for (size_t item = 0UL; item < state.items.GetNumberOfItems(); ++item)
+  {
+    ItemLayer::Item const & current = state.items.GetItem(item);
+    if (current.type != ItemLayer::Type::Scissors)
+    {
+      pApples[current.cell] = 1U;
+    }
+  }
+}
+
+
+static void PlayGames(Options const & options, uint64_t const firstSeed, ExportFile & file)
+{
+  Position const size = options.boardSize;
+  size_t const cells = static_cast<size_t>(size.x) * size.y;
+  size_t const numberOfPlayers = std::max(options.arenaPlayers, 1U);
+  // Bots circling without eating are stopped after they could have visited every cell, like in training
+  uint64_t const maxTicksSinceApple = cells;
+
+  Simulation simulation(size);
+  BoardAnalysis analysis;
+  std::vector<uint8_t*> pendingRecords(numberOfPlayers, nullptr);
+  uint8_t* pRecord = file.pMemory + file.headerBytes;
+  uint8_t* const pEnd = pRecord + file.records * file.recordBytes;
+  size_t released = 0UL;
+
+  for (uint64_t seed = firstSeed; pRecord < pEnd; ++seed)
+  {
+    simulation.Restart(numberOfPlayers, seed);
+    uint64_t ticksSinceApple = 0UL;
+    while (simulation.GetState().running && (ticksSinceApple < maxTicksSinceApple) && (pRecord < pEnd))
+    {
+      // Every living snake observes the board before the step and gets the reward of its move after it
+      std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+      analysis.Analyze(simulation.GetState().field, size);
+      for (size_t i = 0UL; i < snakes.size(); ++i)
+      {
+        pendingRecords[i] = nullptr;
+        if (snakes[i].alive)
+        {
+          Simulation::Direction const direction = ChooseBotDirection(simulation, analysis, i);
+          simulation.SetPressedDirection(i, direction);
+          if (pRecord < pEnd)
+          {
+            WriteObservation(simulation, i, pRecord);
+            pRecord[NUMBER_OF_PLANES * cells] = static_cast<uint8_t>(direction);
+            pendingRecords[i] = pRecord;
+            pRecord += file.recordBytes;
+          }
+        }
+      }
+
+      (void)simulation.Step();
+      ++file.ticks;
+      ++ticksSinceApple;
+
+      for (size_t i = 0UL; i < snakes.size(); ++i)
+      {
+        if (pendingRecords[i] == nullptr)
+        {
+          continue;
+        }
+        // The apple plane of the observation tells whether the new head found an apple
+        float reward = DEATH_REWARD;
+        if (snakes[i].alive)
+        {
+          Position const head = snakes[i].Head();
+          bool const ate = (pendingRecords[i][APPLES * cells + static_cast<size_t>(head.y) * size.x + head.x] != 0U);
+          reward = ate ? EAT_REWARD : 0.0F;
+          ticksSinceApple = ate ? 0UL : ticksSinceApple;
+        }
+        std::memcpy(pendingRecords[i] + NUMBER_OF_PLANES * cells + 1UL, &reward, sizeof(reward));
+      }
+      ReleaseWritten(file, released, static_cast<size_t>(pRecord - file.pMemory));
+    }
+    ++file.games;
+  }
+}
+#endif
+
+
+int RunObservationExport(Options const & options)
+{
+#ifdef _WIN32
+  (void)options;
+  std::cerr << "Observation export needs mmap(), it is not supported on this platform.\n";
+  return 1;
+#else
+  Position const size = options.boardSize;
+  size_t const cells = static_cast<size_t>(size.x) * size.y;
+  uint64_t const numberOfRecords = options.headlessTicks;
+  size_t const numberOfWorkers = std::max(std::thread::hardware_concurrency(), 1U);
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+  // Every worker fills its own file, so no two ever write the same pages
+  std::vector<ExportFile> files(numberOfWorkers);
+  for (size_t worker = 0UL; worker < numberOfWorkers; ++worker)
+  {
+    ExportFile & file = files[worker];
+    file.path = options.exportOutput + "-" + std::to_string(worker) + ".npy";
+    file.pMemory = nullptr;
+    file.recordBytes = NUMBER_OF_PLANES * cells + sizeof(uint8_t) + sizeof(float);
+    file.records = numberOfRecords * (worker + 1UL) / numberOfWorkers - numberOfRecords * worker / numberOfWorkers;
+    file.games = 0UL;
+    file.ticks = 0UL;
+    file.failed = !OpenFile(file, size);
+    if (file.failed)
+    {
+      std::cerr << "Observations " << file.path << " could not be created\n";
+    }
+  }
+
+  {
+    std::vector<std::thread> workers;
+    for (size_t worker = 0UL; worker < numberOfWorkers; ++worker)
+    {
+      if (!files[worker].failed)
+      {
+        // Seeds far apart per worker, so no two workers play the same game
+        workers.emplace_back(PlayGames, std::cref(options), (static_cast<uint64_t>(worker) << 32) + 1UL, std::ref(files[worker]));
+      }
+    }
+    for (std::thread & worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  uint64_t games = 0UL;
+  uint64_t ticks = 0UL;
+  uint64_t bytes = 0UL;
+  bool failed = false;
+  for (ExportFile const & file : files)
+  {
+    if (file.pMemory != nullptr)
+    {
+      (void)munmap(file.pMemory, file.bytes);
+    }
+    games += file.games;
+    ticks += file.ticks;
+    bytes += file.bytes;
+    failed = failed || file.failed;
+  }
+
+  double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << numberOfRecords << " observations of " << games << " games and " << ticks << " ticks on "
+            << numberOfWorkers << " cores in " << seconds << " s, "
+            << static_cast<uint64_t>(numberOfRecords / std::max(seconds, 1e-9)) << " observations/s, "
+            << static_cast<uint64_t>(bytes / std::max(seconds, 1e-9) / 1048576.0) << " MiB/s\n"
+            << "written to " << options.exportOutput << "-<0.." << (numberOfWorkers - 1UL) << ">.npy\n";
+  return failed ? 1 : 0;
+#endif
+}
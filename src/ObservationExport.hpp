@@ -0,0 +1,6 @@
+#pragma once
+
+struct Options;
+
+// Plays bot games on all cores and writes an observation of every snake and tick into memory mapped .npy files, one per core
+int RunObservationExport(Options const & options);
@@ -0,0 +1,243 @@
+#include "Options.hpp"
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static Position ParseResolution(char* pResString)
+{
+  Position resolution;
+  char* pArgv = strtok(pResString, "xX");
+  try {
+    resolution.x = std::stoi(pArgv);
+    pArgv = strtok(nullptr, "xX");
+    resolution.y = std::stoi(pArgv);
+  } catch (...) {
+    resolution = { 0, 0 };
+  }
+  return resolution;
+}
+
+
+static void ParseDelay(char const * const pDelayString, Options & options)
+{
+  // Either a fixed delay "<ms>" or a jittering delay "<min>-<max>"
+  std::string const delayString(pDelayString);
+  size_t const dash = delayString.find('-');
+  try {
+    options.netMinDelay_ms = std::stoul(delayString.substr(0, dash));
+    options.netMaxDelay_ms = (dash == std::string::npos) ? options.netMinDelay_ms
+                                                         : std::stoul(delayString.substr(dash + 1U));
+  } catch (...) {
+    options.netMinDelay_ms = 0U;
+    options.netMaxDelay_ms = 0U;
+  }
+}
+
+
+static bool ParseBotPlugin(char const * const pPluginString, Options::BotPlugin & plugin)
+{
+  // "<player>:<library>" with players counted from 1 like on screen
+  std::string const pluginString(pPluginString);
+  size_t const colon = pluginString.find(':');
+  try {
+    unsigned long const player = std::stoul(pluginString.substr(0, colon));
+    if ((colon == std::string::npos) || (player == 0UL) || (player > Simulation::MAX_PLAYERS))
+    {
+      return false;
+    }
+    plugin.player = static_cast<uint32_t>(player - 1UL);
+    plugin.path = pluginString.substr(colon + 1U);
+  } catch (...) {
+    return false;
+  }
+  return !plugin.path.empty();
+}
+
+
+static unsigned long ParseNumber(char const * const pNumberString, unsigned long const fallback)
+{
+  try {
+    return std::stoul(pNumberString);
+  } catch (...) {
+    return fallback;
+  }
+}
+
+
+Options ParseOptions(int argc, char* argv[])
+{
+  Options options;
+  for (int i = 1; i < argc; ++i)
+  {
+    bool const hasValue = (i + 1) < argc;
+    if ((strcmp(argv[i], "--host") == 0) && hasValue)
+    {
+      options.netRole = Options::NetRole::Host;
+      options.netPort = ParseNumber(argv[++i], options.netPort);
+    }
+    else if ((strcmp(argv[i], "--join") == 0) && hasValue)
+    {
+      options.netRole = Options::NetRole::Join;
+      options.netPort = ParseNumber(argv[++i], options.netPort);
+    }
+    else if ((strcmp(argv[i], "--net-delay") == 0) && hasValue)
+    {
+      ParseDelay(argv[++i], options);
+    }
+    else if ((strcmp(argv[i], "--net-selftest") == 0) && hasValue)
+    {
+      options.netSelftestMatches = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--arena") == 0) && hasValue)
+    {
+      options.arenaPlayers = std::min(ParseNumber(argv[++i], 0UL), static_cast<unsigned long>(Simulation::MAX_PLAYERS));
+    }
+    else if ((strcmp(argv[i], "--board") == 0) && hasValue)
+    {
+      Position const boardSize = ParseResolution(argv[++i]);
+      if ((boardSize.x > 0) && (boardSize.y > 0))
+      {
+        options.boardSize = boardSize;
+      }
+    }
+    else if ((strcmp(argv[i], "--headless") == 0) && hasValue)
+    {
+      options.headlessTicks = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--capture") == 0) && hasValue)
+    {
+      options.captureOutput = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--capture-fps") == 0) && hasValue)
+    {
+      options.captureFps = std::max(ParseNumber(argv[++i], options.captureFps), 1UL);
+    }
+    else if ((strcmp(argv[i], "--capture-workers") == 0) && hasValue)
+    {
+      options.captureWorkers = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--renderer") == 0) && hasValue)
+    {
+      options.softwareRenderer = (strcmp(argv[++i], "software") == 0);
+    }
+    else if (strcmp(argv[i], "--renderer-selftest") == 0)
+    {
+      options.rendererSelftest = true;
+    }
+    else if ((strcmp(argv[i], "--renderer-benchmark") == 0) && hasValue)
+    {
+      options.rendererBenchmarkFrames = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--memory-budget") == 0) && hasValue)
+    {
+      options.memoryBudget_MiB = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--audio-buffer") == 0) && hasValue)
+    {
+      options.audioBufferSamples = ParseNumber(argv[++i], 0UL);
+    }
+    else if (strcmp(argv[i], "--audio-selftest") == 0)
+    {
+      options.audioSelftest = true;
+    }
+    else if ((strcmp(argv[i], "--train") == 0) && hasValue)
+    {
+      options.trainGenerations = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--population") == 0) && hasValue)
+    {
+      options.trainPopulation = ParseNumber(argv[++i], options.trainPopulation);
+    }
+    else if ((strcmp(argv[i], "--checkpoint") == 0) && hasValue)
+    {
+      options.trainCheckpoint = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--lockstep") == 0) && hasValue)
+    {
+      options.lockstepGames = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--soak") == 0) && hasValue)
+    {
+      options.soakMinutes = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--alloc-selftest") == 0) && hasValue)
+    {
+      options.allocSelftestFrames = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--export") == 0) && hasValue)
+    {
+      options.exportOutput = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--analyze") == 0) && hasValue)
+    {
+      options.analyticsGames = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--heatmap") == 0) && hasValue)
+    {
+      options.analyticsOutput = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--bot") == 0) && hasValue)
+    {
+      Options::BotPlugin plugin;
+      if (ParseBotPlugin(argv[++i], plugin))
+      {
+        options.botPlugins.push_back(plugin);
+      }
+      else
+      {
+        std::cerr << "Ignoring bot " << argv[i] << ", expected <player>:<library>\n";
+      }
+    }
+    else if ((strcmp(argv[i], "--bot-deadline") == 0) && hasValue)
+    {
+      options.botDeadline_us = ParseNumber(argv[++i], options.botDeadline_us);
+    }
+    else if ((strcmp(argv[i], "--feed") == 0) && hasValue)
+    {
+      options.spectatorFeed = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--watch") == 0) && hasValue)
+    {
+      options.spectatorWatch = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--feed-selftest") == 0) && hasValue)
+    {
+      options.spectatorSelftestReaders = ParseNumber(argv[++i], 0UL);
+    }
+    else if (strcmp(argv[i], "--latency") == 0)
+    {
+      options.traceLatency = true;
+    }
+    else if ((strcmp(argv[i], "--particles") == 0) && hasValue)
+    {
+      options.benchmarkParticles = ParseNumber(argv[++i], 0UL);
+    }
+    else if ((strcmp(argv[i], "--metrics") == 0) && hasValue)
+    {
+      options.metricsPort = static_cast<uint16_t>(ParseNumber(argv[++i], 0UL));
+    }
+    else if (argv[i][0] != '-')
+    {
+      options.resolution = ParseResolution(argv[i]);
+    }
+    else
+    {
+      std::cerr << "Ignoring unknown option " << argv[i] << "\n";
+    }
+  }
+
+  // Leave every snake room to spawn, at least 5 cells per spawn column and row
+  int const spawnColumns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(std::max(options.arenaPlayers, 2U)))));
+  int const minimumSize = std::max(5 * spawnColumns, 7);
+  if ((options.boardSize.x < minimumSize) || (options.boardSize.y < minimumSize))
+  {
+    std::cerr << "Board too small, using " << minimumSize << "x" << minimumSize << " at least\n";
+    options.boardSize = { std::max(options.boardSize.x, minimumSize), std::max(options.boardSize.y, minimumSize) };
+  }
+
+  return options;
+}
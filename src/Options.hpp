@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Position.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Options
+{
+  enum class NetRole
+  {
+    None,
+    Host,
+    Join
+  };
+
+  // Player counted from 0 and the shared library deciding for it
+  struct BotPlugin
+  {
+    uint32_t player;
+    std::string path;
+  };
+
+  Position resolution = { 0, 0 };
+  Position boardSize = { 19, 19 };
+  uint32_t arenaPlayers = 0U;
+  uint64_t headlessTicks = 0UL;
+  std::string exportOutput;
+  NetRole netRole = NetRole::None;
+  uint16_t netPort = 7777U;
+  uint32_t netMinDelay_ms = 0U;
+  uint32_t netMaxDelay_ms = 0U;
+  uint32_t netSelftestMatches = 0U;
+  std::string captureOutput;
+  uint32_t captureFps = 60U;
+  uint32_t captureWorkers = 0U;
+  bool softwareRenderer = false;
+  bool rendererSelftest = false;
+  uint32_t rendererBenchmarkFrames = 0U;
+  uint32_t memoryBudget_MiB = 0U;
+  uint32_t audioBufferSamples = 0U;
+  bool audioSelftest = false;
+  uint16_t metricsPort = 0U;
+  uint32_t trainGenerations = 0U;
+  uint32_t trainPopulation = 256U;
+  std::string trainCheckpoint = "./policy.bin";
+  uint32_t lockstepGames = 0U;
+  uint32_t soakMinutes = 0U;
+  uint32_t allocSelftestFrames = 0U;
+  uint32_t benchmarkParticles = 0U;
+  uint64_t analyticsGames = 0UL;
+  std::string analyticsOutput = "./heatmap";
+  bool traceLatency = false;
+  std::vector<BotPlugin> botPlugins;
+  uint32_t botDeadline_us = 2000U;
+  std::string spectatorFeed;
+  std::string spectatorWatch;
+  uint32_t spectatorSelftestReaders = 0U;
+};
+
+Options ParseOptions(int argc, char* argv[]);
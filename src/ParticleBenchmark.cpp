@@ -0,0 +1,115 @@
+#include "ParticleBenchmark.hpp"
+#include "FrameArena.hpp"
+#include "Options.hpp"
+#include "ParticleSystem.hpp"
+#include "SdlRenderBackend.hpp"
+#include "Soak.hpp"
+#include "SoftwareRenderBackend.hpp"
+#include <SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+static uint32_t constexpr BENCHMARK_FRAMES = 600U;
+static float constexpr FRAME_PERIOD_S = 1.0F / 60.0F;
+static double constexpr FRAME_BUDGET_US = 1000000.0 / 60.0;
+static size_t constexpr BURST_PARTICLES = 3000UL;
+static Position constexpr BENCHMARK_RESOLUTION = { 1920, 1080 };
+static size_t constexpr BENCHMARK_ARENA_CAPACITY = ParticleSystem::MAX_PARTICLES * 3UL * sizeof(SDL_Vertex);
+
+static bool RunFrames(RenderBackend & backend, FrameArena & frameArena, size_t const target)
+{
+  ParticleSystem particles;
+  SDL_Color const color = { 255U, 215U, 0U, 255U };
+  SDL_Color const background = { 0U, 0U, 0U, 255U };
+
+  std::chrono::steady_clock::duration updateTime(0);
+  std::chrono::steady_clock::duration vertexTime(0);
+  std::chrono::steady_clock::duration submitTime(0);
+  std::chrono::steady_clock::duration maxFrameTime(0);
+  uint64_t live = 0UL;
+  for (uint32_t frame = 0U; frame < BENCHMARK_FRAMES; ++frame)
+  {
+    // Bursts all over a 1080p screen replace the particles which died
+    for (size_t burst = 0UL; particles.GetNumberOfParticles() < target; ++burst)
+    {
+      Position const center = { static_cast<int>((frame * 7919U + burst * 104729U) % static_cast<uint32_t>(BENCHMARK_RESOLUTION.x)),
+                                static_cast<int>((frame * 6151U + burst * 15485863U) % static_cast<uint32_t>(BENCHMARK_RESOLUTION.y)) };
+      particles.Emit(center, std::min(BURST_PARTICLES, target - particles.GetNumberOfParticles()), color, 1000.0F, 4.0F);
+    }
+    live += particles.GetNumberOfParticles();
+
+    std::chrono::steady_clock::time_point const updateStart = std::chrono::steady_clock::now();
+    particles.Update(FRAME_PERIOD_S);
+    std::chrono::steady_clock::time_point const vertexStart = std::chrono::steady_clock::now();
+    particles.BuildVertices();
+    // The renderers draw on present, so the frame is presented like in the game
+    std::chrono::steady_clock::time_point const submitStart = std::chrono::steady_clock::now();
+    backend.Clean(background);
+    backend.FillColoredTriangles(particles.GetVertices(), particles.GetColors(), particles.GetNumberOfParticles() * 3UL);
+    backend.Present();
+    std::chrono::steady_clock::time_point const submitEnd = std::chrono::steady_clock::now();
+    frameArena.Reset();
+    updateTime += vertexStart - updateStart;
+    vertexTime += submitStart - vertexStart;
+    submitTime += submitEnd - submitStart;
+    maxFrameTime = std::max(maxFrameTime, submitEnd - updateStart);
+  }
+
+  double const update_us = std::chrono::duration<double, std::micro>(updateTime).count() / BENCHMARK_FRAMES;
+  double const vertex_us = std::chrono::duration<double, std::micro>(vertexTime).count() / BENCHMARK_FRAMES;
+  double const submit_us = std::chrono::duration<double, std::micro>(submitTime).count() / BENCHMARK_FRAMES;
+  double const max_us = std::chrono::duration<double, std::micro>(maxFrameTime).count();
+  bool const inBudget = (update_us + vertex_us + submit_us) < FRAME_BUDGET_US;
+  std::cout << (live / BENCHMARK_FRAMES) << " live particles, " << BENCHMARK_FRAMES << " frames: "
+            << "update " << update_us << " us, vertices " << vertex_us << " us, draw " << submit_us << " us, max "
+            << max_us << " us per frame, " << (100.0 * (update_us + vertex_us + submit_us) / FRAME_BUDGET_US)
+            << "% of a 60 FPS frame" << (inBudget ? "" : " OVER BUDGET") << "\n";
+  return inBudget;
+}
+
+
+int RunParticleBenchmark(Options const & options)
+{
+  size_t const target = std::min(static_cast<size_t>(options.benchmarkParticles), ParticleSystem::MAX_PARTICLES);
+
+  // Without a screen, so the triangles are drawn by SDL's software renderer or by the software backend
+  Soak::UseDummyDrivers();
+  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  {
+    std::cerr << "Particle benchmark: SDL could not be initialized: " << SDL_GetError() << "\n";
+    return 1;
+  }
+  SDL_Window* const pWindow = SDL_CreateWindow("Particle benchmark", 0, 0, BENCHMARK_RESOLUTION.x, BENCHMARK_RESOLUTION.y,
+                                               SDL_WINDOW_HIDDEN);
+  if (pWindow == nullptr)
+  {
+    std::cerr << "Particle benchmark: " << SDL_GetError() << "\n";
+    SDL_Quit();
+    return 1;
+  }
+
+  FrameArena frameArena(BENCHMARK_ARENA_CAPACITY);
+  bool inBudget = false;
+  try {
+    std::unique_ptr<RenderBackend> pBackend;
+    if (options.softwareRenderer)
+    {
+      pBackend.reset(new SoftwareRenderBackend(pWindow, BENCHMARK_RESOLUTION,
+                                               std::max(static_cast<size_t>(std::thread::hardware_concurrency()), 1UL)));
+    }
+    else
+    {
+      pBackend.reset(new SdlRenderBackend(pWindow, BENCHMARK_RESOLUTION, frameArena, true));
+    }
+    inBudget = RunFrames(*pBackend, frameArena, target);
+  } catch (std::exception const & exception) {
+    std::cerr << exception.what() << "\n";
+  }
+
+  SDL_DestroyWindow(pWindow);
+  SDL_Quit();
+  return inBudget ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+struct Options;
+
+// Keeps the particle pool at the given number of live particles and times their update, vertices and drawing per frame
+int RunParticleBenchmark(Options const & options);
@@ -0,0 +1,168 @@
+#include "ParticleSystem.hpp"
+#include "Engine.hpp"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#endif
+
+static size_t constexpr LANES_PER_VECTOR = 4UL;
+static float constexpr TWO_PI = 6.2831853F;
+
+ParticleSystem::ParticleSystem(void)
+: count(0UL)
+, randomState(1U)
+, x(MAX_PARTICLES, 0.0F)
+, y(MAX_PARTICLES, 0.0F)
+, vx(MAX_PARTICLES, 0.0F)
+, vy(MAX_PARTICLES, 0.0F)
+, life(MAX_PARTICLES, 0.0F)
+, shrink(MAX_PARTICLES, 0.0F)
+, colors(MAX_PARTICLES, SDL_Color{ 0U, 0U, 0U, 255U })
+, vertices(MAX_PARTICLES * 3UL, Position{ 0, 0 })
+{
+}
+
+
+void ParticleSystem::Emit(Position const & center, size_t const number, SDL_Color const & color, float const speed, float const size)
+{
+  for (size_t i = 0UL; (i < number) && (count < MAX_PARTICLES); ++i, ++count)
+  {
+    // Uniform directions, slower sparks fill the inside of the burst
+    float const angle = Random() * TWO_PI;
+    float const velocity = speed * (0.2F + 0.8F * Random());
+    x[count] = static_cast<float>(center.x);
+    y[count] = static_cast<float>(center.y);
+    vx[count] = std::cos(angle) * velocity;
+    vy[count] = std::sin(angle) * velocity - speed * 0.5F;
+    life[count] = LIFETIME_S * (0.5F + 0.5F * Random());
+    shrink[count] = size / LIFETIME_S;
+    colors[count] = color;
+  }
+}
+
+
+void ParticleSystem::Update(float const deltaTime_s)
+{
+  // Drag and gravity are the same for every particle within a frame
+  float const drag = std::pow(DRAG, deltaTime_s);
+  float const fall = GRAVITY * deltaTime_s;
+  int anyDead = 0;
+  size_t i = 0UL;
+#ifdef PARTICLES_SSE2
+  __m128 const dragVector = _mm_set1_ps(drag);
+  __m128 const fallVector = _mm_set1_ps(fall);
+  __m128 const deltaVector = _mm_set1_ps(deltaTime_s);
+  __m128 const zero = _mm_setzero_ps();
+  for (; i + LANES_PER_VECTOR <= count; i += LANES_PER_VECTOR)
+  {
+    __m128 const newVx = _mm_mul_ps(_mm_loadu_ps(&vx[i]), dragVector);
+    __m128 const newVy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vy[i]), dragVector), fallVector);
+    __m128 const newLife = _mm_sub_ps(_mm_loadu_ps(&life[i]), deltaVector);
+    _mm_storeu_ps(&vx[i], newVx);
+    _mm_storeu_ps(&vy[i], newVy);
+    _mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(newVx, deltaVector)));
+    _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(newVy, deltaVector)));
+    _mm_storeu_ps(&life[i], newLife);
+    anyDead |= _mm_movemask_ps(_mm_cmple_ps(newLife, zero));
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    vx[i] *= drag;
+    vy[i] = vy[i] * drag + fall;
+    x[i] += vx[i] * deltaTime_s;
+    y[i] += vy[i] * deltaTime_s;
+    life[i] -= deltaTime_s;
+    anyDead |= (life[i] <= 0.0F) ? 1 : 0;
+  }
+
+  // Most frames nobody dies, the others fill the holes from the end
+  for (size_t particle = 0UL; (anyDead != 0) && (particle < count); )
+  {
+    if (life[particle] <= 0.0F)
+    {
+      Remove(particle);
+    }
+    else
+    {
+      ++particle;
+    }
+  }
+}
+
+
+void ParticleSystem::BuildVertices(void)
+{
+  // One triangle per particle pointing up, its size follows the remaining life
+  for (size_t i = 0UL; i < count; ++i)
+  {
+    int const px = static_cast<int>(x[i]);
+    int const py = static_cast<int>(y[i]);
+    int const half = static_cast<int>(life[i] * shrink[i]) + 1;
+    Position* const pTriangle = &vertices[i * 3UL];
+    pTriangle[0] = { px, py - half };
+    pTriangle[1] = { px + half, py + half };
+    pTriangle[2] = { px - half, py + half };
+  }
+}
+
+
+void ParticleSystem::Render(Engine & engine)
+{
+  if (count == 0UL)
+  {
+    return;
+  }
+
+  BuildVertices();
+  engine.RenderColoredGeometry(vertices.data(), colors.data(), count * 3UL);
+}
+
+
+void ParticleSystem::Clear(void)
+{
+  count = 0UL;
+}
+
+
+size_t ParticleSystem::GetNumberOfParticles(void) const
+{
+  return count;
+}
+
+
+Position const * ParticleSystem::GetVertices(void) const
+{
+  return vertices.data();
+}
+
+
+SDL_Color const * ParticleSystem::GetColors(void) const
+{
+  return colors.data();
+}
+
+
+void ParticleSystem::Remove(size_t const index)
+{
+  --count;
+  x[index] = x[count];
+  y[index] = y[count];
+  vx[index] = vx[count];
+  vy[index] = vy[count];
+  life[index] = life[count];
+  shrink[index] = shrink[count];
+  colors[index] = colors[count];
+}
+
+
+float ParticleSystem::Random(void)
+{
+  // xorshift32, the top 24 bits as a fraction
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return static_cast<float>(randomState >> 8) * (1.0F / 16777216.0F);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Position.hpp"
+#include <SDL_pixels.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Engine;
+
+// Short lived sparks in a fixed pool of arrays per property, drawn as one triangle each in a single call
+class ParticleSystem
+{
+public:
+  static size_t constexpr MAX_PARTICLES = 131072UL;
+
+  ParticleSystem(void);
+
+  // Particles beyond the pool are dropped, bursts never allocate
+  void Emit(Position const & center, size_t const number, SDL_Color const & color, float const speed, float const size);
+  void Update(float const deltaTime_s);
+  // Screen triangles of all live particles, with one color per triangle
+  void BuildVertices(void);
+  void Render(Engine & engine);
+  void Clear(void);
+
+  size_t GetNumberOfParticles(void) const;
+  Position const * GetVertices(void) const;
+  SDL_Color const * GetColors(void) const;
+
+private:
+  static float constexpr LIFETIME_S = 1.2F;
+  static float constexpr GRAVITY = 600.0F;
+  // Fraction of the velocity kept after one second
+  static float constexpr DRAG = 0.3F;
+
+  size_t count;
+  uint32_t randomState;
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> vx;
+  std::vector<float> vy;
+  std::vector<float> life;
+  // Half the triangle size per remaining second, particles shrink to nothing
+  std::vector<float> shrink;
+  std::vector<SDL_Color> colors;
+  std::vector<Position> vertices;
+
+  void Remove(size_t const index);
+  float Random(void);
+};
@@ -0,0 +1,191 @@
+#include "PolicyBatch.hpp"
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define POLICY_BATCH_SSE2
+#endif
+
+static size_t constexpr LANES_PER_VECTOR = 4UL;
+
+static Position Move(Position const & position, Simulation::Direction const direction)
+{
+  switch (direction)
+  {
+    case Simulation::Direction::Up:
+      return { position.x, position.y - 1 };
+
+    case Simulation::Direction::Down:
+      return { position.x, position.y + 1 };
+
+    case Simulation::Direction::Left:
+      return { position.x - 1, position.y };
+
+    case Simulation::Direction::Right:
+    default:
+      return { position.x + 1, position.y };
+  }
+}
+
+
+static void GetRelativeDirections(Simulation::Direction const direction, Simulation::Direction (&relative)[3])
+{
+  // Straight, left and right as seen by the snake
+  switch (direction)
+  {
+    case Simulation::Direction::Up:
+      relative[0] = Simulation::Direction::Up;
+      relative[1] = Simulation::Direction::Left;
+      relative[2] = Simulation::Direction::Right;
+      break;
+
+    case Simulation::Direction::Down:
+      relative[0] = Simulation::Direction::Down;
+      relative[1] = Simulation::Direction::Right;
+      relative[2] = Simulation::Direction::Left;
+      break;
+
+    case Simulation::Direction::Left:
+      relative[0] = Simulation::Direction::Left;
+      relative[1] = Simulation::Direction::Down;
+      relative[2] = Simulation::Direction::Up;
+      break;
+
+    case Simulation::Direction::Right:
+    default:
+      relative[0] = Simulation::Direction::Right;
+      relative[1] = Simulation::Direction::Up;
+      relative[2] = Simulation::Direction::Down;
+      break;
+  }
+}
+
+
+// out[o][lane] = sum over i of weights[o][i][lane] * in[i][lane], for every lane at once
+static void MultiplyLanes(float const * const pWeights, float const * const pIn, float* const pOut,
+                          size_t const numberOfIn, size_t const numberOfOut, size_t const lanes)
+{
+  for (size_t out = 0UL; out < numberOfOut; ++out)
+  {
+    float* const pRow = pOut + out * lanes;
+    float const * const pRowWeights = pWeights + out * numberOfIn * lanes;
+    size_t lane = 0UL;
+#ifdef POLICY_BATCH_SSE2
+    for (; lane < lanes; lane += LANES_PER_VECTOR)
+    {
+      __m128 sum = _mm_setzero_ps();
+      for (size_t in = 0UL; in < numberOfIn; ++in)
+      {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pRowWeights + in * lanes + lane), _mm_loadu_ps(pIn + in * lanes + lane)));
+      }
+      _mm_storeu_ps(pRow + lane, sum);
+    }
+#endif
+    for (; lane < lanes; ++lane)
+    {
+      float sum = 0.0F;
+      for (size_t in = 0UL; in < numberOfIn; ++in)
+      {
+        sum += pRowWeights[in * lanes + lane] * pIn[in * lanes + lane];
+      }
+      pRow[lane] = sum;
+    }
+  }
+}
+
+
+PolicyBatch::PolicyBatch(size_t const numberOfLanes)
+: lanes(((numberOfLanes + LANES_PER_VECTOR - 1UL) / LANES_PER_VECTOR) * LANES_PER_VECTOR)
+, hiddenWeights(NUMBER_OF_HIDDEN * NUMBER_OF_INPUTS * lanes, 0.0F)
+, outputWeights(NUMBER_OF_OUTPUTS * NUMBER_OF_HIDDEN * lanes, 0.0F)
+, inputs(NUMBER_OF_INPUTS * lanes, 0.0F)
+, hidden(NUMBER_OF_HIDDEN * lanes, 0.0F)
+, outputs(NUMBER_OF_OUTPUTS * lanes, 0.0F)
+{
+}
+
+
+void PolicyBatch::SetWeights(size_t const lane, float const * const pGenome)
+{
+  // Genomes hold the hidden layer row by row, then the output layer
+  for (size_t weight = 0UL; weight < NUMBER_OF_HIDDEN * NUMBER_OF_INPUTS; ++weight)
+  {
+    hiddenWeights[weight * lanes + lane] = pGenome[weight];
+  }
+  float const * const pOutputGenome = pGenome + NUMBER_OF_HIDDEN * NUMBER_OF_INPUTS;
+  for (size_t weight = 0UL; weight < NUMBER_OF_OUTPUTS * NUMBER_OF_HIDDEN; ++weight)
+  {
+    outputWeights[weight * lanes + lane] = pOutputGenome[weight];
+  }
+}
+
+
+void PolicyBatch::SetInputs(size_t const lane, Simulation const & simulation)
+{
+  Simulation::State const & state = simulation.GetState();
+  Simulation::Snake const & snake = state.snakes[0];
+  Position const head = snake.Head();
+  Simulation::Direction relative[3];
+  GetRelativeDirections(snake.snakeDirection, relative);
+
+  for (size_t move = 0UL; move < 3UL; ++move)
+  {
+    Position const target = Move(head, relative[move]);
+    bool const free = simulation.IsFree(target);
+    int freeNeighbours = 0;
+    if (free)
+    {
+      freeNeighbours += simulation.IsFree({ target.x, target.y - 1 }) ? 1 : 0;
+      freeNeighbours += simulation.IsFree({ target.x, target.y + 1 }) ? 1 : 0;
+      freeNeighbours += simulation.IsFree({ target.x - 1, target.y }) ? 1 : 0;
+      freeNeighbours += simulation.IsFree({ target.x + 1, target.y }) ? 1 : 0;
+    }
+    inputs[move * lanes + lane] = free ? 0.0F : 1.0F;
+    inputs[(3UL + move) * lanes + lane] = static_cast<float>(freeNeighbours) * 0.25F;
+  }
+
+  // The apple's offset turned into the snake's view
+  Position const ahead = Move({ 0, 0 }, relative[0]);
+  Position const left = Move({ 0, 0 }, relative[1]);
+  Position const offset = state.apple - head;
+  int const forward = offset.x * ahead.x + offset.y * ahead.y;
+  int const sideways = offset.x * left.x + offset.y * left.y;
+  inputs[6UL * lanes + lane] = (forward > 0) ? 1.0F : 0.0F;
+  inputs[7UL * lanes + lane] = (forward < 0) ? 1.0F : 0.0F;
+  inputs[8UL * lanes + lane] = (sideways > 0) ? 1.0F : 0.0F;
+  inputs[9UL * lanes + lane] = (sideways < 0) ? 1.0F : 0.0F;
+
+  Position const size = simulation.GetSize();
+  inputs[10UL * lanes + lane] = static_cast<float>(snake.length) / static_cast<float>(size.x * size.y);
+  inputs[11UL * lanes + lane] = 1.0F;
+}
+
+
+void PolicyBatch::Infer(void)
+{
+  MultiplyLanes(hiddenWeights.data(), inputs.data(), hidden.data(), NUMBER_OF_INPUTS, NUMBER_OF_HIDDEN, lanes);
+  for (float & value : hidden)
+  {
+    value = std::max(value, 0.0F);
+  }
+  MultiplyLanes(outputWeights.data(), hidden.data(), outputs.data(), NUMBER_OF_HIDDEN, NUMBER_OF_OUTPUTS, lanes);
+}
+
+
+Simulation::Direction PolicyBatch::GetDirection(size_t const lane, Simulation const & simulation) const
+{
+  Simulation::Direction relative[3];
+  GetRelativeDirections(simulation.GetState().snakes[0].snakeDirection, relative);
+
+  size_t best = 0UL;
+  for (size_t output = 1UL; output < NUMBER_OF_OUTPUTS; ++output)
+  {
+    if (outputs[output * lanes + lane] > outputs[best * lanes + lane])
+    {
+      best = output;
+    }
+  }
+  return relative[best];
+}
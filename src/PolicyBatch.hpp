@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small neural network policies of many games at once, every lane is one game with its own weights
+class PolicyBatch
+{
+public:
+  // Blocked and look ahead per relative move, the apple's side, the length and a bias
+  static size_t constexpr NUMBER_OF_INPUTS = 12UL;
+  static size_t constexpr NUMBER_OF_HIDDEN = 16UL;
+  // Go straight, turn left or turn right
+  static size_t constexpr NUMBER_OF_OUTPUTS = 3UL;
+  static size_t constexpr GENOME_SIZE = NUMBER_OF_HIDDEN * NUMBER_OF_INPUTS + NUMBER_OF_OUTPUTS * NUMBER_OF_HIDDEN;
+
+  PolicyBatch(size_t const numberOfLanes);
+
+  void SetWeights(size_t const lane, float const * const pGenome);
+  void SetInputs(size_t const lane, Simulation const & simulation);
+  void Infer(void);
+  Simulation::Direction GetDirection(size_t const lane, Simulation const & simulation) const;
+
+private:
+  // Lanes are padded to whole vectors, everything is stored lane minor
+  size_t lanes;
+  std::vector<float> hiddenWeights;
+  std::vector<float> outputWeights;
+  std::vector<float> inputs;
+  std::vector<float> hidden;
+  std::vector<float> outputs;
+};
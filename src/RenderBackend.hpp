@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Position.hpp"
+#include <cstddef>
+#include <cstdint>
+
+typedef struct SDL_Color SDL_Color;
+typedef struct SDL_Surface SDL_Surface;
+
+// Texture handle, only the backend which created it knows the pixels behind
+struct Texture
+{
+  Position size;
+};
+
+class RenderBackend
+{
+public:
+  virtual ~RenderBackend(void) = default;
+
+  virtual Texture* CreateTexture(SDL_Surface* const pSurface) = 0;
+  virtual void DestroyTexture(Texture* const pTexture) = 0;
+  // ABGR8888 pixels of the texture's size, replaces the texture's pixels without a new texture
+  virtual void UpdateTexture(Texture* const pTexture, uint32_t const * const pPixels) = 0;
+  virtual void Clean(SDL_Color const & color) = 0;
+  virtual void Copy(Texture* const pTexture, Position const & position, Position const & scale, double const angle) = 0;
+  virtual void FillRect(Position const & position, Position const & scale, SDL_Color const & color) = 0;
+  virtual void FillTriangles(Position const * const pPositions, size_t const count, SDL_Color const & color) = 0;
+  // One color per triangle, so differently colored triangles still take a single call
+  virtual void FillColoredTriangles(Position const * const pPositions, SDL_Color const * const pColors, size_t const count) = 0;
+  virtual void Present(void) = 0;
+  virtual void Resize(Position const & res) = 0;
+
+  // Presented frames as RGBA pixels, finish also returns the frame presented last
+  virtual void EnableCapture(void) = 0;
+  virtual bool HasCapturedFrame(bool const finish) const = 0;
+  virtual void ReadCapturedFrame(uint8_t* const pPixels) = 0;
+};
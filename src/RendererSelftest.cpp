@@ -0,0 +1,365 @@
+#include "RendererSelftest.hpp"
+#include "FrameArena.hpp"
+#include "Options.hpp"
+#include "Position.hpp"
+#include "SdlRenderBackend.hpp"
+#include "Soak.hpp"
+#include "SoftwareRenderBackend.hpp"
+#include <SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Odd sizes, so the right and bottom tiles are cut and rows end between SIMD blocks
+static Position constexpr SELFTEST_RESOLUTION = { 643, 357 };
+static Position constexpr TEXTURE_SIZE = { 67, 45 };
+// The score and its apple are drawn tilted by this angle
+static double constexpr SCORE_ANGLE = 10.0;
+static uint32_t constexpr SELFTEST_FRAMES = 20U;
+// The benchmark covers the screen with copies of the scene
+static Position constexpr BENCHMARK_RESOLUTION = { 1920, 1080 };
+static uint32_t constexpr BENCHMARK_WARM_UP_FRAMES = 3U;
+static size_t constexpr BENCHMARK_ARENA_CAPACITY = 64UL * 1024UL;
+
+// The mesh covers a rectangle across several tiles, its inner vertices are moved so edges run at all angles
+static Position constexpr MESH_ORIGIN = { 37, 29 };
+static Position constexpr MESH_CELL = { 61, 67 };
+static Position constexpr MESH_CELLS = { 8, 4 };
+static int constexpr MESH_JITTER = 12;
+
+static SDL_Color constexpr BACKGROUND = { 30U, 40U, 50U, 255U };
+static SDL_Color constexpr BLACK = { 0U, 0U, 0U, 255U };
+static SDL_Color constexpr WHITE = { 255U, 255U, 255U, 255U };
+
+struct SelftestRun
+{
+  size_t numberOfThreads;
+  bool simd;
+  uint64_t checksum;
+  double frame_us;
+};
+
+static std::vector<Position> BuildMesh(Position const & offset)
+{
+  std::vector<Position> corners;
+  for (int y = 0; y <= MESH_CELLS.y; ++y)
+  {
+    for (int x = 0; x <= MESH_CELLS.x; ++x)
+    {
+      bool const inner = (x > 0) && (x < MESH_CELLS.x) && (y > 0) && (y < MESH_CELLS.y);
+      int const jitterX = inner ? static_cast<int>((x * 7919U + y * 104729U) % (2U * MESH_JITTER + 1U)) - MESH_JITTER : 0;
+      int const jitterY = inner ? static_cast<int>((x * 6151U + y * 15485863U) % (2U * MESH_JITTER + 1U)) - MESH_JITTER : 0;
+      corners.push_back({ offset.x + MESH_ORIGIN.x + x * MESH_CELL.x + jitterX, offset.y + MESH_ORIGIN.y + y * MESH_CELL.y + jitterY });
+    }
+  }
+
+  // Two triangles per cell, alternating the diagonal so vertices are shared by up to eight triangles
+  std::vector<Position> triangles;
+  int const stride = MESH_CELLS.x + 1;
+  for (int y = 0; y < MESH_CELLS.y; ++y)
+  {
+    for (int x = 0; x < MESH_CELLS.x; ++x)
+    {
+      Position const topLeft = corners[y * stride + x];
+      Position const topRight = corners[y * stride + x + 1];
+      Position const bottomLeft = corners[(y + 1) * stride + x];
+      Position const bottomRight = corners[(y + 1) * stride + x + 1];
+      if (((x + y) % 2) == 0)
+      {
+        triangles.insert(triangles.end(), { topLeft, topRight, bottomRight, topLeft, bottomRight, bottomLeft });
+      }
+      else
+      {
+        triangles.insert(triangles.end(), { topLeft, topRight, bottomLeft, topRight, bottomRight, bottomLeft });
+      }
+    }
+  }
+  return triangles;
+}
+
+
+static SDL_Surface* CreateGradient(void)
+{
+  // Every alpha value appears, next to colors which differ in every channel
+  SDL_Surface* const pSurface = SDL_CreateRGBSurfaceWithFormat(0, TEXTURE_SIZE.x, TEXTURE_SIZE.y, 32, SDL_PIXELFORMAT_ABGR8888);
+  if (pSurface == nullptr)
+  {
+    return nullptr;
+  }
+  SDL_LockSurface(pSurface);
+  for (int y = 0; y < TEXTURE_SIZE.y; ++y)
+  {
+    uint32_t* const pRow = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pSurface->pixels) + y * pSurface->pitch);
+    for (int x = 0; x < TEXTURE_SIZE.x; ++x)
+    {
+      uint32_t const alpha = static_cast<uint32_t>(y * TEXTURE_SIZE.x + x) & 0xFFU;
+      uint32_t const red = static_cast<uint32_t>(x * 3) & 0xFFU;
+      uint32_t const green = static_cast<uint32_t>(y * 5) & 0xFFU;
+      uint32_t const blue = static_cast<uint32_t>(x * y) & 0xFFU;
+      pRow[x] = (alpha << 24) | (blue << 16) | (green << 8) | red;
+    }
+  }
+  SDL_UnlockSurface(pSurface);
+  return pSurface;
+}
+
+
+static void RenderScene(RenderBackend & backend, Texture* const pTexture, std::vector<Position> const & mesh, Position const & offset)
+{
+  // Overlapping fills, partly off the screen and ending inside SIMD blocks
+  auto const at = [&offset](int const x, int const y){ return Position{ offset.x + x, offset.y + y }; };
+  backend.FillRect(at(-20, -10), { 101, 83 }, { 200U, 30U, 30U, 255U });
+  backend.FillRect(at(60, 50), { 250, 3 }, { 30U, 200U, 30U, 255U });
+  backend.FillRect(at(127, 63), { 1, 200 }, { 30U, 30U, 200U, 255U });
+  backend.FillRect(at(590, 300), { 100, 100 }, { 250U, 250U, 10U, 255U });
+
+  std::vector<SDL_Color> colors(mesh.size() / 3UL);
+  for (size_t i = 0UL; i < colors.size(); ++i)
+  {
+    colors[i] = { static_cast<uint8_t>(i * 37U), static_cast<uint8_t>(255U - i * 11U), static_cast<uint8_t>(i * 97U), 255U };
+  }
+  backend.FillColoredTriangles(mesh.data(), colors.data(), mesh.size());
+
+  // Alpha blits at their size, scaled, across tile borders and off the screen, then tilted like the score
+  backend.Copy(pTexture, at(61, 70), TEXTURE_SIZE, 0.0);
+  backend.Copy(pTexture, at(250, 30), { 131, 97 }, 0.0);
+  backend.Copy(pTexture, at(3, 190), { 37, 21 }, 0.0);
+  backend.Copy(pTexture, at(610, 330), TEXTURE_SIZE, 0.0);
+  backend.Copy(pTexture, at(330, 180), { 150, 60 }, SCORE_ANGLE);
+  backend.Copy(pTexture, at(100, 250), { 90, 90 }, -SCORE_ANGLE);
+}
+
+
+static uint64_t Checksum(std::vector<uint8_t> const & pixels)
+{
+  // FNV-1a
+  uint64_t hash = 0xCBF29CE484222325UL;
+  for (uint8_t const byte : pixels)
+  {
+    hash = (hash ^ byte) * 0x100000001B3UL;
+  }
+  return hash;
+}
+
+
+static size_t CountCovered(std::vector<uint8_t> const & pixels)
+{
+  size_t covered = 0UL;
+  for (size_t i = 0UL; i < pixels.size(); i += 4UL)
+  {
+    covered += (pixels[i] != 0U) ? 1UL : 0UL;
+  }
+  return covered;
+}
+
+
+static bool RunScene(SDL_Window* const pWindow, SDL_Surface* const pSurface, std::vector<Position> const & mesh,
+                     SelftestRun & run)
+{
+  SoftwareRenderBackend backend(pWindow, SELFTEST_RESOLUTION, run.numberOfThreads, run.simd);
+  backend.EnableCapture();
+  Texture* const pTexture = backend.CreateTexture(pSurface);
+  if (pTexture == nullptr)
+  {
+    return false;
+  }
+
+  std::vector<uint8_t> pixels(static_cast<size_t>(SELFTEST_RESOLUTION.x) * SELFTEST_RESOLUTION.y * 4UL);
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0U; frame < SELFTEST_FRAMES; ++frame)
+  {
+    backend.Clean(BACKGROUND);
+    RenderScene(backend, pTexture, mesh, { 0, 0 });
+    backend.Present();
+  }
+  run.frame_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / SELFTEST_FRAMES;
+  backend.ReadCapturedFrame(pixels.data());
+  run.checksum = Checksum(pixels);
+  backend.DestroyTexture(pTexture);
+  return true;
+}
+
+
+static bool CheckMeshCoverage(SDL_Window* const pWindow, size_t const numberOfThreads, std::vector<Position> const & mesh)
+{
+  // Pixels on shared edges belong to exactly one triangle, so the triangles alone cover the rectangle once
+  SoftwareRenderBackend backend(pWindow, SELFTEST_RESOLUTION, numberOfThreads);
+  backend.EnableCapture();
+  std::vector<uint8_t> pixels(static_cast<size_t>(SELFTEST_RESOLUTION.x) * SELFTEST_RESOLUTION.y * 4UL);
+  size_t const area = static_cast<size_t>(MESH_CELLS.x * MESH_CELL.x) * (MESH_CELLS.y * MESH_CELL.y);
+
+  size_t triangleCoverage = 0UL;
+  for (size_t i = 0UL; i + 3UL <= mesh.size(); i += 3UL)
+  {
+    backend.Clean(BLACK);
+    backend.FillTriangles(&mesh[i], 3UL, WHITE);
+    backend.Present();
+    backend.ReadCapturedFrame(pixels.data());
+    triangleCoverage += CountCovered(pixels);
+  }
+
+  backend.Clean(BLACK);
+  backend.FillTriangles(mesh.data(), mesh.size(), WHITE);
+  backend.Present();
+  backend.ReadCapturedFrame(pixels.data());
+  size_t const meshCoverage = CountCovered(pixels);
+
+  std::cout << (mesh.size() / 3UL) << " triangles over " << area << " pixels: " << meshCoverage << " covered by the mesh, "
+            << triangleCoverage << " by the triangles alone\n";
+  return (meshCoverage == area) && (triangleCoverage == area);
+}
+
+
+int RunRendererSelftest(Options const & options)
+{
+  (void)options;
+  Soak::UseDummyDrivers();
+  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  {
+    std::cerr << "Renderer selftest: SDL could not be initialized: " << SDL_GetError() << "\n";
+    return 1;
+  }
+  SDL_Window* const pWindow = SDL_CreateWindow("Renderer selftest", 0, 0, SELFTEST_RESOLUTION.x, SELFTEST_RESOLUTION.y,
+                                               SDL_WINDOW_HIDDEN);
+  SDL_Surface* const pSurface = CreateGradient();
+  if ((pWindow == nullptr) || (pSurface == nullptr))
+  {
+    std::cerr << "Renderer selftest: " << SDL_GetError() << "\n";
+    SDL_FreeSurface(pSurface);
+    SDL_DestroyWindow(pWindow);
+    SDL_Quit();
+    return 1;
+  }
+
+  // Several workers even on a single core, so the tiles are shared out in a different order every frame
+  size_t const numberOfThreads = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), 4UL);
+  std::vector<Position> const mesh = BuildMesh({ 0, 0 });
+  std::vector<SelftestRun> runs = { { 1UL, false, 0UL, 0.0 }, { 1UL, true, 0UL, 0.0 },
+                                    { numberOfThreads, false, 0UL, 0.0 }, { numberOfThreads, true, 0UL, 0.0 } };
+  bool passed = true;
+  try {
+    for (SelftestRun & run : runs)
+    {
+      passed = RunScene(pWindow, pSurface, mesh, run) && passed;
+      char checksum[17];
+      (void)std::snprintf(checksum, sizeof(checksum), "%016llx", static_cast<unsigned long long>(run.checksum));
+      std::cout << run.numberOfThreads << " threads, " << (run.simd ? "SIMD" : "scalar") << ": checksum " << checksum
+                << ", " << run.frame_us << " us per frame\n";
+      passed = passed && (run.checksum == runs.front().checksum);
+    }
+    passed = CheckMeshCoverage(pWindow, numberOfThreads, mesh) && passed;
+  } catch (std::exception const & exception) {
+    std::cerr << exception.what() << "\n";
+    passed = false;
+  }
+
+  SDL_FreeSurface(pSurface);
+  SDL_DestroyWindow(pWindow);
+  SDL_Quit();
+  std::cout << "Renderer selftest " << (passed ? "passed" : "FAILED") << "\n";
+  return passed ? 0 : 1;
+}
+
+
+static double TimeFrames(RenderBackend & backend, FrameArena & frameArena, SDL_Surface* const pSurface,
+                         std::vector<Position> const & offsets, std::vector<std::vector<Position>> const & meshes,
+                         uint32_t const frames)
+{
+  Texture* const pTexture = backend.CreateTexture(pSurface);
+  if (pTexture == nullptr)
+  {
+    throw std::runtime_error(std::string("RunRendererBenchmark: ") + SDL_GetError());
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0U; frame < BENCHMARK_WARM_UP_FRAMES + frames; ++frame)
+  {
+    if (frame == BENCHMARK_WARM_UP_FRAMES)
+    {
+      start = std::chrono::steady_clock::now();
+    }
+    backend.Clean(BACKGROUND);
+    for (size_t i = 0UL; i < offsets.size(); ++i)
+    {
+      RenderScene(backend, pTexture, meshes[i], offsets[i]);
+    }
+    backend.Present();
+    frameArena.Reset();
+  }
+  double const frame_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+  backend.DestroyTexture(pTexture);
+  return frame_us;
+}
+
+
+int RunRendererBenchmark(Options const & options)
+{
+  Position const resolution = ((options.resolution.x > 0) && (options.resolution.y > 0)) ? options.resolution : BENCHMARK_RESOLUTION;
+  Soak::UseDummyDrivers();
+  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  {
+    std::cerr << "Renderer benchmark: SDL could not be initialized: " << SDL_GetError() << "\n";
+    return 1;
+  }
+  SDL_Window* const pWindow = SDL_CreateWindow("Renderer benchmark", 0, 0, resolution.x, resolution.y, SDL_WINDOW_HIDDEN);
+  SDL_Surface* const pSurface = CreateGradient();
+  if ((pWindow == nullptr) || (pSurface == nullptr))
+  {
+    std::cerr << "Renderer benchmark: " << SDL_GetError() << "\n";
+    SDL_FreeSurface(pSurface);
+    SDL_DestroyWindow(pWindow);
+    SDL_Quit();
+    return 1;
+  }
+
+  // The selftest scene repeated across the screen, the copies at the right and bottom are cut
+  std::vector<Position> offsets;
+  std::vector<std::vector<Position>> meshes;
+  for (int y = 0; y < resolution.y; y += SELFTEST_RESOLUTION.y)
+  {
+    for (int x = 0; x < resolution.x; x += SELFTEST_RESOLUTION.x)
+    {
+      offsets.push_back({ x, y });
+      meshes.push_back(BuildMesh({ x, y }));
+    }
+  }
+
+  size_t const numberOfThreads = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), 1UL);
+  uint32_t const frames = options.rendererBenchmarkFrames;
+  FrameArena frameArena(BENCHMARK_ARENA_CAPACITY);
+  bool passed = true;
+  try {
+    double sdl_us = 0.0;
+    {
+      SdlRenderBackend backend(pWindow, resolution, frameArena, true);
+      sdl_us = TimeFrames(backend, frameArena, pSurface, offsets, meshes, frames);
+    }
+    std::cout << resolution.x << "x" << resolution.y << ", " << offsets.size() << " scenes, " << frames << " frames\n";
+    std::cout << "SDL software renderer: " << sdl_us << " us per frame\n";
+    std::vector<size_t> threadCounts = { 1UL };
+    if (numberOfThreads > 1UL)
+    {
+      threadCounts.push_back(numberOfThreads);
+    }
+    for (size_t const threads : threadCounts)
+    {
+      SoftwareRenderBackend backend(pWindow, resolution, threads);
+      double const frame_us = TimeFrames(backend, frameArena, pSurface, offsets, meshes, frames);
+      std::cout << "Software backend on " << threads << " threads: " << frame_us << " us per frame, "
+                << (sdl_us / frame_us) << "x the SDL software renderer\n";
+    }
+  } catch (std::exception const & exception) {
+    std::cerr << exception.what() << "\n";
+    passed = false;
+  }
+
+  SDL_FreeSurface(pSurface);
+  SDL_DestroyWindow(pWindow);
+  SDL_Quit();
+  return passed ? 0 : 1;
+}
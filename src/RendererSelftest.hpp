@@ -0,0 +1,9 @@
+#pragma once
+
+struct Options;
+
+// Renders a fixed scene with the software renderer on one and on several cores, with and without SIMD, fails if any pixel differs
+int RunRendererSelftest(Options const & options);
+
+// Times the same scene tiled across the screen on SDL's software renderer and on the software backend
+int RunRendererBenchmark(Options const & options);
@@ -0,0 +1,252 @@
+#include "ResourceManager.hpp"
+#include "AudioMixer.hpp"
+#include "Engine.hpp"
+#include "Metrics.hpp"
+#include "RenderBackend.hpp"
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+ResourceManager::Handle::Handle(void)
+: pManager(nullptr)
+, index(0UL)
+{
+}
+
+
+ResourceManager::Handle::Handle(ResourceManager* const pManager, size_t const index)
+: pManager(pManager)
+, index(index)
+{
+  ++pManager->assets[index].references;
+}
+
+
+ResourceManager::Handle::Handle(Handle const & other)
+: pManager(other.pManager)
+, index(other.index)
+{
+  if (pManager != nullptr)
+  {
+    ++pManager->assets[index].references;
+  }
+}
+
+
+ResourceManager::Handle & ResourceManager::Handle::operator=(Handle const & other)
+{
+  if (other.pManager != nullptr)
+  {
+    ++other.pManager->assets[other.index].references;
+  }
+  if (pManager != nullptr)
+  {
+    --pManager->assets[index].references;
+  }
+  pManager = other.pManager;
+  index = other.index;
+  return *this;
+}
+
+
+ResourceManager::Handle::~Handle(void)
+{
+  if (pManager != nullptr)
+  {
+    --pManager->assets[index].references;
+  }
+}
+
+
+Texture* ResourceManager::Handle::GetTexture(void) const
+{
+  return (pManager != nullptr) ? pManager->Use(index).pTexture : nullptr;
+}
+
+
+TTF_Font* ResourceManager::Handle::GetFont(void) const
+{
+  return (pManager != nullptr) ? pManager->Use(index).pFont : nullptr;
+}
+
+
+Mix_Chunk* ResourceManager::Handle::GetSound(void) const
+{
+  return (pManager != nullptr) ? pManager->Use(index).pSound : nullptr;
+}
+
+
+ResourceManager::ResourceManager(Engine & engine, size_t const budget)
+: engine(engine)
+, budget(budget)
+, assets()
+, assetIndices()
+, frameNumber(0UL)
+, cpuBytes(0UL)
+, textureBytes(0UL)
+, loads(0UL)
+, evictions(0UL)
+, peakBytes(0UL)
+{
+}
+
+
+ResourceManager::~ResourceManager(void)
+{
+  for (Asset & asset : assets)
+  {
+    Unload(asset);
+  }
+
+  std::cout << "resources: " << loads << " loads, " << evictions << " evictions, peak "
+            << (peakBytes >> 10) << " KiB\n";
+}
+
+
+ResourceManager::Handle ResourceManager::Picture(char const * const pFile)
+{
+  return Find(Kind::Picture, pFile, 0);
+}
+
+
+ResourceManager::Handle ResourceManager::Font(char const * const pFile, int const size)
+{
+  return Find(Kind::Font, pFile, size);
+}
+
+
+ResourceManager::Handle ResourceManager::Sound(char const * const pFile, int const volume)
+{
+  return Find(Kind::Sound, pFile, volume);
+}
+
+
+void ResourceManager::EndFrame(void)
+{
+  // Over budget, unload the assets unused for the longest time, the ones without handles first
+  while ((budget > 0UL) && ((cpuBytes + textureBytes) > budget))
+  {
+    Asset* pOldest = nullptr;
+    for (Asset & asset : assets)
+    {
+      if (IsLoaded(asset) && (asset.lastUse < frameNumber)
+          && ((pOldest == nullptr)
+              || ((asset.references == 0U) && (pOldest->references > 0U))
+              || (((asset.references == 0U) == (pOldest->references == 0U)) && (asset.lastUse < pOldest->lastUse))))
+      {
+        pOldest = &asset;
+      }
+    }
+
+    if (pOldest == nullptr)
+    {
+      // Everything was needed by this frame
+      break;
+    }
+    Unload(*pOldest);
+    ++evictions;
+  }
+
+  ++frameNumber;
+}
+
+
+ResourceManager::Handle ResourceManager::Find(Kind const kind, char const * const pFile, int const parameter)
+{
+  std::string const key = std::string(pFile) + "#" + std::to_string(parameter);
+  std::unordered_map<std::string, size_t>::const_iterator const found = assetIndices.find(key);
+  if (found != assetIndices.end())
+  {
+    return Handle(this, found->second);
+  }
+
+  assets.push_back({ kind, pFile, parameter, 0U, nullptr, nullptr, nullptr, 0UL, 0UL, 0UL });
+  assetIndices.emplace(key, assets.size() - 1UL);
+  return Handle(this, assets.size() - 1UL);
+}
+
+
+ResourceManager::Asset & ResourceManager::Use(size_t const index)
+{
+  Asset & asset = assets[index];
+  if (!IsLoaded(asset))
+  {
+    Load(asset);
+  }
+  asset.lastUse = frameNumber;
+  return asset;
+}
+
+
+void ResourceManager::Load(Asset & asset)
+{
+  switch (asset.kind)
+  {
+    case Kind::Picture:
+      asset.pTexture = engine.CreatePicTexture(asset.file.c_str());
+      asset.textureBytes = static_cast<size_t>(asset.pTexture->size.x) * asset.pTexture->size.y * 4UL;
+      break;
+
+    case Kind::Font:
+    {
+      asset.pFont = engine.CreateFont(asset.file.c_str(), asset.parameter);
+
+      // FreeType keeps the font file in memory
+      std::ifstream file(asset.file, std::ios::binary | std::ios::ate);
+      asset.cpuBytes = file.is_open() ? static_cast<size_t>(file.tellg()) : 0UL;
+      break;
+    }
+
+    case Kind::Sound:
+      asset.pSound = Mix_LoadWAV(asset.file.c_str());
+      if (asset.pSound == nullptr)
+        throw std::runtime_error("ResourceManager::Load: Sound could not be loaded.");
+      Mix_VolumeChunk(asset.pSound, asset.parameter);
+      asset.cpuBytes = asset.pSound->alen;
+      break;
+  }
+
+  cpuBytes += asset.cpuBytes;
+  textureBytes += asset.textureBytes;
+  peakBytes = std::max(peakBytes, cpuBytes + textureBytes);
+  ++loads;
+  Metrics::Set(Metrics::Gauge::TextureBytes, static_cast<int64_t>(textureBytes));
+}
+
+
+void ResourceManager::Unload(Asset & asset)
+{
+  if (!IsLoaded(asset))
+  {
+    return;
+  }
+
+  engine.DestroyTexture(asset.pTexture);
+  if (asset.pFont != nullptr)
+  {
+    engine.DestroyFont(asset.pFont);
+  }
+  if (asset.pSound != nullptr)
+  {
+    // Freed by the mixer once its callback let go of the sound
+    engine.GetAudio().Forget(asset.pSound);
+  }
+
+  cpuBytes -= asset.cpuBytes;
+  textureBytes -= asset.textureBytes;
+  Metrics::Set(Metrics::Gauge::TextureBytes, static_cast<int64_t>(textureBytes));
+  asset.pTexture = nullptr;
+  asset.pFont = nullptr;
+  asset.pSound = nullptr;
+  asset.cpuBytes = 0UL;
+  asset.textureBytes = 0UL;
+}
+
+
+bool ResourceManager::IsLoaded(Asset const & asset)
+{
+  return (asset.pTexture != nullptr) || (asset.pFont != nullptr) || (asset.pSound != nullptr);
+}
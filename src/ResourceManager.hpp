@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef struct _TTF_Font TTF_Font;
+typedef struct Mix_Chunk Mix_Chunk;
+
+class Engine;
+struct Texture;
+
+class ResourceManager
+{
+public:
+  // Refcounted reference to an asset, which is loaded on the first access
+  class Handle
+  {
+  public:
+    Handle(void);
+    Handle(Handle const & other);
+    Handle & operator=(Handle const & other);
+    ~Handle(void);
+
+    Texture* GetTexture(void) const;
+    TTF_Font* GetFont(void) const;
+    Mix_Chunk* GetSound(void) const;
+
+  private:
+    friend class ResourceManager;
+
+    Handle(ResourceManager* const pManager, size_t const index);
+
+    ResourceManager* pManager;
+    size_t index;
+  };
+
+  // A budget of 0 keeps every asset loaded once it was used
+  ResourceManager(Engine & engine, size_t const budget);
+  ~ResourceManager(void);
+
+  Handle Picture(char const * const pFile);
+  Handle Font(char const * const pFile, int const size);
+  Handle Sound(char const * const pFile, int const volume);
+
+  void EndFrame(void);
+
+private:
+  enum class Kind
+  {
+    Picture,
+    Font,
+    Sound
+  };
+
+  struct Asset
+  {
+    Kind kind;
+    std::string file;
+    int parameter;
+    uint32_t references;
+    Texture* pTexture;
+    TTF_Font* pFont;
+    Mix_Chunk* pSound;
+    size_t cpuBytes;
+    size_t textureBytes;
+    uint64_t lastUse;
+  };
+
+  Engine & engine;
+  size_t budget;
+  std::vector<Asset> assets;
+  std::unordered_map<std::string, size_t> assetIndices;
+  uint64_t frameNumber;
+  size_t cpuBytes;
+  size_t textureBytes;
+
+  // Statistics
+  uint64_t loads;
+  uint64_t evictions;
+  size_t peakBytes;
+
+  Handle Find(Kind const kind, char const * const pFile, int const parameter);
+  Asset & Use(size_t const index);
+  void Load(Asset & asset);
+  void Unload(Asset & asset);
+  static bool IsLoaded(Asset const & asset);
+};
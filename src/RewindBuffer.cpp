@@ -0,0 +1,567 @@
+#include "RewindBuffer.hpp"
+#include "Position.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Flags of a delta
+static uint8_t constexpr DELTA_MOVED = 0x01U;
+static uint8_t constexpr DELTA_APPLE = 0x02U;
+static uint8_t constexpr DELTA_SCORE = 0x04U;
+static uint8_t constexpr DELTA_RANDOM = 0x08U;
+static uint8_t constexpr DELTA_RUNNING = 0x10U;
+static uint8_t constexpr DELTA_ITEMS = 0x20U;
+
+// Items store their type in the low bits, spawns are marked
+static uint8_t constexpr ITEM_SPAWNED = 0x80U;
+
+// Flags of a snake in a delta, the low nibble holds both directions
+static uint8_t constexpr SNAKE_ALIVE = 0x10U;
+static uint8_t constexpr SNAKE_HEAD_ADDED = 0x20U;
+static uint8_t constexpr SNAKE_TAIL_REMOVED = 0x40U;
+static uint8_t constexpr SNAKE_CLEARED = 0x80U;
+
+template <typename T>
+static void Put(std::vector<uint8_t> & bytes, T const value)
+{
+  size_t const offset = bytes.size();
+  bytes.resize(offset + sizeof(T));
+  std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+
+template <typename T>
+static T Get(uint8_t const * & pBytes)
+{
+  T value;
+  std::memcpy(&value, pBytes, sizeof(T));
+  pBytes += sizeof(T);
+  return value;
+}
+
+
+static Position Move(Position const & position, Simulation::Direction const direction)
+{
+  switch (direction)
+  {
+    case Simulation::Direction::Up:
+      return { position.x, position.y - 1 };
+
+    case Simulation::Direction::Down:
+      return { position.x, position.y + 1 };
+
+    case Simulation::Direction::Left:
+      return { position.x - 1, position.y };
+
+    case Simulation::Direction::Right:
+    default:
+      return { position.x + 1, position.y };
+  }
+}
+
+
+static Simulation::Direction DirectionTo(Position const & from, Position const & to)
+{
+  return (to.y < from.y) ? Simulation::Direction::Up
+       : (to.y > from.y) ? Simulation::Direction::Down
+       : (to.x < from.x) ? Simulation::Direction::Left
+                         : Simulation::Direction::Right;
+}
+
+
+static uint8_t PackDirections(Simulation::Snake const & snake)
+{
+  return static_cast<uint8_t>(static_cast<uint8_t>(snake.snakeDirection) | (static_cast<uint8_t>(snake.pressedDirection) << 2));
+}
+
+
+static void UnpackDirections(uint8_t const packed, Simulation::Snake & snake)
+{
+  snake.snakeDirection = static_cast<Simulation::Direction>(packed & 0x03U);
+  snake.pressedDirection = static_cast<Simulation::Direction>((packed >> 2) & 0x03U);
+}
+
+
+RewindBuffer::RewindBuffer(Position const & boardSize, size_t const maxTicks)
+: boardSize(boardSize)
+, chunks((maxTicks + SNAPSHOT_PERIOD - 1UL) / SNAPSHOT_PERIOD + 1UL)
+, firstChunk(0UL)
+, numberOfChunks(0UL)
+, numberOfTicks(0UL)
+, lastSnakes()
+, lastApple{ 0, 0 }
+, lastScoreCount(0U)
+, lastNumberOfMoves(0UL)
+, lastRandomState(0UL)
+, lastRunning(false)
+, rebuilds(0UL)
+, maxRebuildTime_us(0UL)
+, maxBytes(0UL)
+{
+  // Chunks are recycled, so recording only allocates for unusually large ones
+  for (Chunk & chunk : chunks)
+  {
+    chunk.bytes.reserve(CHUNK_RESERVE);
+    chunk.offsets.reserve(SNAPSHOT_PERIOD);
+  }
+  lastSnakes.reserve(Simulation::MAX_PLAYERS);
+}
+
+
+RewindBuffer::~RewindBuffer(void)
+{
+  if (maxBytes > 0UL)
+  {
+    std::cout << "rewind: " << numberOfTicks << " ticks kept, max " << maxBytes << " bytes, "
+              << rebuilds << " rebuilds, max " << maxRebuildTime_us << " us\n";
+  }
+}
+
+
+void RewindBuffer::Clear(void)
+{
+  firstChunk = 0UL;
+  numberOfChunks = 0UL;
+  numberOfTicks = 0UL;
+}
+
+
+void RewindBuffer::Record(Simulation::State const & state)
+{
+  Chunk* pChunk = (numberOfChunks > 0UL) ? &chunks[(firstChunk + numberOfChunks - 1UL) % chunks.size()] : nullptr;
+  if ((pChunk != nullptr) && (pChunk->offsets.size() < SNAPSHOT_PERIOD))
+  {
+    // Restarts and restores can't be told as deltas, a new snapshot covers them
+    size_t const offset = pChunk->bytes.size();
+    if (WriteDelta(state, pChunk->bytes))
+    {
+      pChunk->offsets.push_back(static_cast<uint32_t>(offset));
+      ++numberOfTicks;
+      Remember(state);
+      maxBytes = std::max(maxBytes, GetBytes());
+      return;
+    }
+    pChunk->bytes.resize(offset);
+  }
+
+  Chunk & chunk = NewChunk();
+  chunk.offsets.push_back(0U);
+  WriteSnapshot(state, chunk.bytes);
+  ++numberOfTicks;
+  Remember(state);
+  maxBytes = std::max(maxBytes, GetBytes());
+}
+
+
+size_t RewindBuffer::GetNumberOfTicks(void) const
+{
+  return numberOfTicks;
+}
+
+
+void RewindBuffer::Rebuild(size_t const tick, Simulation::State & state)
+{
+  if (numberOfTicks == 0UL)
+  {
+    return;
+  }
+  std::chrono::steady_clock::time_point const begin = std::chrono::steady_clock::now();
+
+  size_t chunkIndex = 0UL;
+  size_t first = 0UL;
+  while ((chunkIndex + 1UL < numberOfChunks) && (first + chunks[(firstChunk + chunkIndex) % chunks.size()].offsets.size() <= tick))
+  {
+    first += chunks[(firstChunk + chunkIndex) % chunks.size()].offsets.size();
+    ++chunkIndex;
+  }
+
+  // Start at the snapshot and apply the deltas up to the tick
+  Chunk const & chunk = chunks[(firstChunk + chunkIndex) % chunks.size()];
+  size_t const last = std::min(tick - first, chunk.offsets.size() - 1UL);
+  ReadSnapshot(chunk.bytes.data(), state);
+  for (size_t delta = 1UL; delta <= last; ++delta)
+  {
+    ReadDelta(chunk.bytes.data() + chunk.offsets[delta], state);
+  }
+
+  ++rebuilds;
+  maxRebuildTime_us = std::max(maxRebuildTime_us, static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count()));
+}
+
+
+bool RewindBuffer::GetLastRecord(uint8_t const * & pBytes, size_t & size) const
+{
+  if (numberOfTicks == 0UL)
+  {
+    pBytes = nullptr;
+    size = 0UL;
+    return false;
+  }
+
+  Chunk const & chunk = chunks[(firstChunk + numberOfChunks - 1UL) % chunks.size()];
+  pBytes = chunk.bytes.data() + chunk.offsets.back();
+  size = chunk.bytes.size() - chunk.offsets.back();
+  return (chunk.offsets.size() == 1UL);
+}
+
+
+bool RewindBuffer::Append(uint8_t const * const pBytes, size_t const size, bool const snapshot)
+{
+  Chunk* pChunk = (numberOfChunks > 0UL) ? &chunks[(firstChunk + numberOfChunks - 1UL) % chunks.size()] : nullptr;
+  if (snapshot)
+  {
+    pChunk = &NewChunk();
+  }
+  else if ((pChunk == nullptr) || (pChunk->offsets.size() >= SNAPSHOT_PERIOD))
+  {
+    return false;
+  }
+
+  pChunk->offsets.push_back(static_cast<uint32_t>(pChunk->bytes.size()));
+  pChunk->bytes.insert(pChunk->bytes.end(), pBytes, pBytes + size);
+  ++numberOfTicks;
+  maxBytes = std::max(maxBytes, GetBytes());
+  return true;
+}
+
+
+RewindBuffer::Chunk & RewindBuffer::NewChunk(void)
+{
+  if (numberOfChunks == chunks.size())
+  {
+    // Full, so the oldest chunk is dropped as a whole
+    numberOfTicks -= chunks[firstChunk].offsets.size();
+    firstChunk = (firstChunk + 1UL) % chunks.size();
+    --numberOfChunks;
+  }
+
+  Chunk & chunk = chunks[(firstChunk + numberOfChunks) % chunks.size()];
+  ++numberOfChunks;
+  chunk.bytes.clear();
+  chunk.offsets.clear();
+  return chunk;
+}
+
+
+bool RewindBuffer::WriteDelta(Simulation::State const & state, std::vector<uint8_t> & bytes) const
+{
+  if ((state.snakes.size() != lastSnakes.size())
+      || ((state.numberOfMoves != lastNumberOfMoves) && (state.numberOfMoves != lastNumberOfMoves + 1UL))
+      || state.items.IsReset())
+  {
+    return false;
+  }
+
+  uint8_t flags = 0U;
+  flags |= (state.numberOfMoves != lastNumberOfMoves) ? DELTA_MOVED : 0U;
+  flags |= !(state.apple == lastApple) ? DELTA_APPLE : 0U;
+  flags |= (state.scoreCount != lastScoreCount) ? DELTA_SCORE : 0U;
+  flags |= (state.randomState != lastRandomState) ? DELTA_RANDOM : 0U;
+  flags |= (state.running != lastRunning) ? DELTA_RUNNING : 0U;
+  // Item changes belong to the move which made them
+  flags |= ((state.numberOfMoves != lastNumberOfMoves) && !state.items.GetChanges().empty()) ? DELTA_ITEMS : 0U;
+  Put(bytes, flags);
+  if ((flags & DELTA_APPLE) != 0U)
+  {
+    Put(bytes, static_cast<int32_t>(state.apple.x));
+    Put(bytes, static_cast<int32_t>(state.apple.y));
+  }
+  if ((flags & DELTA_SCORE) != 0U)
+  {
+    Put(bytes, state.scoreCount);
+  }
+  if ((flags & DELTA_RANDOM) != 0U)
+  {
+    Put(bytes, state.randomState);
+  }
+  if ((flags & DELTA_RUNNING) != 0U)
+  {
+    Put(bytes, static_cast<uint8_t>(state.running));
+  }
+  if ((flags & DELTA_ITEMS) != 0U)
+  {
+    std::vector<ItemLayer::Change> const & changes = state.items.GetChanges();
+    Put(bytes, static_cast<uint32_t>(changes.size()));
+    for (ItemLayer::Change const & change : changes)
+    {
+      Put(bytes, change.cell);
+      Put(bytes, static_cast<uint16_t>(change.expiry - state.numberOfMoves));
+      Put(bytes, static_cast<uint8_t>(static_cast<uint8_t>(change.type) | (change.spawned ? ITEM_SPAWNED : 0U)));
+    }
+  }
+
+  // One byte per snake, snakes which were already gone are left out
+  for (size_t i = 0UL; i < state.snakes.size(); ++i)
+  {
+    Simulation::Snake const & snake = state.snakes[i];
+    SnakeSummary const & last = lastSnakes[i];
+    bool const gone = !last.alive && (last.length == 0U);
+    if (gone)
+    {
+      if (snake.alive || (snake.length > 0U) || (snake.snakeDirection != last.snakeDirection)
+          || (snake.pressedDirection != last.pressedDirection))
+      {
+        return false;
+      }
+      continue;
+    }
+    if (snake.alive && !last.alive)
+    {
+      return false;
+    }
+
+    uint8_t snakeFlags = PackDirections(snake) | (snake.alive ? SNAKE_ALIVE : 0U);
+    if ((snake.length == 0U) && (last.length > 0U))
+    {
+      snakeFlags |= SNAKE_CLEARED;
+    }
+    else if (last.length > 0U)
+    {
+      bool const headAdded = !(snake.Head() == last.head);
+      if (headAdded && !(snake.Head() == Move(last.head, snake.snakeDirection)))
+      {
+        return false;
+      }
+      uint32_t const removed = last.length + (headAdded ? 1U : 0U) - snake.length;
+      if (removed > 1U)
+      {
+        return false;
+      }
+      snakeFlags |= (headAdded ? SNAKE_HEAD_ADDED : 0U) | ((removed == 1U) ? SNAKE_TAIL_REMOVED : 0U);
+    }
+    else if (snake.length > 0U)
+    {
+      return false;
+    }
+    Put(bytes, snakeFlags);
+  }
+  return true;
+}
+
+
+void RewindBuffer::WriteSnapshot(Simulation::State const & state, std::vector<uint8_t> & bytes) const
+{
+  Put(bytes, state.numberOfMoves);
+  Put(bytes, state.randomState);
+  Put(bytes, state.scoreCount);
+  Put(bytes, static_cast<int32_t>(state.apple.x));
+  Put(bytes, static_cast<int32_t>(state.apple.y));
+  Put(bytes, static_cast<uint8_t>(state.running));
+  Put(bytes, static_cast<uint8_t>(state.snakes.size()));
+
+  // Bodies as their head and two bits per step towards the tail
+  for (Simulation::Snake const & snake : state.snakes)
+  {
+    Put(bytes, static_cast<uint8_t>(PackDirections(snake) | (snake.alive ? SNAKE_ALIVE : 0U)));
+    Put(bytes, snake.length);
+    if (snake.length == 0U)
+    {
+      continue;
+    }
+
+    Position const head = snake.Head();
+    Put(bytes, static_cast<int32_t>(head.x));
+    Put(bytes, static_cast<int32_t>(head.y));
+    uint8_t packed = 0U;
+    for (uint32_t part = 1U; part < snake.length; ++part)
+    {
+      uint8_t const direction = static_cast<uint8_t>(DirectionTo(snake.Part(part - 1U), snake.Part(part)));
+      packed |= static_cast<uint8_t>(direction << (((part - 1U) % 4U) * 2U));
+      if (((part % 4U) == 0U) || (part + 1U == snake.length))
+      {
+        Put(bytes, packed);
+        packed = 0U;
+      }
+    }
+  }
+
+  // Items with their expiry relative to the move, they never live longer than the timing wheel turns
+  Put(bytes, static_cast<uint8_t>(state.items.IsEnabled()));
+  Put(bytes, static_cast<uint32_t>(state.items.GetNumberOfItems()));
+  for (size_t i = 0UL; i < state.items.GetNumberOfItems(); ++i)
+  {
+    ItemLayer::Item const & item = state.items.GetItem(i);
+    Put(bytes, item.cell);
+    Put(bytes, static_cast<uint16_t>(item.expiry - state.numberOfMoves));
+    Put(bytes, static_cast<uint8_t>(item.type));
+  }
+}
+
+
+void RewindBuffer::Remember(Simulation::State const & state)
+{
+  lastSnakes.resize(state.snakes.size());
+  for (size_t i = 0UL; i < state.snakes.size(); ++i)
+  {
+    Simulation::Snake const & snake = state.snakes[i];
+    lastSnakes[i] = { (snake.length > 0U) ? snake.Head() : Position{ -1, -1 }, snake.length,
+                      snake.snakeDirection, snake.pressedDirection, snake.alive };
+  }
+  lastApple = state.apple;
+  lastScoreCount = state.scoreCount;
+  lastNumberOfMoves = state.numberOfMoves;
+  lastRandomState = state.randomState;
+  lastRunning = state.running;
+}
+
+
+void RewindBuffer::ReadSnapshot(uint8_t const * pBytes, Simulation::State & state) const
+{
+  state.numberOfMoves = Get<uint64_t>(pBytes);
+  state.randomState = Get<uint64_t>(pBytes);
+  state.scoreCount = Get<uint16_t>(pBytes);
+  state.apple.x = Get<int32_t>(pBytes);
+  state.apple.y = Get<int32_t>(pBytes);
+  state.running = Get<uint8_t>(pBytes) != 0U;
+  state.snakes.resize(Get<uint8_t>(pBytes));
+
+  // The field holds nothing but the bodies
+  state.field.assign(static_cast<size_t>(boardSize.x) * boardSize.y, Simulation::FREE);
+  for (size_t i = 0UL; i < state.snakes.size(); ++i)
+  {
+    Simulation::Snake & snake = state.snakes[i];
+    uint8_t const snakeFlags = Get<uint8_t>(pBytes);
+    UnpackDirections(snakeFlags, snake);
+    snake.alive = (snakeFlags & SNAKE_ALIVE) != 0U;
+    snake.length = Get<uint32_t>(pBytes);
+    snake.head = 0U;
+    snake.growth = 0U;
+
+    // Rings stay a power of two with room for the whole body, like the simulation grows them
+    size_t ringSize = 16UL;
+    while (ringSize < snake.length)
+    {
+      ringSize *= 2UL;
+    }
+    snake.ring.resize(ringSize);
+    if (snake.length == 0U)
+    {
+      continue;
+    }
+
+    Position part = { Get<int32_t>(pBytes), 0 };
+    part.y = Get<int32_t>(pBytes);
+    uint8_t packed = 0U;
+    for (uint32_t index = 0U; index < snake.length; ++index)
+    {
+      if (index > 0U)
+      {
+        if (((index - 1U) % 4U) == 0U)
+        {
+          packed = Get<uint8_t>(pBytes);
+        }
+        part = Move(part, static_cast<Simulation::Direction>((packed >> (((index - 1U) % 4U) * 2U)) & 0x03U));
+      }
+      snake.ring[index] = part;
+      state.field[static_cast<size_t>(part.y) * boardSize.x + part.x] = static_cast<Simulation::Cell>(i + 1U);
+    }
+  }
+
+  bool const itemsEnabled = Get<uint8_t>(pBytes) != 0U;
+  state.items.Reset(itemsEnabled ? state.field.size() : 0UL);
+  uint32_t const numberOfItems = Get<uint32_t>(pBytes);
+  for (uint32_t i = 0U; i < numberOfItems; ++i)
+  {
+    int32_t const cell = Get<int32_t>(pBytes);
+    uint64_t const expiry = state.numberOfMoves + Get<uint16_t>(pBytes);
+    (void)state.items.Spawn(cell, static_cast<ItemLayer::Type>(Get<uint8_t>(pBytes)), expiry);
+  }
+}
+
+
+void RewindBuffer::ReadDelta(uint8_t const * pBytes, Simulation::State & state) const
+{
+  uint8_t const flags = Get<uint8_t>(pBytes);
+  state.numberOfMoves += ((flags & DELTA_MOVED) != 0U) ? 1UL : 0UL;
+  if ((flags & DELTA_APPLE) != 0U)
+  {
+    state.apple.x = Get<int32_t>(pBytes);
+    state.apple.y = Get<int32_t>(pBytes);
+  }
+  if ((flags & DELTA_SCORE) != 0U)
+  {
+    state.scoreCount = Get<uint16_t>(pBytes);
+  }
+  if ((flags & DELTA_RANDOM) != 0U)
+  {
+    state.randomState = Get<uint64_t>(pBytes);
+  }
+  if ((flags & DELTA_RUNNING) != 0U)
+  {
+    state.running = Get<uint8_t>(pBytes) != 0U;
+  }
+  if ((flags & DELTA_ITEMS) != 0U)
+  {
+    uint32_t const numberOfChanges = Get<uint32_t>(pBytes);
+    for (uint32_t i = 0U; i < numberOfChanges; ++i)
+    {
+      int32_t const cell = Get<int32_t>(pBytes);
+      uint64_t const expiry = state.numberOfMoves + Get<uint16_t>(pBytes);
+      uint8_t const type = Get<uint8_t>(pBytes);
+      ItemLayer::Type taken = ItemLayer::Type::Apple;
+      if ((type & ITEM_SPAWNED) != 0U)
+      {
+        (void)state.items.Spawn(cell, static_cast<ItemLayer::Type>(type & ~ITEM_SPAWNED), expiry);
+      }
+      else
+      {
+        (void)state.items.Take(cell, taken);
+      }
+    }
+  }
+
+  for (size_t i = 0UL; i < state.snakes.size(); ++i)
+  {
+    Simulation::Snake & snake = state.snakes[i];
+    if (!snake.alive && (snake.length == 0U))
+    {
+      continue;
+    }
+
+    uint8_t const snakeFlags = Get<uint8_t>(pBytes);
+    UnpackDirections(snakeFlags, snake);
+    snake.alive = (snakeFlags & SNAKE_ALIVE) != 0U;
+    Simulation::Cell const marker = static_cast<Simulation::Cell>(i + 1U);
+
+    if ((snakeFlags & SNAKE_HEAD_ADDED) != 0U)
+    {
+      if (snake.length == snake.ring.size())
+      {
+        // Unroll the full ring into one of double size
+        std::vector<Position> & ring = snake.ring;
+        std::rotate(ring.begin(), ring.begin() + snake.head, ring.end());
+        ring.resize(ring.size() * 2UL);
+        snake.head = 0U;
+      }
+      Position const head = Move(snake.Head(), snake.snakeDirection);
+      snake.head = (snake.head - 1U) & (snake.ring.size() - 1U);
+      snake.ring[snake.head] = head;
+      ++snake.length;
+      state.field[static_cast<size_t>(head.y) * boardSize.x + head.x] = marker;
+    }
+
+    uint32_t const removed = ((snakeFlags & SNAKE_CLEARED) != 0U) ? snake.length
+                           : ((snakeFlags & SNAKE_TAIL_REMOVED) != 0U) ? 1U
+                                                                       : 0U;
+    for (uint32_t part = 0U; part < removed; ++part)
+    {
+      Position const tail = snake.Tail();
+      state.field[static_cast<size_t>(tail.y) * boardSize.x + tail.x] = Simulation::FREE;
+      --snake.length;
+    }
+  }
+}
+
+
+size_t RewindBuffer::GetBytes(void) const
+{
+  size_t bytes = 0UL;
+  for (size_t chunk = 0UL; chunk < numberOfChunks; ++chunk)
+  {
+    Chunk const & current = chunks[(firstChunk + chunk) % chunks.size()];
+    bytes += current.bytes.size() + current.offsets.size() * sizeof(uint32_t);
+  }
+  return bytes;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Position.hpp"
+#include "Simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Recent game states as periodic snapshots of the snakes and small per tick deltas, the field is derived from the snakes
+class RewindBuffer
+{
+public:
+  RewindBuffer(Position const & boardSize, size_t const maxTicks);
+  ~RewindBuffer(void);
+
+  void Clear(void);
+  void Record(Simulation::State const & state);
+
+  // Ticks are numbered from the oldest kept one
+  size_t GetNumberOfTicks(void) const;
+  void Rebuild(size_t const tick, Simulation::State & state);
+
+  // The encoding of the newest tick, true if it is a snapshot and not a delta
+  bool GetLastRecord(uint8_t const * & pBytes, size_t & size) const;
+  // Adds a record taken from another buffer, deltas need a chunk to go to, false if there is none
+  bool Append(uint8_t const * pBytes, size_t const size, bool const snapshot);
+
+private:
+  static size_t constexpr SNAPSHOT_PERIOD = 64UL;
+  static size_t constexpr CHUNK_RESERVE = 4096UL;
+
+  // A snapshot followed by the deltas of the next ticks
+  struct Chunk
+  {
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> offsets;
+  };
+
+  // What deltas are taken against, the last recorded state without its field and bodies
+  struct SnakeSummary
+  {
+    Position head;
+    uint32_t length;
+    Simulation::Direction snakeDirection;
+    Simulation::Direction pressedDirection;
+    bool alive;
+  };
+
+  Position boardSize;
+  std::vector<Chunk> chunks;
+  size_t firstChunk;
+  size_t numberOfChunks;
+  size_t numberOfTicks;
+
+  std::vector<SnakeSummary> lastSnakes;
+  Position lastApple;
+  uint16_t lastScoreCount;
+  uint64_t lastNumberOfMoves;
+  uint64_t lastRandomState;
+  bool lastRunning;
+
+  // Statistics
+  uint64_t rebuilds;
+  uint64_t maxRebuildTime_us;
+  size_t maxBytes;
+
+  Chunk & NewChunk(void);
+  bool WriteDelta(Simulation::State const & state, std::vector<uint8_t> & bytes) const;
+  void WriteSnapshot(Simulation::State const & state, std::vector<uint8_t> & bytes) const;
+  void Remember(Simulation::State const & state);
+  void ReadSnapshot(uint8_t const * pBytes, Simulation::State & state) const;
+  void ReadDelta(uint8_t const * pBytes, Simulation::State & state) const;
+  size_t GetBytes(void) const;
+};
@@ -0,0 +1,252 @@
+#include "RollbackSession.hpp"
+#include "NetLink.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+RollbackSession::RollbackSession(Simulation & simulation, NetLink & link, size_t const localPlayer)
+: simulation(simulation)
+, link(link)
+, localPlayer(localPlayer)
+, remotePlayer((localPlayer == 0UL) ? 1UL : 0UL)
+, matchId(0U)
+, seed(0UL)
+, currentTick(0U)
+, remoteReceived(0U)
+, remoteAck(0U)
+, firstMismatch(std::numeric_limits<uint32_t>::max())
+, pendingLocal(Simulation::Direction::Up)
+, checksumSent(false)
+, remoteChecksumValid(false)
+, remoteChecksum(0UL)
+, stats{ 0UL, 0UL, 0UL, 0UL }
+, snapshots()
+, localInputs()
+, remoteInputs()
+{
+}
+
+
+void RollbackSession::Start(uint64_t const seed)
+{
+  Reset(matchId + 1U, seed);
+
+  // An empty input packet already tells the peer about the new match
+  SendInputs();
+}
+
+
+bool RollbackSession::Poll(void)
+{
+  uint32_t const previousMatchId = matchId;
+
+  Packet packet;
+  while (link.Receive(&packet, sizeof(packet)) == sizeof(packet))
+  {
+    HandlePacket(packet);
+  }
+
+  if (firstMismatch < currentTick)
+  {
+    Rollback();
+  }
+  firstMismatch = std::numeric_limits<uint32_t>::max();
+
+  if (!CanAdvance())
+  {
+    // Stalled by the peer, keep it supplied in case it missed our inputs
+    SendInputs();
+  }
+
+  return matchId != previousMatchId;
+}
+
+
+bool RollbackSession::Steer(Simulation::Direction const direction)
+{
+  Simulation::Direction const snakeDirection = simulation.GetState().snakes[localPlayer].snakeDirection;
+  bool const vertical = (direction == Simulation::Direction::Up) || (direction == Simulation::Direction::Down);
+  bool const movingVertical =    (snakeDirection == Simulation::Direction::Up)
+                              || (snakeDirection == Simulation::Direction::Down);
+  if (vertical == movingVertical)
+  {
+    return false;
+  }
+
+  pendingLocal = direction;
+  return true;
+}
+
+
+bool RollbackSession::CanAdvance(void) const
+{
+  // Never get further ahead than the snapshots allow to roll back
+  return currentTick < (remoteReceived + MAX_ROLLBACK - 1U);
+}
+
+
+Simulation::Events RollbackSession::Advance(void)
+{
+  localInputs[currentTick % INPUT_HISTORY] = pendingLocal;
+  Simulation::Events const events = Simulate(currentTick);
+  ++currentTick;
+
+  SendInputs();
+  if (IsConfirmedOver() && ((!checksumSent) || (!remoteChecksumValid)))
+  {
+    // Repeated until the peer's checksum arrives, the link may drop packets
+    SendChecksum();
+  }
+
+  return events;
+}
+
+
+bool RollbackSession::IsConfirmedOver(void) const
+{
+  Simulation::State const & state = simulation.GetState();
+  return (!state.running) && (state.numberOfMoves <= remoteReceived);
+}
+
+
+RollbackSession::Verdict RollbackSession::GetVerdict(void) const
+{
+  if ((!IsConfirmedOver()) || (!remoteChecksumValid))
+  {
+    return Verdict::Pending;
+  }
+
+  return (remoteChecksum == simulation.Checksum()) ? Verdict::Identical : Verdict::Desync;
+}
+
+
+RollbackSession::Stats const & RollbackSession::GetStats(void) const
+{
+  return stats;
+}
+
+
+void RollbackSession::Reset(uint32_t const newMatchId, uint64_t const newSeed)
+{
+  matchId = newMatchId;
+  seed = newSeed;
+  simulation.Restart(2U, seed);
+  currentTick = 0U;
+  remoteReceived = 0U;
+  remoteAck = 0U;
+  firstMismatch = std::numeric_limits<uint32_t>::max();
+  pendingLocal = simulation.GetState().snakes[localPlayer].pressedDirection;
+  checksumSent = false;
+  remoteChecksumValid = false;
+  remoteChecksum = 0UL;
+}
+
+
+Simulation::Events RollbackSession::Simulate(uint32_t const tick)
+{
+  simulation.Save(snapshots[tick % MAX_ROLLBACK]);
+
+  if (tick >= remoteReceived)
+  {
+    // Predict the remote snake keeps its last confirmed direction
+    remoteInputs[tick % INPUT_HISTORY] = (remoteReceived > 0U) ? remoteInputs[(remoteReceived - 1U) % INPUT_HISTORY]
+                                                               : Simulation::Direction::Up;
+  }
+
+  simulation.SetPressedDirection(localPlayer, localInputs[tick % INPUT_HISTORY]);
+  simulation.SetPressedDirection(remotePlayer, remoteInputs[tick % INPUT_HISTORY]);
+  return simulation.Step();
+}
+
+
+void RollbackSession::Rollback(void)
+{
+  std::chrono::steady_clock::time_point const begin = std::chrono::steady_clock::now();
+
+  simulation.Restore(snapshots[firstMismatch % MAX_ROLLBACK]);
+  for (uint32_t tick = firstMismatch; tick < currentTick; ++tick)
+  {
+    (void)Simulate(tick);
+  }
+
+  uint64_t const duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - begin).count();
+  ++stats.rollbacks;
+  stats.resimulatedTicks += currentTick - firstMismatch;
+  stats.rollbackTime_us += duration_us;
+  stats.maxRollbackTime_us = std::max(stats.maxRollbackTime_us, duration_us);
+}
+
+
+void RollbackSession::SendInputs(void)
+{
+  Packet packet = {};
+  packet.type = PacketType::Input;
+  packet.matchId = matchId;
+  packet.firstTick = std::max(remoteAck, (currentTick > INPUTS_PER_PACKET) ? currentTick - INPUTS_PER_PACKET : 0U);
+  packet.count = static_cast<uint8_t>(currentTick - packet.firstTick);
+  packet.ack = remoteReceived;
+  packet.value = seed;
+  for (uint32_t i = 0U; i < packet.count; ++i)
+  {
+    packet.inputs[i] = localInputs[(packet.firstTick + i) % INPUT_HISTORY];
+  }
+  link.Send(&packet, sizeof(packet));
+}
+
+
+void RollbackSession::SendChecksum(void)
+{
+  Packet packet = {};
+  packet.type = PacketType::Checksum;
+  packet.matchId = matchId;
+  packet.ack = remoteReceived;
+  packet.value = simulation.Checksum();
+  link.Send(&packet, sizeof(packet));
+  checksumSent = true;
+}
+
+
+void RollbackSession::HandlePacket(Packet const & packet)
+{
+  if (packet.matchId < matchId)
+  {
+    // Left over from a previous match
+    return;
+  }
+
+  if (packet.matchId > matchId)
+  {
+    // The host started a new match
+    Reset(packet.matchId, packet.value);
+  }
+
+  remoteAck = std::max(remoteAck, std::min(packet.ack, currentTick));
+
+  if (packet.type == PacketType::Checksum)
+  {
+    remoteChecksum = packet.value;
+    remoteChecksumValid = true;
+    return;
+  }
+
+  for (uint32_t i = 0U; i < packet.count; ++i)
+  {
+    uint32_t const tick = packet.firstTick + i;
+    if (tick != remoteReceived)
+    {
+      // Already known, inputs are sent redundantly until acknowledged
+      continue;
+    }
+
+    Simulation::Direction const input = packet.inputs[i];
+    if ((tick < currentTick) && (remoteInputs[tick % INPUT_HISTORY] != input))
+    {
+      // Misprediction, so the ticks from here on have to be simulated again
+      firstMismatch = std::min(firstMismatch, tick);
+    }
+    remoteInputs[tick % INPUT_HISTORY] = input;
+    ++remoteReceived;
+  }
+}
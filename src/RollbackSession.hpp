@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+class NetLink;
+
+class RollbackSession
+{
+public:
+  enum class Verdict
+  {
+    Pending,
+    Identical,
+    Desync
+  };
+
+  struct Stats
+  {
+    uint64_t rollbacks;
+    uint64_t resimulatedTicks;
+    uint64_t rollbackTime_us;
+    uint64_t maxRollbackTime_us;
+  };
+
+  RollbackSession(Simulation & simulation, NetLink & link, size_t const localPlayer);
+  ~RollbackSession(void) = default;
+
+  void Start(uint64_t const seed);
+  bool Poll(void);
+  bool Steer(Simulation::Direction const direction);
+  bool CanAdvance(void) const;
+  Simulation::Events Advance(void);
+  bool IsConfirmedOver(void) const;
+  Verdict GetVerdict(void) const;
+  Stats const & GetStats(void) const;
+
+private:
+  // Ticks a peer may run ahead, so ticks which can be rolled back
+  static uint32_t constexpr MAX_ROLLBACK = 32U;
+  static uint32_t constexpr INPUT_HISTORY = 128U;
+  static uint32_t constexpr INPUTS_PER_PACKET = 64U;
+
+  enum class PacketType : uint8_t
+  {
+    Input,
+    Checksum
+  };
+
+  struct Packet
+  {
+    PacketType type;
+    uint8_t count;
+    uint32_t matchId;
+    uint32_t firstTick;
+    uint32_t ack;
+    uint64_t value;
+    std::array<Simulation::Direction, INPUTS_PER_PACKET> inputs;
+  };
+
+  Simulation & simulation;
+  NetLink & link;
+  size_t localPlayer;
+  size_t remotePlayer;
+  uint32_t matchId;
+  uint64_t seed;
+  uint32_t currentTick;
+  uint32_t remoteReceived;
+  uint32_t remoteAck;
+  uint32_t firstMismatch;
+  Simulation::Direction pendingLocal;
+  bool checksumSent;
+  bool remoteChecksumValid;
+  uint64_t remoteChecksum;
+  Stats stats;
+  std::array<Simulation::State, MAX_ROLLBACK> snapshots;
+  std::array<Simulation::Direction, INPUT_HISTORY> localInputs;
+  std::array<Simulation::Direction, INPUT_HISTORY> remoteInputs;
+
+  void Reset(uint32_t const newMatchId, uint64_t const newSeed);
+  Simulation::Events Simulate(uint32_t const tick);
+  void Rollback(void);
+  void SendInputs(void);
+  void SendChecksum(void);
+  void HandlePacket(Packet const & packet);
+};
@@ -0,0 +1,239 @@
+#include "SdlRenderBackend.hpp"
+#include "FrameArena.hpp"
+#include "Position.hpp"
+#include <SDL_render.h>
+#include <SDL_surface.h>
+#include <SDL_video.h>
+#include <stdexcept>
+
+SdlRenderBackend::SdlRenderBackend(SDL_Window* const pWindow, Position const & res, FrameArena & frameArena,
+                                   bool const software)
+: pRenderer(SDL_CreateRenderer(pWindow, -1, software ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED))
+, resolution(res)
+, frameArena(frameArena)
+, freeTextures()
+, capture(false)
+, captureTargets{ nullptr, nullptr }
+, captureUnread{ false, false }
+, captureIndex(0UL)
+{
+  if (pRenderer == nullptr)
+    throw std::runtime_error("SdlRenderBackend::SdlRenderBackend: Renderer could not be created.");
+}
+
+
+SdlRenderBackend::~SdlRenderBackend(void)
+{
+  for (SDL_Texture* const pTarget : captureTargets)
+  {
+    SDL_DestroyTexture(pTarget);
+  }
+
+  for (SdlTexture* const pTexture : freeTextures)
+  {
+    delete pTexture;
+  }
+
+  SDL_DestroyRenderer(pRenderer);
+}
+
+
+Texture* SdlRenderBackend::CreateTexture(SDL_Surface* const pSurface)
+{
+  SDL_Texture* const pSdlTexture = SDL_CreateTextureFromSurface(pRenderer, pSurface);
+  if (pSdlTexture == nullptr)
+  {
+    return nullptr;
+  }
+
+  SdlTexture* const pTexture = freeTextures.empty() ? new SdlTexture : freeTextures.back();
+  if (!freeTextures.empty())
+  {
+    freeTextures.pop_back();
+  }
+  pTexture->pTexture = pSdlTexture;
+  SDL_QueryTexture(pSdlTexture, nullptr, nullptr, &pTexture->size.x, &pTexture->size.y);
+  return pTexture;
+}
+
+
+void SdlRenderBackend::DestroyTexture(Texture* const pTexture)
+{
+  if (pTexture != nullptr)
+  {
+    SDL_DestroyTexture(static_cast<SdlTexture*>(pTexture)->pTexture);
+    freeTextures.push_back(static_cast<SdlTexture*>(pTexture));
+  }
+}
+
+
+void SdlRenderBackend::UpdateTexture(Texture* const pTexture, uint32_t const * const pPixels)
+{
+  if (pTexture == nullptr)
+  {
+    return;
+  }
+
+  // Textures from surfaces get a format the renderer supports, which is not ABGR8888 on every renderer
+  SDL_Texture* const pSdlTexture = static_cast<SdlTexture*>(pTexture)->pTexture;
+  Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+  SDL_QueryTexture(pSdlTexture, &format, nullptr, nullptr, nullptr);
+  int const pitch = pTexture->size.x * 4;
+  if (format == SDL_PIXELFORMAT_ABGR8888)
+  {
+    SDL_UpdateTexture(pSdlTexture, nullptr, pPixels, pitch);
+    return;
+  }
+
+  uint32_t* const pConverted = frameArena.Allocate<uint32_t>(static_cast<size_t>(pTexture->size.x) * pTexture->size.y);
+  if (SDL_ConvertPixels(pTexture->size.x, pTexture->size.y, SDL_PIXELFORMAT_ABGR8888, pPixels, pitch,
+                        format, pConverted, pitch) == 0)
+  {
+    SDL_UpdateTexture(pSdlTexture, nullptr, pConverted, pitch);
+  }
+}
+
+
+void SdlRenderBackend::Clean(SDL_Color const & color)
+{
+  // Initialize renderer color blue for the background
+  SDL_SetRenderDrawColor(pRenderer, color.r, color.g, color.b, 255U);
+  // Clear screen
+  SDL_RenderClear(pRenderer);
+}
+
+
+void SdlRenderBackend::Copy(Texture* const pTexture, Position const & position, Position const & scale,
+                            double const angle)
+{
+  if (pTexture == nullptr)
+  {
+    return;
+  }
+
+  SDL_Rect src = {
+    .x = 0,
+    .y = 0,
+    .w = pTexture->size.x,
+    .h = pTexture->size.y
+  };
+
+  SDL_Rect dst = {
+    .x = position.x,
+    .y = position.y,
+    .w = scale.x,
+    .h = scale.y
+  };
+
+  SDL_RenderCopyEx(pRenderer, static_cast<SdlTexture*>(pTexture)->pTexture, &src, &dst, angle, nullptr, SDL_FLIP_NONE);
+}
+
+
+void SdlRenderBackend::FillRect(Position const & position, Position const & scale, SDL_Color const & color)
+{
+  SDL_SetRenderDrawColor(pRenderer, color.r, color.g, color.b, 255U);
+  SDL_Rect const rectangle = {
+    .x = position.x,
+    .y = position.y,
+    .w = scale.x,
+    .h = scale.y
+  };
+  SDL_RenderFillRect(pRenderer, &rectangle);
+}
+
+
+void SdlRenderBackend::FillTriangles(Position const * const pPositions, size_t const count, SDL_Color const & color)
+{
+  SDL_Vertex* const pVerts = frameArena.Allocate<SDL_Vertex>(count);
+  for (size_t i = 0UL; i < count; ++i)
+  {
+    pVerts[i] = SDL_Vertex{ SDL_FPoint{ static_cast<float>(pPositions[i].x), static_cast<float>(pPositions[i].y) },
+                            color,
+                            SDL_FPoint{ 0 } };
+  }
+
+  SDL_RenderGeometry( pRenderer, nullptr, pVerts, count, nullptr, 0 );
+}
+
+
+void SdlRenderBackend::FillColoredTriangles(Position const * const pPositions, SDL_Color const * const pColors, size_t const count)
+{
+  SDL_Vertex* const pVerts = frameArena.Allocate<SDL_Vertex>(count);
+  for (size_t i = 0UL; i < count; ++i)
+  {
+    pVerts[i] = SDL_Vertex{ SDL_FPoint{ static_cast<float>(pPositions[i].x), static_cast<float>(pPositions[i].y) },
+                            pColors[i / 3UL],
+                            SDL_FPoint{ 0 } };
+  }
+
+  SDL_RenderGeometry( pRenderer, nullptr, pVerts, count, nullptr, 0 );
+}
+
+
+void SdlRenderBackend::Present(void)
+{
+  if (capture)
+  {
+    SDL_SetRenderTarget(pRenderer, nullptr);
+    SDL_RenderCopy(pRenderer, captureTargets[captureIndex], nullptr, nullptr);
+    captureUnread[captureIndex] = true;
+    captureIndex ^= 1UL;
+  }
+
+  SDL_RenderPresent(pRenderer);
+
+  // The next frame is drawn into the other target from its first call on, frames need not start with Clean
+  if (capture)
+  {
+    SDL_SetRenderTarget(pRenderer, captureTargets[captureIndex]);
+  }
+}
+
+
+void SdlRenderBackend::Resize(Position const & res)
+{
+  resolution = res;
+  if (capture)
+  {
+    CreateCaptureTargets();
+  }
+}
+
+
+void SdlRenderBackend::EnableCapture(void)
+{
+  capture = true;
+  CreateCaptureTargets();
+}
+
+
+bool SdlRenderBackend::HasCapturedFrame(bool const finish) const
+{
+  // The target drawn next holds the previous frame, the GPU has finished it by now
+  return captureUnread[captureIndex] || (finish && captureUnread[captureIndex ^ 1UL]);
+}
+
+
+void SdlRenderBackend::ReadCapturedFrame(uint8_t* const pPixels)
+{
+  size_t const index = captureUnread[captureIndex] ? captureIndex : (captureIndex ^ 1UL);
+  SDL_SetRenderTarget(pRenderer, captureTargets[index]);
+  SDL_RenderReadPixels(pRenderer, nullptr, SDL_PIXELFORMAT_RGBA32, pPixels, resolution.x * 4);
+  SDL_SetRenderTarget(pRenderer, captureTargets[captureIndex]);
+  captureUnread[index] = false;
+}
+
+
+void SdlRenderBackend::CreateCaptureTargets(void)
+{
+  for (SDL_Texture* & pTarget : captureTargets)
+  {
+    SDL_DestroyTexture(pTarget);
+    pTarget = SDL_CreateTexture(pRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, resolution.x, resolution.y);
+    if (pTarget == nullptr)
+      throw std::runtime_error("SdlRenderBackend::CreateCaptureTargets: Render target could not be created.");
+  }
+  captureUnread = { false, false };
+  captureIndex = 0UL;
+  SDL_SetRenderTarget(pRenderer, captureTargets[captureIndex]);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Position.hpp"
+#include "RenderBackend.hpp"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+typedef struct SDL_Window SDL_Window;
+typedef struct SDL_Renderer SDL_Renderer;
+typedef struct SDL_Texture SDL_Texture;
+
+class FrameArena;
+
+class SdlRenderBackend : public RenderBackend
+{
+public:
+  // SDL's own software renderer only for comparisons, the game takes an accelerated one
+  SdlRenderBackend(SDL_Window* const pWindow, Position const & res, FrameArena & frameArena, bool const software = false);
+  ~SdlRenderBackend(void) override;
+
+  Texture* CreateTexture(SDL_Surface* const pSurface) override;
+  void DestroyTexture(Texture* const pTexture) override;
+  void UpdateTexture(Texture* const pTexture, uint32_t const * const pPixels) override;
+  void Clean(SDL_Color const & color) override;
+  void Copy(Texture* const pTexture, Position const & position, Position const & scale, double const angle) override;
+  void FillRect(Position const & position, Position const & scale, SDL_Color const & color) override;
+  void FillTriangles(Position const * const pPositions, size_t const count, SDL_Color const & color) override;
+  void FillColoredTriangles(Position const * const pPositions, SDL_Color const * const pColors, size_t const count) override;
+  void Present(void) override;
+  void Resize(Position const & res) override;
+
+  void EnableCapture(void) override;
+  bool HasCapturedFrame(bool const finish) const override;
+  void ReadCapturedFrame(uint8_t* const pPixels) override;
+
+private:
+  struct SdlTexture : Texture
+  {
+    SDL_Texture* pTexture;
+  };
+
+  SDL_Renderer* pRenderer;
+  Position resolution;
+  FrameArena & frameArena;
+
+  // Handles of destroyed textures are reused, text textures come and go with every score
+  std::vector<SdlTexture*> freeTextures;
+
+  // Frames are rendered into two targets by turns, the previous one is read back while the next is drawn
+  bool capture;
+  std::array<SDL_Texture*, 2> captureTargets;
+  std::array<bool, 2> captureUnread;
+  size_t captureIndex;
+
+  void CreateCaptureTargets(void);
+};
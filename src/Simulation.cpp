@@ -0,0 +1,491 @@
+#include "Simulation.hpp"
+#include "Position.hpp"
+#include <algorithm>
+#include <cmath>
+
+Position Simulation::Snake::Head(void) const
+{
+  return ring[head];
+}
+
+
+Position Simulation::Snake::Tail(void) const
+{
+  return Part(length - 1U);
+}
+
+
+Position Simulation::Snake::Part(uint32_t const index) const
+{
+  return ring[(head + index) & (ring.size() - 1U)];
+}
+
+
+Simulation::Simulation(Position const & size)
+: size(size)
+, state{ std::vector<Cell>(size.x * size.y, FREE), {}, { 0, 0 }, 0U, 0UL, 1UL, false, ItemLayer() }
+, snakeHeadpositions()
+, headClaims(size.x * size.y, 0U)
+, analysis()
+, changedCells()
+, fieldChanged(true)
+{
+  changedCells.reserve(MAX_CHANGED_CELLS);
+}
+
+
+void Simulation::Restart(size_t const numberOfPlayers, uint64_t const seed)
+{
+  std::fill(state.field.begin(), state.field.end(), FREE);
+  changedCells.clear();
+  fieldChanged = true;
+  state.snakes.resize(numberOfPlayers);
+  snakeHeadpositions.assign(numberOfPlayers, Position{ -1, -1 });
+  for (Snake & snake : state.snakes)
+  {
+    if (snake.ring.empty())
+    {
+      snake.ring.resize(16U);
+    }
+    snake.head = 0U;
+    snake.length = 0U;
+    snake.snakeDirection = Direction::Up;
+    snake.pressedDirection = Direction::Up;
+    snake.alive = true;
+    snake.growth = 0U;
+  }
+  state.scoreCount = 0U;
+  state.numberOfMoves = 0UL;
+  state.randomState = (seed != 0UL) ? seed : 1UL;
+  state.running = true;
+  state.items.Reset((numberOfPlayers > 2U) ? state.field.size() : 0UL);
+
+  if (numberOfPlayers == 1U)
+  {
+    // Start with 3 parts sized snake
+    AddSnakeHead(state.snakes[0], 1U, { size.x / 2, size.y - 1 });
+    AddSnakeHead(state.snakes[0], 1U, { size.x / 2, size.y - 2 });
+    AddSnakeHead(state.snakes[0], 1U, { size.x / 2, size.y - 3 });
+
+    RandomApplePosition();
+  }
+  else if (numberOfPlayers == 2U)
+  {
+    // Player 1
+    AddSnakeHead(state.snakes[0], 1U, { size.x / 2 + 2, size.y - 1 });
+    AddSnakeHead(state.snakes[0], 1U, { size.x / 2 + 2, size.y - 2 });
+    AddSnakeHead(state.snakes[0], 1U, { size.x / 2 + 2, size.y - 3 });
+
+    // Payer 2
+    AddSnakeHead(state.snakes[1], 2U, { size.x / 2 - 2, size.y - 1 });
+    AddSnakeHead(state.snakes[1], 2U, { size.x / 2 - 2, size.y - 2 });
+    AddSnakeHead(state.snakes[1], 2U, { size.x / 2 - 2, size.y - 3 });
+  }
+  else
+  {
+    // Arena, spread the snakes over a grid of spawn cells
+    int const columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numberOfPlayers))));
+    int const rows = (static_cast<int>(numberOfPlayers) + columns - 1) / columns;
+    for (size_t i = 0UL; i < numberOfPlayers; ++i)
+    {
+      Position const spawn = { ((static_cast<int>(i) % columns) * 2 + 1) * size.x / (columns * 2),
+                               ((static_cast<int>(i) / columns) * 2 + 1) * size.y / (rows * 2) + 1 };
+      AddSnakeHead(state.snakes[i], static_cast<Cell>(i + 1U), { spawn.x, spawn.y + 1 });
+      AddSnakeHead(state.snakes[i], static_cast<Cell>(i + 1U), { spawn.x, spawn.y });
+      AddSnakeHead(state.snakes[i], static_cast<Cell>(i + 1U), { spawn.x, spawn.y - 1 });
+    }
+  }
+}
+
+
+Simulation::Events Simulation::Step(void)
+{
+  Events events = { false, false, false };
+  if (!state.running)
+  {
+    return events;
+  }
+
+  ++state.numberOfMoves;
+  state.items.ClearChanges();
+
+  // Update and validate new snake's head positions against the board before this move
+  std::vector<Snake> & snakes = state.snakes;
+  for (size_t i = 0UL; i < snakes.size(); ++i)
+  {
+    if (!snakes[i].alive)
+    {
+      continue;
+    }
+
+    Position & snakeHeadpos = snakeHeadpositions[i];
+    snakeHeadpos = snakes[i].Head();
+
+    snakes[i].snakeDirection = snakes[i].pressedDirection;
+
+    switch (snakes[i].snakeDirection)
+    {
+      case Direction::Up:
+        snakeHeadpos.y -= 1;
+        break;
+
+      case Direction::Down:
+        snakeHeadpos.y += 1;
+        break;
+
+      case Direction::Left:
+        snakeHeadpos.x -= 1;
+        break;
+
+      case Direction::Right:
+        snakeHeadpos.x += 1;
+        break;
+    }
+
+    if (!IsFree(snakeHeadpos))
+    {
+      snakes[i].alive = false;
+      events.death = true;
+    }
+    else
+    {
+      // Count the heads entering each cell, independent of the player order
+      ++headClaims[snakeHeadpos.y * size.x + snakeHeadpos.x];
+    }
+  }
+
+  // Heads entering the same cell kill each other
+  size_t numberOfAlive = 0UL;
+  for (size_t i = 0UL; i < snakes.size(); ++i)
+  {
+    if (snakes[i].alive)
+    {
+      Position const & snakeHeadpos = snakeHeadpositions[i];
+      if (headClaims[snakeHeadpos.y * size.x + snakeHeadpos.x] > 1U)
+      {
+        snakes[i].alive = false;
+        events.death = true;
+      }
+      else
+      {
+        ++numberOfAlive;
+      }
+    }
+  }
+
+  for (size_t i = 0UL; i < snakes.size(); ++i)
+  {
+    Position const & snakeHeadpos = snakeHeadpositions[i];
+    if (IsInside(snakeHeadpos))
+    {
+      headClaims[snakeHeadpos.y * size.x + snakeHeadpos.x] = 0U;
+    }
+  }
+
+  if (numberOfAlive <= ((snakes.size() > 1UL) ? 1UL : 0UL))
+  {
+    // Last snake standing, the board keeps the final positions
+    state.running = false;
+    events.over = true;
+    return events;
+  }
+
+  // Valid new positions, so move the heads and handle snake's tail
+  for (size_t i = 0UL; i < snakes.size(); ++i)
+  {
+    if (!snakes[i].alive)
+    {
+      continue;
+    }
+
+    AddSnakeHead(snakes[i], static_cast<Cell>(i + 1U), snakeHeadpositions[i]);
+
+    ItemLayer::Type itemType = ItemLayer::Type::Apple;
+    if (state.items.Take(snakeHeadpositions[i].y * size.x + snakeHeadpositions[i].x, itemType))
+    {
+      ApplyItem(i, itemType, events);
+    }
+
+    if (HasApple() && (snakeHeadpositions[i] == state.apple))
+    {
+      // Eat apple
+      events.bite = true;
+      RandomApplePosition();
+      ++state.scoreCount;
+    }
+    else if (snakes[i].growth > 0U)
+    {
+      --snakes[i].growth;
+    }
+    else if (HasApple() || ((state.numberOfMoves % 3UL) != 0UL))
+    {
+      RemoveSnakeTail(snakes[i]);
+    }
+  }
+
+  if (state.items.IsEnabled())
+  {
+    state.items.Expire(state.numberOfMoves);
+    SpawnItems();
+  }
+
+  if (events.death)
+  {
+    // Dead snakes leave the arena to the survivors
+    for (Snake & snake : snakes)
+    {
+      while ((!snake.alive) && (snake.length > 0U))
+      {
+        RemoveSnakeTail(snake);
+      }
+    }
+  }
+
+  return events;
+}
+
+
+bool Simulation::Steer(size_t const player, Direction const direction)
+{
+  Snake & snake = state.snakes[player];
+  bool const vertical = (direction == Direction::Up) || (direction == Direction::Down);
+  bool const movingVertical = (snake.snakeDirection == Direction::Up) || (snake.snakeDirection == Direction::Down);
+  if (vertical == movingVertical)
+  {
+    // Only turns are allowed, no reversing or pressing the current direction
+    return false;
+  }
+
+  snake.pressedDirection = direction;
+  return true;
+}
+
+
+void Simulation::SetPressedDirection(size_t const player, Direction const direction)
+{
+  state.snakes[player].pressedDirection = direction;
+}
+
+
+void Simulation::Save(State & snapshot) const
+{
+  snapshot = state;
+}
+
+
+void Simulation::Restore(State const & snapshot)
+{
+  state = snapshot;
+  changedCells.clear();
+  fieldChanged = true;
+}
+
+
+uint64_t Simulation::Checksum(void) const
+{
+  // FNV-1a over the board and the score
+  uint64_t hash = 14695981039346656037UL;
+  for (Cell const cell : state.field)
+  {
+    hash = (hash ^ cell) * 1099511628211UL;
+  }
+  hash = (hash ^ state.scoreCount) * 1099511628211UL;
+  return hash;
+}
+
+
+Position Simulation::GetSize(void) const
+{
+  return size;
+}
+
+
+Simulation::State const & Simulation::GetState(void) const
+{
+  return state;
+}
+
+
+Simulation::Cell Simulation::GetCell(Position const & fieldpos) const
+{
+  return state.field[fieldpos.y * size.x + fieldpos.x];
+}
+
+
+bool Simulation::HasApple(void) const
+{
+  return state.snakes.size() == 1U;
+}
+
+
+std::vector<Position> const & Simulation::GetChangedCells(void) const
+{
+  return changedCells;
+}
+
+
+bool Simulation::IsFieldChanged(void) const
+{
+  return fieldChanged;
+}
+
+
+void Simulation::ClearChangedCells(void)
+{
+  changedCells.clear();
+  fieldChanged = false;
+}
+
+
+void Simulation::AddSnakeHead(Snake & snake, Cell const marker, Position const fieldpos)
+{
+  if (snake.length == snake.ring.size())
+  {
+    // Ring is full, so unroll it into a ring of double size
+    std::vector<Position> ring(snake.ring.size() * 2U);
+    for (uint32_t i = 0U; i < snake.length; ++i)
+    {
+      ring[i] = snake.Part(i);
+    }
+    snake.ring.swap(ring);
+    snake.head = 0U;
+  }
+
+  snake.head = (snake.head - 1U) & (snake.ring.size() - 1U);
+  snake.ring[snake.head] = fieldpos;
+  ++snake.length;
+  state.field[fieldpos.y * size.x + fieldpos.x] = marker;
+  MarkChanged(fieldpos);
+}
+
+
+void Simulation::RemoveSnakeTail(Snake & snake)
+{
+  Position const tail = snake.Tail();
+  state.field[tail.y * size.x + tail.x] = FREE;
+  --snake.length;
+  MarkChanged(tail);
+}
+
+
+void Simulation::MarkChanged(Position const & fieldpos)
+{
+  // Nobody cleared the changes for long, so the list stops growing
+  if (fieldChanged)
+  {
+    return;
+  }
+  if (changedCells.size() >= MAX_CHANGED_CELLS)
+  {
+    changedCells.clear();
+    fieldChanged = true;
+    return;
+  }
+  changedCells.push_back(fieldpos);
+}
+
+
+void Simulation::RandomApplePosition(void)
+{
+  // Pockets the snake can't reach get no apple, unless there is no other free cell
+  analysis.Analyze(state.field, size);
+  Position const head = state.snakes[0].Head();
+  bool const reachableOnly = analysis.GetReachableCells(head) > 0U;
+
+  int xRandom = Random() % size.x;
+  int yRandom = Random() % size.y;
+  Position const randomPosition = {xRandom, yRandom};
+  while ((GetCell({ xRandom, yRandom }) != FREE) || (reachableOnly && !analysis.IsReachable(head, { xRandom, yRandom })))
+  {
+    // Avoid apple position inside snake, so find next free position
+    xRandom = (xRandom < size.x - 1) ? xRandom + 1
+                                     : 0;
+    yRandom = (xRandom != 0)         ? yRandom
+            : (yRandom < size.y - 1) ? yRandom + 1
+                                     : 0;
+
+    if (randomPosition == Position{xRandom, yRandom})
+    {
+      // No free position found, snake everywhere
+      break;
+    }
+  }
+
+  state.apple = { xRandom, yRandom };
+}
+
+
+void Simulation::ApplyItem(size_t const player, ItemLayer::Type const type, Events & events)
+{
+  Snake & snake = state.snakes[player];
+  switch (type)
+  {
+    case ItemLayer::Type::Apple:
+      snake.growth += 1U;
+      break;
+
+    case ItemLayer::Type::GoldenApple:
+      snake.growth += 3U;
+      break;
+
+    case ItemLayer::Type::Scissors:
+      // Cut off the tail, a snake keeps its head and two parts
+      for (uint32_t part = 0U; (part < SCISSORS_CUT) && (snake.length > 3U); ++part)
+      {
+        RemoveSnakeTail(snake);
+      }
+      break;
+  }
+
+  // The score counts the apples of player 1
+  if ((player == 0UL) && (type != ItemLayer::Type::Scissors))
+  {
+    events.bite = true;
+    ++state.scoreCount;
+  }
+}
+
+
+void Simulation::SpawnItems(void)
+{
+  // A few random cells per tick, taken ones are skipped, so the cost doesn't depend on the number of items
+  for (size_t type = 0UL; type < ItemLayer::NUMBER_OF_TYPES; ++type)
+  {
+    ItemLayer::Type const itemType = static_cast<ItemLayer::Type>(type);
+    uint32_t const spawns = state.items.TakeSpawns(itemType);
+    for (uint32_t spawn = 0U; spawn < spawns; ++spawn)
+    {
+      int32_t const cell = static_cast<int32_t>(Random() % state.field.size());
+      if (state.field[cell] == FREE)
+      {
+        (void)state.items.Spawn(cell, itemType, state.numberOfMoves + ItemLayer::GetLifetime(itemType));
+      }
+    }
+  }
+}
+
+
+uint32_t Simulation::Random(void)
+{
+  // xorshift64*, part of the state to keep replays deterministic
+  uint64_t & x = state.randomState;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  return static_cast<uint32_t>((x * 2685821657736338717UL) >> 32);
+}
+
+
+bool Simulation::IsInside(Position const & fieldpos) const
+{
+  return    (fieldpos.x < size.x)
+         && (fieldpos.x >= 0)
+         && (fieldpos.y < size.y)
+         && (fieldpos.y >= 0);
+}
+
+
+bool Simulation::IsFree(Position const & fieldpos) const
+{
+  return IsInside(fieldpos) && (GetCell(fieldpos) == FREE);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "BoardAnalysis.hpp"
+#include "ItemLayer.hpp"
+#include "Position.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class Simulation
+{
+public:
+  enum class Direction : uint8_t
+  {
+    Up,
+    Down,
+    Left,
+    Right
+  };
+
+  // Board cell content, either free or the snake of player (cell - 1)
+  typedef uint8_t Cell;
+  static Cell constexpr FREE = 0U;
+  static size_t constexpr MAX_PLAYERS = 64U;
+
+  struct Snake
+  {
+    // Body parts as ring buffer, ring[head] is the snake's head
+    std::vector<Position> ring;
+    uint32_t head;
+    uint32_t length;
+    Direction snakeDirection;
+    Direction pressedDirection;
+    bool alive;
+    // Parts still to grow from eaten items, one per move
+    uint32_t growth;
+
+    Position Head(void) const;
+    Position Tail(void) const;
+    Position Part(uint32_t const index) const;
+  };
+
+  // Complete game state, copying it saves or restores a game
+  struct State
+  {
+    std::vector<Cell> field;
+    std::vector<Snake> snakes;
+    Position apple;
+    uint16_t scoreCount;
+    uint64_t numberOfMoves;
+    uint64_t randomState;
+    bool running;
+    // Apples and power-ups of arena games
+    ItemLayer items;
+  };
+
+  struct Events
+  {
+    bool bite;
+    bool death;
+    bool over;
+  };
+
+  Simulation(Position const & size);
+  ~Simulation(void) = default;
+
+  void Restart(size_t const numberOfPlayers, uint64_t const seed);
+  Events Step(void);
+  bool Steer(size_t const player, Direction const direction);
+  void SetPressedDirection(size_t const player, Direction const direction);
+
+  void Save(State & snapshot) const;
+  void Restore(State const & snapshot);
+  uint64_t Checksum(void) const;
+
+  Position GetSize(void) const;
+  State const & GetState(void) const;
+  Cell GetCell(Position const & fieldpos) const;
+  bool IsFree(Position const & fieldpos) const;
+  bool HasApple(void) const;
+
+  // Cells written since the last clear, restarts, restores and long gaps mark the whole field instead
+  std::vector<Position> const & GetChangedCells(void) const;
+  bool IsFieldChanged(void) const;
+  void ClearChangedCells(void);
+
+private:
+  static size_t constexpr MAX_CHANGED_CELLS = 4096UL;
+  static uint32_t constexpr SCISSORS_CUT = 3U;
+
+  Position size;
+  State state;
+
+  // Scratch buffers of a step, not part of the state
+  std::vector<Position> snakeHeadpositions;
+  std::vector<uint8_t> headClaims;
+
+  // Free regions for placing apples
+  BoardAnalysis analysis;
+
+  // Change tracking for views of the field, not part of the state either
+  std::vector<Position> changedCells;
+  bool fieldChanged;
+
+  void AddSnakeHead(Snake & snake, Cell const marker, Position const fieldpos);
+  void RemoveSnakeTail(Snake & snake);
+  void MarkChanged(Position const & fieldpos);
+  void RandomApplePosition(void);
+  void ApplyItem(size_t const player, ItemLayer::Type const type, Events & events);
+  void SpawnItems(void);
+  uint32_t Random(void);
+  bool IsInside(Position const & fieldpos) const;
+};
@@ -0,0 +1,158 @@
+#include "Soak.hpp"
+#include <SDL_stdinc.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+static uint64_t ResidentBytes(void)
+{
+#ifdef __linux__
+  // Second field of statm is the resident set in pages
+  unsigned long size = 0UL;
+  unsigned long resident = 0UL;
+  FILE* const pFile = fopen("/proc/self/statm", "r");
+  if (pFile != nullptr)
+  {
+    if (fscanf(pFile, "%lu %lu", &size, &resident) != 2)
+    {
+      resident = 0UL;
+    }
+    fclose(pFile);
+  }
+  return static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0UL;
+#endif
+}
+
+
+static uint64_t Percentile(std::vector<uint32_t> const & sorted, size_t const percent)
+{
+  return sorted.empty() ? 0UL : sorted[(sorted.size() - 1UL) * percent / 100UL];
+}
+
+
+Soak::Soak(uint32_t const minutes)
+: duration_ms(static_cast<uint64_t>(minutes) * 60000UL)
+, start_ms(0UL)
+, nextSample_ms(0UL)
+, cycle(0U)
+, random(1U)
+, frameTimes_us()
+, samples()
+{
+  // Running matches draw about a frame per millisecond, sampling should not allocate
+  frameTimes_us.reserve(SAMPLE_PERIOD_MS * 2UL);
+  samples.reserve(duration_ms / SAMPLE_PERIOD_MS + 1UL);
+}
+
+
+void Soak::UseDummyDrivers(void)
+{
+  // No window and no sound device, a kiosk's week runs on a build server
+  (void)SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+  (void)SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+}
+
+
+void Soak::AddFrameTime(uint64_t const frameTime_us)
+{
+  frameTimes_us.push_back(static_cast<uint32_t>(std::min(frameTime_us, static_cast<uint64_t>(UINT32_MAX))));
+}
+
+
+bool Soak::Update(uint64_t const now_ms, size_t const numberOfTextures)
+{
+  if (start_ms == 0UL)
+  {
+    start_ms = now_ms;
+    nextSample_ms = now_ms + SAMPLE_PERIOD_MS;
+  }
+
+  if (now_ms >= nextSample_ms)
+  {
+    nextSample_ms += SAMPLE_PERIOD_MS;
+    std::sort(frameTimes_us.begin(), frameTimes_us.end());
+    Sample const sample = { ResidentBytes(), numberOfTextures, Percentile(frameTimes_us, 50UL), Percentile(frameTimes_us, 99UL) };
+    samples.push_back(sample);
+    frameTimes_us.clear();
+
+    std::cout << "soak " << ((now_ms - start_ms) / 60000UL) << " min: "
+              << "rss " << (sample.rss_bytes >> 10) << " KiB, "
+              << sample.textures << " textures, "
+              << "frame p50 " << sample.p50_us << " us, p99 " << sample.p99_us << " us, "
+              << cycle << " games" << std::endl;
+  }
+
+  return (now_ms - start_ms) < duration_ms;
+}
+
+
+bool Soak::Passed(void) const
+{
+  // Nothing compared is nothing passed, a run cut short must not look like a clean one
+  if (samples.size() < WARM_UP_SAMPLES + 2UL)
+  {
+    std::cout << "soak TOO SHORT to compare, " << samples.size() << " samples, at least " << (WARM_UP_SAMPLES + 2UL)
+              << " needed\n";
+    return false;
+  }
+
+  // The first and the second half after warm up have to look alike
+  size_t const split = WARM_UP_SAMPLES + (samples.size() - WARM_UP_SAMPLES) / 2UL;
+  uint64_t firstMaxRss_bytes = 0UL;
+  uint64_t secondMinRss_bytes = UINT64_MAX;
+  size_t firstMaxTextures = 0UL;
+  size_t secondMaxTextures = 0UL;
+  std::vector<uint64_t> firstP99_us;
+  std::vector<uint64_t> secondP99_us;
+  for (size_t i = WARM_UP_SAMPLES; i < samples.size(); ++i)
+  {
+    if (i < split)
+    {
+      firstMaxRss_bytes = std::max(firstMaxRss_bytes, samples[i].rss_bytes);
+      firstMaxTextures = std::max(firstMaxTextures, samples[i].textures);
+      firstP99_us.push_back(samples[i].p99_us);
+    }
+    else
+    {
+      secondMinRss_bytes = std::min(secondMinRss_bytes, samples[i].rss_bytes);
+      secondMaxTextures = std::max(secondMaxTextures, samples[i].textures);
+      secondP99_us.push_back(samples[i].p99_us);
+    }
+  }
+
+  // Medians, a single slow minute is no drift
+  std::sort(firstP99_us.begin(), firstP99_us.end());
+  std::sort(secondP99_us.begin(), secondP99_us.end());
+  uint64_t const firstMedianP99_us = firstP99_us[firstP99_us.size() / 2UL];
+  uint64_t const secondMedianP99_us = secondP99_us[secondP99_us.size() / 2UL];
+
+  bool const memoryGrows = secondMinRss_bytes > firstMaxRss_bytes + RSS_TOLERANCE_BYTES;
+  bool const texturesLeak = secondMaxTextures > firstMaxTextures;
+  bool const frameTimeDrifts = static_cast<double>(secondMedianP99_us) > static_cast<double>(firstMedianP99_us) * P99_TOLERANCE;
+
+  std::cout << "soak rss " << (firstMaxRss_bytes >> 10) << " -> " << (secondMinRss_bytes >> 10) << " KiB"
+            << (memoryGrows ? " GROWS" : "") << ", "
+            << "textures " << firstMaxTextures << " -> " << secondMaxTextures
+            << (texturesLeak ? " LEAK" : "") << ", "
+            << "frame p99 " << firstMedianP99_us << " -> " << secondMedianP99_us << " us"
+            << (frameTimeDrifts ? " DRIFTS" : "") << "\n";
+  return !memoryGrows && !texturesLeak && !frameTimeDrifts;
+}
+
+
+uint32_t Soak::NextCycle(void)
+{
+  return cycle++;
+}
+
+
+uint32_t Soak::Random(void)
+{
+  return random();
+}
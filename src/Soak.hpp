@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Watches a long scripted run of the game for growing memory, leaked textures and drifting frame times
+class Soak
+{
+public:
+  Soak(uint32_t const minutes);
+
+  // Has to be called before SDL is initialized
+  static void UseDummyDrivers(void);
+
+  void AddFrameTime(uint64_t const frameTime_us);
+  // Samples once per period, false once the soak is over
+  bool Update(uint64_t const now_ms, size_t const numberOfTextures);
+  bool Passed(void) const;
+  // Cycles are the scripted games, each may differ in mode and outcome
+  uint32_t NextCycle(void);
+  uint32_t Random(void);
+
+private:
+  static uint64_t constexpr SAMPLE_PERIOD_MS = 60000UL;
+  // Caches, fonts and the highscore banner settle during the first minutes
+  static size_t constexpr WARM_UP_SAMPLES = 5UL;
+  static uint64_t constexpr RSS_TOLERANCE_BYTES = 4UL << 20;
+  static double constexpr P99_TOLERANCE = 1.5;
+
+  struct Sample
+  {
+    uint64_t rss_bytes;
+    size_t textures;
+    uint64_t p50_us;
+    uint64_t p99_us;
+  };
+
+  uint64_t duration_ms;
+  uint64_t start_ms;
+  uint64_t nextSample_ms;
+  uint32_t cycle;
+  std::mt19937 random;
+  std::vector<uint32_t> frameTimes_us;
+  std::vector<Sample> samples;
+};
@@ -0,0 +1,660 @@
+#include "SoftwareRenderBackend.hpp"
+#include "Position.hpp"
+#include <SDL_render.h>
+#include <SDL_surface.h>
+#include <SDL_video.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTWARE_RENDERER_SSE2
+#endif
+
+static uint32_t PackColor(SDL_Color const & color)
+{
+  return 0xFF000000U | (static_cast<uint32_t>(color.b) << 16) | (static_cast<uint32_t>(color.g) << 8) | color.r;
+}
+
+
+static int32_t ToFixed(double const value)
+{
+  // 16.16 fixed point, rounded down like the texel index it becomes
+  return static_cast<int32_t>(std::floor(value * 65536.0));
+}
+
+
+static void FillRow(uint32_t* const pDst, int const count, uint32_t const color, bool const simd)
+{
+  int i = 0;
+#ifdef SOFTWARE_RENDERER_SSE2
+  __m128i const colors = _mm_set1_epi32(static_cast<int>(color));
+  for (; simd && (i + 4 <= count); i += 4)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), colors);
+  }
+#else
+  (void)simd;
+#endif
+  for (; i < count; ++i)
+  {
+    pDst[i] = color;
+  }
+}
+
+
+static uint32_t BlendChannel(uint32_t const src, uint32_t const dst, uint32_t const alpha)
+{
+  // Rounded division by 255, exact for every sum of two 8 bit products
+  uint32_t const sum = src * alpha + dst * (255U - alpha) + 128U;
+  return (sum + (sum >> 8)) >> 8;
+}
+
+
+static void BlendRow(uint32_t* const pDst, uint32_t const * const pSrc, int const count, bool const simd)
+{
+  // Like SDL_BLENDMODE_BLEND on an opaque framebuffer, the SIMD and scalar paths give the same pixels
+  int i = 0;
+#ifdef SOFTWARE_RENDERER_SSE2
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const full = _mm_set1_epi16(255);
+  __m128i const bias = _mm_set1_epi16(128);
+  __m128i const opaque = _mm_set1_epi32(static_cast<int>(0xFF000000U));
+  for (; simd && (i + 4 <= count); i += 4)
+  {
+    __m128i const src = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pSrc + i));
+    __m128i const dst = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pDst + i));
+    __m128i halves[2];
+    for (int half = 0; half < 2; ++half)
+    {
+      __m128i const src16 = half ? _mm_unpackhi_epi8(src, zero) : _mm_unpacklo_epi8(src, zero);
+      __m128i const dst16 = half ? _mm_unpackhi_epi8(dst, zero) : _mm_unpacklo_epi8(dst, zero);
+      __m128i const alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src16, 0xFF), 0xFF);
+      __m128i sum = _mm_add_epi16(_mm_mullo_epi16(src16, alpha), _mm_mullo_epi16(dst16, _mm_sub_epi16(full, alpha)));
+      sum = _mm_add_epi16(sum, bias);
+      halves[half] = _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_or_si128(_mm_packus_epi16(halves[0], halves[1]), opaque));
+  }
+#else
+  (void)simd;
+#endif
+  for (; i < count; ++i)
+  {
+    uint32_t const src = pSrc[i];
+    uint32_t const dst = pDst[i];
+    uint32_t const alpha = src >> 24;
+    pDst[i] = 0xFF000000U
+            | (BlendChannel((src >> 16) & 0xFFU, (dst >> 16) & 0xFFU, alpha) << 16)
+            | (BlendChannel((src >> 8) & 0xFFU, (dst >> 8) & 0xFFU, alpha) << 8)
+            | BlendChannel(src & 0xFFU, dst & 0xFFU, alpha);
+  }
+}
+
+
+static void SampleRotatedRow(uint32_t* const pRow, int const count, uint32_t const * const pTexels, Position const & size,
+                             int32_t const u, int32_t const v, int32_t const stepU, int32_t const stepV, bool const simd)
+{
+  // Texel coordinates in 16.16 fixed point, stepped along the row, texels outside the texture are transparent.
+  // Textures stay below 2^14 pixels a side, so coordinates of the rotated bounds and texel rows fit
+  int32_t const limitU = size.x << 16;
+  int32_t const limitV = size.y << 16;
+  // Stepped as unsigned, so both paths wrap alike should a coordinate ever overflow
+  uint32_t rowU = static_cast<uint32_t>(u);
+  uint32_t rowV = static_cast<uint32_t>(v);
+  int i = 0;
+#ifdef SOFTWARE_RENDERER_SSE2
+  if (simd && (count >= 4))
+  {
+    __m128i const minusOne = _mm_set1_epi32(-1);
+    __m128i const limitsU = _mm_set1_epi32(limitU);
+    __m128i const limitsV = _mm_set1_epi32(limitV);
+    // Rows of the texture are multiplied in the low halves of the lanes, the high halves stay zero
+    __m128i const width = _mm_set1_epi32(size.x);
+    __m128i const stepsU = _mm_set1_epi32(static_cast<int>(4U * static_cast<uint32_t>(stepU)));
+    __m128i const stepsV = _mm_set1_epi32(static_cast<int>(4U * static_cast<uint32_t>(stepV)));
+    __m128i laneU = _mm_set_epi32(static_cast<int>(rowU + 3U * static_cast<uint32_t>(stepU)),
+                                  static_cast<int>(rowU + 2U * static_cast<uint32_t>(stepU)),
+                                  static_cast<int>(rowU + static_cast<uint32_t>(stepU)), static_cast<int>(rowU));
+    __m128i laneV = _mm_set_epi32(static_cast<int>(rowV + 3U * static_cast<uint32_t>(stepV)),
+                                  static_cast<int>(rowV + 2U * static_cast<uint32_t>(stepV)),
+                                  static_cast<int>(rowV + static_cast<uint32_t>(stepV)), static_cast<int>(rowV));
+    alignas(16) int32_t indices[4];
+    for (; i + 4 <= count; i += 4)
+    {
+      __m128i const inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(laneU, minusOne), _mm_cmpgt_epi32(limitsU, laneU)),
+                                           _mm_and_si128(_mm_cmpgt_epi32(laneV, minusOne), _mm_cmpgt_epi32(limitsV, laneV)));
+      // Lanes outside sample texel 0 and are masked afterwards
+      __m128i const texelU = _mm_and_si128(inside, _mm_srai_epi32(laneU, 16));
+      __m128i const texelV = _mm_and_si128(inside, _mm_srai_epi32(laneV, 16));
+      _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_add_epi32(_mm_madd_epi16(texelV, width), texelU));
+      // SSE2 has no gather, so the texels are loaded per lane
+      __m128i const texels = _mm_set_epi32(static_cast<int>(pTexels[indices[3]]), static_cast<int>(pTexels[indices[2]]),
+                                           static_cast<int>(pTexels[indices[1]]), static_cast<int>(pTexels[indices[0]]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pRow + i), _mm_and_si128(inside, texels));
+      laneU = _mm_add_epi32(laneU, stepsU);
+      laneV = _mm_add_epi32(laneV, stepsV);
+    }
+    rowU += static_cast<uint32_t>(i) * static_cast<uint32_t>(stepU);
+    rowV += static_cast<uint32_t>(i) * static_cast<uint32_t>(stepV);
+  }
+#else
+  (void)simd;
+#endif
+  for (; i < count; ++i)
+  {
+    int32_t const texelU = static_cast<int32_t>(rowU);
+    int32_t const texelV = static_cast<int32_t>(rowV);
+    bool const inside = (texelU >= 0) && (texelU < limitU) && (texelV >= 0) && (texelV < limitV);
+    pRow[i] = inside ? pTexels[(texelV >> 16) * size.x + (texelU >> 16)] : 0U;
+    rowU += static_cast<uint32_t>(stepU);
+    rowV += static_cast<uint32_t>(stepV);
+  }
+}
+
+
+SoftwareRenderBackend::SoftwareRenderBackend(SDL_Window* const pWindow, Position const & res,
+                                             size_t const numberOfThreads, bool const simd)
+: simd(simd)
+, pRenderer(SDL_CreateRenderer(pWindow, -1, SDL_RENDERER_SOFTWARE))
+, pScreen(nullptr)
+, resolution(res)
+, framebuffer()
+, commands()
+, destroyedTextures()
+, freeTextures()
+, tiles{ 0, 0 }
+, tileCommands()
+, capture(false)
+, captureUnread(false)
+, workers()
+, workersMutex()
+, startCondition()
+, doneCondition()
+, frameNumber(0UL)
+, busyWorkers(0UL)
+, nextTile(0UL)
+, stopWorkers(false)
+{
+  if (pRenderer == nullptr)
+    throw std::runtime_error("SoftwareRenderBackend::SoftwareRenderBackend: Renderer could not be created.");
+
+  CreateScreen();
+
+  for (size_t i = 1UL; i < numberOfThreads; ++i)
+  {
+    workers.emplace_back(&SoftwareRenderBackend::RunWorker, this);
+  }
+}
+
+
+SoftwareRenderBackend::~SoftwareRenderBackend(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(workersMutex);
+    stopWorkers = true;
+  }
+  startCondition.notify_all();
+  for (std::thread & worker : workers)
+  {
+    worker.join();
+  }
+
+  for (Texture* const pTexture : destroyedTextures)
+  {
+    delete static_cast<SoftwareTexture*>(pTexture);
+  }
+  for (SoftwareTexture* const pTexture : freeTextures)
+  {
+    delete pTexture;
+  }
+
+  SDL_DestroyTexture(pScreen);
+  SDL_DestroyRenderer(pRenderer);
+}
+
+
+Texture* SoftwareRenderBackend::CreateTexture(SDL_Surface* const pSurface)
+{
+  if (pSurface == nullptr)
+  {
+    return nullptr;
+  }
+
+  SDL_Surface* const pConverted = SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_ABGR8888, 0);
+  if (pConverted == nullptr)
+  {
+    return nullptr;
+  }
+
+  // Recycled textures keep their pixel memory
+  SoftwareTexture* const pTexture = freeTextures.empty() ? new SoftwareTexture : freeTextures.back();
+  if (!freeTextures.empty())
+  {
+    freeTextures.pop_back();
+  }
+  pTexture->size = { pConverted->w, pConverted->h };
+  pTexture->pixels.resize(static_cast<size_t>(pConverted->w) * pConverted->h);
+  SDL_LockSurface(pConverted);
+  for (int y = 0; y < pConverted->h; ++y)
+  {
+    std::memcpy(pTexture->pixels.data() + static_cast<size_t>(y) * pConverted->w,
+                static_cast<uint8_t const *>(pConverted->pixels) + static_cast<size_t>(y) * pConverted->pitch,
+                static_cast<size_t>(pConverted->w) * 4UL);
+  }
+  SDL_UnlockSurface(pConverted);
+  SDL_FreeSurface(pConverted);
+  return pTexture;
+}
+
+
+void SoftwareRenderBackend::DestroyTexture(Texture* const pTexture)
+{
+  if (pTexture != nullptr)
+  {
+    // Recorded commands may still use the texture, it goes away after present
+    destroyedTextures.push_back(pTexture);
+  }
+}
+
+
+void SoftwareRenderBackend::UpdateTexture(Texture* const pTexture, uint32_t const * const pPixels)
+{
+  if (pTexture != nullptr)
+  {
+    // Commands recorded so far have not been replayed yet, so the texture should be updated before it is drawn
+    std::vector<uint32_t> & pixels = static_cast<SoftwareTexture*>(pTexture)->pixels;
+    std::memcpy(pixels.data(), pPixels, pixels.size() * sizeof(uint32_t));
+  }
+}
+
+
+void SoftwareRenderBackend::Clean(SDL_Color const & color)
+{
+  Command command = {};
+  command.type = CommandType::Clean;
+  command.color = PackColor(color);
+  command.boundsMin = { 0, 0 };
+  command.boundsMax = resolution;
+  Record(command);
+}
+
+
+void SoftwareRenderBackend::Copy(Texture* const pTexture, Position const & position, Position const & scale,
+                                 double const angle)
+{
+  if ((pTexture == nullptr) || (scale.x <= 0) || (scale.y <= 0) || (pTexture->size.x <= 0) || (pTexture->size.y <= 0))
+  {
+    return;
+  }
+
+  Command command = {};
+  command.type = (angle != 0.0) ? CommandType::RotatedCopy : CommandType::Copy;
+  command.pTexture = static_cast<SoftwareTexture const *>(pTexture);
+  command.position = position;
+  command.scale = scale;
+  command.boundsMin = position;
+  command.boundsMax = { position.x + scale.x, position.y + scale.y };
+
+  if (command.type == CommandType::RotatedCopy)
+  {
+    // Clockwise around the center like SDL_RenderCopyEx, bounds cover the rotated corners
+    double const radians = angle * M_PI / 180.0;
+    command.sine = std::sin(radians);
+    command.cosine = std::cos(radians);
+    double const halfWidth = (std::fabs(scale.x * command.cosine) + std::fabs(scale.y * command.sine)) / 2.0;
+    double const halfHeight = (std::fabs(scale.x * command.sine) + std::fabs(scale.y * command.cosine)) / 2.0;
+    double const centerX = position.x + scale.x / 2.0;
+    double const centerY = position.y + scale.y / 2.0;
+    command.boundsMin = { static_cast<int>(std::floor(centerX - halfWidth)),
+                          static_cast<int>(std::floor(centerY - halfHeight)) };
+    command.boundsMax = { static_cast<int>(std::ceil(centerX + halfWidth)),
+                          static_cast<int>(std::ceil(centerY + halfHeight)) };
+  }
+
+  Record(command);
+}
+
+
+void SoftwareRenderBackend::FillRect(Position const & position, Position const & scale, SDL_Color const & color)
+{
+  Command command = {};
+  command.type = CommandType::Fill;
+  command.color = PackColor(color);
+  command.boundsMin = position;
+  command.boundsMax = { position.x + scale.x, position.y + scale.y };
+  Record(command);
+}
+
+
+void SoftwareRenderBackend::FillTriangles(Position const * const pPositions, size_t const count, SDL_Color const & color)
+{
+  for (size_t i = 0UL; i + 3UL <= count; i += 3UL)
+  {
+    RecordTriangle(&pPositions[i], PackColor(color));
+  }
+}
+
+
+void SoftwareRenderBackend::FillColoredTriangles(Position const * const pPositions, SDL_Color const * const pColors, size_t const count)
+{
+  for (size_t i = 0UL; i + 3UL <= count; i += 3UL)
+  {
+    RecordTriangle(&pPositions[i], PackColor(pColors[i / 3UL]));
+  }
+}
+
+
+void SoftwareRenderBackend::Present(void)
+{
+  RenderTiles();
+  commands.clear();
+
+  for (Texture* const pTexture : destroyedTextures)
+  {
+    freeTextures.push_back(static_cast<SoftwareTexture*>(pTexture));
+  }
+  destroyedTextures.clear();
+
+  SDL_UpdateTexture(pScreen, nullptr, framebuffer.data(), resolution.x * 4);
+  SDL_RenderCopy(pRenderer, pScreen, nullptr, nullptr);
+  SDL_RenderPresent(pRenderer);
+  captureUnread = capture;
+}
+
+
+void SoftwareRenderBackend::Resize(Position const & res)
+{
+  resolution = res;
+  CreateScreen();
+}
+
+
+void SoftwareRenderBackend::EnableCapture(void)
+{
+  capture = true;
+}
+
+
+bool SoftwareRenderBackend::HasCapturedFrame(bool const) const
+{
+  // The framebuffer is complete after present, there is nothing to wait for
+  return captureUnread;
+}
+
+
+void SoftwareRenderBackend::ReadCapturedFrame(uint8_t* const pPixels)
+{
+  std::memcpy(pPixels, framebuffer.data(), framebuffer.size() * 4UL);
+  captureUnread = false;
+}
+
+
+void SoftwareRenderBackend::RecordTriangle(Position const * const pVertices, uint32_t const color)
+{
+  Command command = {};
+  command.type = CommandType::Triangle;
+  command.color = color;
+  command.vertices[0] = pVertices[0];
+  command.vertices[1] = pVertices[1];
+  command.vertices[2] = pVertices[2];
+  command.boundsMin = { std::min({ pVertices[0].x, pVertices[1].x, pVertices[2].x }),
+                        std::min({ pVertices[0].y, pVertices[1].y, pVertices[2].y }) };
+  command.boundsMax = { std::max({ pVertices[0].x, pVertices[1].x, pVertices[2].x }) + 1,
+                        std::max({ pVertices[0].y, pVertices[1].y, pVertices[2].y }) + 1 };
+  Record(command);
+}
+
+
+void SoftwareRenderBackend::Record(Command & command)
+{
+  command.boundsMin = { std::max(command.boundsMin.x, 0), std::max(command.boundsMin.y, 0) };
+  command.boundsMax = { std::min(command.boundsMax.x, resolution.x), std::min(command.boundsMax.y, resolution.y) };
+  if ((command.boundsMin.x < command.boundsMax.x) && (command.boundsMin.y < command.boundsMax.y))
+  {
+    commands.push_back(command);
+  }
+}
+
+
+void SoftwareRenderBackend::RenderTiles(void)
+{
+  // Sort the commands into the tiles they touch, keeping their order
+  for (std::vector<uint32_t> & tile : tileCommands)
+  {
+    tile.clear();
+  }
+  for (size_t i = 0UL; i < commands.size(); ++i)
+  {
+    Command const & command = commands[i];
+    for (int y = command.boundsMin.y / TILE_SIZE; y <= (command.boundsMax.y - 1) / TILE_SIZE; ++y)
+    {
+      for (int x = command.boundsMin.x / TILE_SIZE; x <= (command.boundsMax.x - 1) / TILE_SIZE; ++x)
+      {
+        tileCommands[y * tiles.x + x].push_back(static_cast<uint32_t>(i));
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(workersMutex);
+    nextTile = 0UL;
+    busyWorkers = workers.size();
+    ++frameNumber;
+  }
+  startCondition.notify_all();
+
+  RenderAvailableTiles();
+
+  std::unique_lock<std::mutex> lock(workersMutex);
+  doneCondition.wait(lock, [this]{ return busyWorkers == 0UL; });
+}
+
+
+void SoftwareRenderBackend::RenderAvailableTiles(void)
+{
+  for (size_t tile = nextTile++; tile < tileCommands.size(); tile = nextTile++)
+  {
+    RenderTile(tile);
+  }
+}
+
+
+void SoftwareRenderBackend::RenderTile(size_t const tile)
+{
+  Position const tileMin = { static_cast<int>(tile % tiles.x) * TILE_SIZE, static_cast<int>(tile / tiles.x) * TILE_SIZE };
+  Position const tileMax = { std::min(tileMin.x + TILE_SIZE, resolution.x), std::min(tileMin.y + TILE_SIZE, resolution.y) };
+  uint32_t row[TILE_SIZE];
+
+  for (uint32_t const index : tileCommands[tile])
+  {
+    Command const & command = commands[index];
+    Position const clipMin = { std::max(tileMin.x, command.boundsMin.x), std::max(tileMin.y, command.boundsMin.y) };
+    Position const clipMax = { std::min(tileMax.x, command.boundsMax.x), std::min(tileMax.y, command.boundsMax.y) };
+    int const width = clipMax.x - clipMin.x;
+
+    switch (command.type)
+    {
+      case CommandType::Clean:
+      case CommandType::Fill:
+        for (int y = clipMin.y; y < clipMax.y; ++y)
+        {
+          FillRow(&framebuffer[y * resolution.x + clipMin.x], width, command.color, simd);
+        }
+        break;
+
+      case CommandType::Triangle:
+        RenderTriangle(command, clipMin, clipMax);
+        break;
+
+      case CommandType::Copy:
+      {
+        // Nearest neighbour sampling at the pixel centers, unscaled rows are blended in place
+        Position const & size = command.pTexture->size;
+        for (int y = clipMin.y; y < clipMax.y; ++y)
+        {
+          int const v = ((2 * (y - command.position.y) + 1) * size.y) / (2 * command.scale.y);
+          uint32_t const * const pSrcRow = &command.pTexture->pixels[static_cast<size_t>(v) * size.x];
+          uint32_t* const pDst = &framebuffer[y * resolution.x + clipMin.x];
+          if (command.scale.x == size.x)
+          {
+            BlendRow(pDst, pSrcRow + (clipMin.x - command.position.x), width, simd);
+            continue;
+          }
+          for (int x = clipMin.x; x < clipMax.x; ++x)
+          {
+            row[x - clipMin.x] = pSrcRow[((2 * (x - command.position.x) + 1) * size.x) / (2 * command.scale.x)];
+          }
+          BlendRow(pDst, row, width, simd);
+        }
+        break;
+      }
+
+      case CommandType::RotatedCopy:
+      {
+        // Rotate the first pixel center of each row back into the texture, the others are a constant step away
+        Position const & size = command.pTexture->size;
+        double const centerX = command.position.x + command.scale.x / 2.0;
+        double const centerY = command.position.y + command.scale.y / 2.0;
+        double const texelsX = static_cast<double>(size.x) / command.scale.x;
+        double const texelsY = static_cast<double>(size.y) / command.scale.y;
+        int32_t const stepU = ToFixed(command.cosine * texelsX);
+        int32_t const stepV = ToFixed(-command.sine * texelsY);
+        double const dx = clipMin.x + 0.5 - centerX;
+        for (int y = clipMin.y; y < clipMax.y; ++y)
+        {
+          double const dy = y + 0.5 - centerY;
+          int32_t const u = ToFixed((dx * command.cosine + dy * command.sine + command.scale.x / 2.0) * texelsX);
+          int32_t const v = ToFixed((-dx * command.sine + dy * command.cosine + command.scale.y / 2.0) * texelsY);
+          SampleRotatedRow(row, width, command.pTexture->pixels.data(), size, u, v, stepU, stepV, simd);
+          BlendRow(&framebuffer[y * resolution.x + clipMin.x], row, width, simd);
+        }
+        break;
+      }
+    }
+  }
+}
+
+
+void SoftwareRenderBackend::RenderTriangle(Command const & command, Position const & clipMin, Position const & clipMax)
+{
+  // Edge functions at the pixel centers in doubled coordinates, so everything stays integer
+  Position a = command.vertices[0];
+  Position b = command.vertices[1];
+  Position c = command.vertices[2];
+  int64_t const area = static_cast<int64_t>(b.x - a.x) * (c.y - a.y) - static_cast<int64_t>(b.y - a.y) * (c.x - a.x);
+  if (area == 0)
+  {
+    return;
+  }
+  if (area < 0)
+  {
+    std::swap(b, c);
+  }
+
+  Position const edges[3][2] = { { a, b }, { b, c }, { c, a } };
+#ifdef SOFTWARE_RENDERER_SSE2
+  // Within triangles narrower than 2^14 pixels the edge functions fit into 32 bits, then four pixels are tested at once
+  int const extentX = std::max({ a.x, b.x, c.x }) - std::min({ a.x, b.x, c.x });
+  int const extentY = std::max({ a.y, b.y, c.y }) - std::min({ a.y, b.y, c.y });
+  bool const vectorized = simd && (extentX < (1 << 14)) && (extentY < (1 << 14));
+  __m128i const color = _mm_set1_epi32(static_cast<int>(command.color));
+  __m128i thresholds[3];
+  __m128i steps[3];
+  for (int edge = 0; edge < 3; ++edge)
+  {
+    int32_t const dx = edges[edge][1].x - edges[edge][0].x;
+    int32_t const dy = edges[edge][1].y - edges[edge][0].y;
+    // Values above -1 instead of above 0 put pixels centered on top and left edges inside
+    thresholds[edge] = _mm_set1_epi32(((dy < 0) || ((dy == 0) && (dx > 0))) ? -1 : 0);
+    steps[edge] = _mm_set1_epi32(-8 * dy);
+  }
+#endif
+  for (int y = clipMin.y; y < clipMax.y; ++y)
+  {
+    int x = clipMin.x;
+#ifdef SOFTWARE_RENDERER_SSE2
+    if (vectorized && (x + 4 <= clipMax.x))
+    {
+      __m128i values[3];
+      for (int edge = 0; edge < 3; ++edge)
+      {
+        int32_t const dx = edges[edge][1].x - edges[edge][0].x;
+        int32_t const dy = edges[edge][1].y - edges[edge][0].y;
+        int32_t const value = dx * (2 * y + 1 - 2 * edges[edge][0].y) - dy * (2 * x + 1 - 2 * edges[edge][0].x);
+        values[edge] = _mm_set_epi32(value - 6 * dy, value - 4 * dy, value - 2 * dy, value);
+      }
+      for (; x + 4 <= clipMax.x; x += 4)
+      {
+        __m128i const inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(values[0], thresholds[0]),
+                                                           _mm_cmpgt_epi32(values[1], thresholds[1])),
+                                             _mm_cmpgt_epi32(values[2], thresholds[2]));
+        __m128i* const pDst = reinterpret_cast<__m128i*>(&framebuffer[y * resolution.x + x]);
+        _mm_storeu_si128(pDst, _mm_or_si128(_mm_and_si128(inside, color), _mm_andnot_si128(inside, _mm_loadu_si128(pDst))));
+        for (int edge = 0; edge < 3; ++edge)
+        {
+          values[edge] = _mm_add_epi32(values[edge], steps[edge]);
+        }
+      }
+    }
+#endif
+    for (; x < clipMax.x; ++x)
+    {
+      bool inside = true;
+      for (Position const (& edge)[2] : edges)
+      {
+        int64_t const dx = edge[1].x - edge[0].x;
+        int64_t const dy = edge[1].y - edge[0].y;
+        int64_t const value = dx * (2 * y + 1 - 2 * edge[0].y) - dy * (2 * x + 1 - 2 * edge[0].x);
+
+        // Pixels centered on an edge belong to the top and left edges only
+        bool const topLeft = (dy < 0) || ((dy == 0) && (dx > 0));
+        inside = inside && ((value > 0) || ((value == 0) && topLeft));
+      }
+      if (inside)
+      {
+        framebuffer[y * resolution.x + x] = command.color;
+      }
+    }
+  }
+}
+
+
+void SoftwareRenderBackend::RunWorker(void)
+{
+  uint64_t renderedFrame = 0UL;
+  std::unique_lock<std::mutex> lock(workersMutex);
+  while (true)
+  {
+    startCondition.wait(lock, [this, &renderedFrame]{ return stopWorkers || (frameNumber != renderedFrame); });
+    if (stopWorkers)
+    {
+      break;
+    }
+    renderedFrame = frameNumber;
+    lock.unlock();
+
+    RenderAvailableTiles();
+
+    lock.lock();
+    if (--busyWorkers == 0UL)
+    {
+      doneCondition.notify_one();
+    }
+  }
+}
+
+
+void SoftwareRenderBackend::CreateScreen(void)
+{
+  framebuffer.assign(static_cast<size_t>(resolution.x) * resolution.y, 0xFF000000U);
+  tiles = { (resolution.x + TILE_SIZE - 1) / TILE_SIZE, (resolution.y + TILE_SIZE - 1) / TILE_SIZE };
+  tileCommands.resize(static_cast<size_t>(tiles.x) * tiles.y);
+
+  SDL_DestroyTexture(pScreen);
+  pScreen = SDL_CreateTexture(pRenderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, resolution.x, resolution.y);
+  if (pScreen == nullptr)
+    throw std::runtime_error("SoftwareRenderBackend::CreateScreen: Screen texture could not be created.");
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Position.hpp"
+#include "RenderBackend.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef struct SDL_Window SDL_Window;
+typedef struct SDL_Renderer SDL_Renderer;
+typedef struct SDL_Texture SDL_Texture;
+
+class SoftwareRenderBackend : public RenderBackend
+{
+public:
+  // Without SIMD every row goes through the scalar code, the selftest compares both
+  SoftwareRenderBackend(SDL_Window* const pWindow, Position const & res, size_t const numberOfThreads, bool const simd = true);
+  ~SoftwareRenderBackend(void) override;
+
+  Texture* CreateTexture(SDL_Surface* const pSurface) override;
+  void DestroyTexture(Texture* const pTexture) override;
+  void UpdateTexture(Texture* const pTexture, uint32_t const * const pPixels) override;
+  void Clean(SDL_Color const & color) override;
+  void Copy(Texture* const pTexture, Position const & position, Position const & scale, double const angle) override;
+  void FillRect(Position const & position, Position const & scale, SDL_Color const & color) override;
+  void FillTriangles(Position const * const pPositions, size_t const count, SDL_Color const & color) override;
+  void FillColoredTriangles(Position const * const pPositions, SDL_Color const * const pColors, size_t const count) override;
+  void Present(void) override;
+  void Resize(Position const & res) override;
+
+  void EnableCapture(void) override;
+  bool HasCapturedFrame(bool const finish) const override;
+  void ReadCapturedFrame(uint8_t* const pPixels) override;
+
+private:
+  static int constexpr TILE_SIZE = 64;
+
+  struct SoftwareTexture : Texture
+  {
+    // ABGR8888, so the bytes of a pixel are in RGBA order on little endian machines
+    std::vector<uint32_t> pixels;
+  };
+
+  enum class CommandType : uint8_t
+  {
+    Clean,
+    Fill,
+    Triangle,
+    Copy,
+    RotatedCopy
+  };
+
+  // Draw calls are recorded during the frame and replayed per tile on present
+  struct Command
+  {
+    CommandType type;
+    uint32_t color;
+    SoftwareTexture const * pTexture;
+    Position position;
+    Position scale;
+    Position vertices[3];
+    double sine;
+    double cosine;
+    Position boundsMin;
+    Position boundsMax;
+  };
+
+  bool simd;
+  SDL_Renderer* pRenderer;
+  SDL_Texture* pScreen;
+  Position resolution;
+  std::vector<uint32_t> framebuffer;
+  std::vector<Command> commands;
+  std::vector<Texture*> destroyedTextures;
+  std::vector<SoftwareTexture*> freeTextures;
+  Position tiles;
+  std::vector<std::vector<uint32_t>> tileCommands;
+  bool capture;
+  bool captureUnread;
+
+  // Tile workers, the rendering thread takes its share of tiles as well
+  std::vector<std::thread> workers;
+  std::mutex workersMutex;
+  std::condition_variable startCondition;
+  std::condition_variable doneCondition;
+  uint64_t frameNumber;
+  size_t busyWorkers;
+  std::atomic<size_t> nextTile;
+  bool stopWorkers;
+
+  void RecordTriangle(Position const * const pVertices, uint32_t const color);
+  void Record(Command & command);
+  void RenderTiles(void);
+  void RenderAvailableTiles(void);
+  void RenderTile(size_t const tile);
+  void RenderTriangle(Command const & command, Position const & clipMin, Position const & clipMax);
+  void RunWorker(void);
+  void CreateScreen(void);
+};
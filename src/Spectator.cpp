@@ -0,0 +1,208 @@
+#include "Spectator.hpp"
+#include "BoardAnalysis.hpp"
+#include "Bot.hpp"
+#include "Options.hpp"
+#include "RewindBuffer.hpp"
+#include "Simulation.hpp"
+#include "SpectatorFeed.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static uint32_t constexpr WATCH_POLL_PERIOD_MS = 10U;
+static uint32_t constexpr WATCH_PRINT_PERIOD_MS = 1000U;
+
+// Much faster than the game's tick, so readers fall behind and have to catch up with bursts of records
+static uint64_t constexpr SELFTEST_TICKS = 5000UL;
+static uint32_t constexpr SELFTEST_TICK_PERIOD_US = 1000U;
+static uint32_t constexpr SELFTEST_POLL_PERIOD_MS = 5U;
+static uint32_t constexpr SELFTEST_ATTACH_TIME_MS = 200U;
+static size_t constexpr SELFTEST_REWIND_TICKS = 1024UL;
+// Ticks with readers may be this much slower on average than without
+static double constexpr MAX_SLOWDOWN = 1.25;
+
+struct TickTimes
+{
+  uint64_t mean_ns;
+  uint64_t p99_ns;
+};
+
+int RunSpectator(Options const & options)
+{
+  std::unique_ptr<SpectatorReader> pReader;
+  try {
+    pReader.reset(new SpectatorReader(options.spectatorWatch));
+  } catch (std::exception const & exception) {
+    std::cerr << exception.what() << "\n";
+    return 1;
+  }
+
+  Simulation::State state;
+  bool hasState = false;
+  std::chrono::steady_clock::time_point nextPrint = std::chrono::steady_clock::now();
+  while (pReader->IsOpen())
+  {
+    hasState = pReader->Poll(state) || hasState;
+
+    std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now();
+    if (hasState && (now >= nextPrint))
+    {
+      nextPrint = now + std::chrono::milliseconds(WATCH_PRINT_PERIOD_MS);
+      size_t alive = 0UL;
+      uint32_t longest = 0U;
+      for (Simulation::Snake const & snake : state.snakes)
+      {
+        alive += snake.alive ? 1UL : 0UL;
+        longest = std::max(longest, snake.length);
+      }
+      std::cout << "tick " << state.numberOfMoves << ": " << alive << " of " << state.snakes.size()
+                << " snakes alive, longest " << longest << ", " << state.items.GetNumberOfItems() << " items"
+                << (state.running ? "" : ", over") << std::endl;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_POLL_PERIOD_MS));
+  }
+
+  std::cout << "Feed closed after " << pReader->GetNumberOfRecords() << " records, "
+            << pReader->GetNumberOfResyncs() << " resyncs, " << pReader->GetNumberOfMismatches() << " mismatches\n";
+  return (pReader->GetNumberOfMismatches() == 0UL) ? 0 : 1;
+}
+
+
+#ifndef _WIN32
+static TickTimes RunTicks(Simulation & simulation, RewindBuffer & rewind, SpectatorFeed & feed,
+                          size_t const numberOfPlayers, uint64_t & seed)
+{
+  BoardAnalysis analysis;
+  std::vector<uint64_t> tickDurations_ns;
+  tickDurations_ns.reserve(SELFTEST_TICKS);
+
+  std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+  for (uint64_t tick = 0UL; tick < SELFTEST_TICKS; ++tick)
+  {
+    std::this_thread::sleep_until(nextTick);
+    nextTick += std::chrono::microseconds(SELFTEST_TICK_PERIOD_US);
+    std::chrono::steady_clock::time_point const begin = std::chrono::steady_clock::now();
+
+    // A tick like in the game, bots decide, then the step is recorded and published
+    std::vector<Simulation::Snake> const & snakes = simulation.GetState().snakes;
+    analysis.Analyze(simulation.GetState().field, simulation.GetSize());
+    for (size_t i = 0UL; i < snakes.size(); ++i)
+    {
+      if (snakes[i].alive)
+      {
+        simulation.SetPressedDirection(i, ChooseBotDirection(simulation, analysis, i));
+      }
+    }
+    if (simulation.Step().over)
+    {
+      rewind.Clear();
+      simulation.Restart(numberOfPlayers, ++seed);
+    }
+    rewind.Record(simulation.GetState());
+    feed.Publish(rewind, simulation.GetState().numberOfMoves);
+
+    tickDurations_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - begin).count());
+  }
+
+  uint64_t total_ns = 0UL;
+  for (uint64_t const duration_ns : tickDurations_ns)
+  {
+    total_ns += duration_ns;
+  }
+  std::sort(tickDurations_ns.begin(), tickDurations_ns.end());
+  return { total_ns / tickDurations_ns.size(), tickDurations_ns[tickDurations_ns.size() * 99U / 100U] };
+}
+
+
+static int RunReader(std::string const & name)
+{
+  try {
+    SpectatorReader reader(name);
+    Simulation::State state;
+    uint64_t updates = 0UL;
+    while (reader.IsOpen())
+    {
+      updates += reader.Poll(state) ? 1UL : 0UL;
+      std::this_thread::sleep_for(std::chrono::milliseconds(SELFTEST_POLL_PERIOD_MS));
+    }
+    return ((updates > 0UL) && (reader.GetNumberOfMismatches() == 0UL)) ? 0 : 1;
+  } catch (std::exception const & exception) {
+    std::cerr << exception.what() << "\n";
+    return 1;
+  }
+}
+#endif
+
+
+int RunSpectatorSelftest(Options const & options)
+{
+#ifdef _WIN32
+  (void)options;
+  std::cerr << "Spectator selftest needs fork(), it is not supported on this platform.\n";
+  return 1;
+#else
+  std::string const name = "/bens-snake-selftest-" + std::to_string(getpid());
+  size_t const numberOfPlayers = std::max(options.arenaPlayers, 1U);
+  Simulation simulation(options.boardSize);
+  RewindBuffer rewind(options.boardSize, SELFTEST_REWIND_TICKS);
+  std::unique_ptr<SpectatorFeed> pFeed(new SpectatorFeed(name, options.boardSize));
+  uint64_t seed = 1UL;
+  simulation.Restart(numberOfPlayers, seed);
+  rewind.Record(simulation.GetState());
+  pFeed->Publish(rewind, simulation.GetState().numberOfMoves);
+
+  TickTimes const baseline = RunTicks(simulation, rewind, *pFeed, numberOfPlayers, seed);
+
+  // Readers are forked copies, they attach to the feed by its name like separate tools would
+  std::cout << std::flush;
+  std::vector<pid_t> readers;
+  for (uint32_t reader = 0U; reader < options.spectatorSelftestReaders; ++reader)
+  {
+    pid_t const pid = fork();
+    if (pid < 0)
+    {
+      std::cerr << "Spectator selftest: fork failed.\n";
+      break;
+    }
+    if (pid == 0)
+    {
+      _exit(RunReader(name));
+    }
+    readers.push_back(pid);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(SELFTEST_ATTACH_TIME_MS));
+
+  TickTimes const watched = RunTicks(simulation, rewind, *pFeed, numberOfPlayers, seed);
+
+  // Closing the feed ends the readers
+  pFeed.reset();
+  uint32_t failedReaders = static_cast<uint32_t>(options.spectatorSelftestReaders - readers.size());
+  for (pid_t const pid : readers)
+  {
+    int status = 0;
+    (void)waitpid(pid, &status, 0);
+    failedReaders += (WIFEXITED(status) && (WEXITSTATUS(status) == 0)) ? 0U : 1U;
+  }
+
+  bool const passed = (failedReaders == 0U)
+                   && (static_cast<double>(watched.mean_ns) <= MAX_SLOWDOWN * static_cast<double>(baseline.mean_ns));
+  std::cout << SELFTEST_TICKS << " ticks, " << numberOfPlayers << " players, "
+            << options.boardSize.x << "x" << options.boardSize.y << " board\n"
+            << "without readers: tick avg " << baseline.mean_ns << " ns, p99 " << baseline.p99_ns << " ns\n"
+            << "with " << readers.size() << " readers: tick avg " << watched.mean_ns << " ns, p99 " << watched.p99_ns << " ns\n"
+            << failedReaders << " readers failed\n"
+            << "Spectator selftest " << (passed ? "passed" : "FAILED") << "\n";
+  return passed ? 0 : 1;
+#endif
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+struct Options;
+
+// Follows the feed of a running game and prints what happens once a second
+int RunSpectator(Options const & options);
+// Publishes bot games while forked readers follow them, fails if the readers slow the ticks down or see wrong states
+int RunSpectatorSelftest(Options const & options);
@@ -0,0 +1,313 @@
+#include "SpectatorFeed.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static uint32_t constexpr FEED_MAGIC = 0x4B4E5353U; // "SSNK"
+static uint32_t constexpr FEED_VERSION = 1U;
+// Records are a few hundred bytes, the rare larger snapshots of huge boards are skipped
+static size_t constexpr SLOT_BYTES = 65536UL - 64UL;
+// Readers may fall behind by this many ticks before they have to wait for a snapshot again
+static uint64_t constexpr NUMBER_OF_SLOTS = 256UL;
+// A reader only needs the chunk of the newest snapshot
+static size_t constexpr READER_TICKS = 128UL;
+
+static uint8_t constexpr RECORD_DELTA = 0U;
+static uint8_t constexpr RECORD_SNAPSHOT = 1U;
+// Stands in for a skipped record, readers wait for the next snapshot
+static uint8_t constexpr RECORD_GAP = 2U;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The feed needs lock free atomics to be shared between processes");
+
+// A seqlock per slot, the sequence is odd while the slot is written and 2 * (record + 1) once record is complete
+struct alignas(64) SpectatorSlot
+{
+  std::atomic<uint64_t> sequence;
+  uint64_t tick;
+  uint32_t size;
+  uint8_t type;
+  uint8_t bytes[SLOT_BYTES];
+};
+
+struct SpectatorShared
+{
+  uint32_t magic;
+  uint32_t version;
+  Position boardSize;
+  // Number of records written so far, record n lives in slot n % NUMBER_OF_SLOTS
+  alignas(64) std::atomic<uint64_t> published;
+  std::atomic<uint32_t> closed;
+  SpectatorSlot slots[NUMBER_OF_SLOTS];
+};
+
+
+static std::string GetSharedName(std::string const & name)
+{
+  // Shared memory objects are named like files in the root
+  return ((!name.empty()) && (name[0] == '/')) ? name : ("/" + name);
+}
+
+
+static SpectatorShared const * Attach(std::string const & name)
+{
+#ifdef _WIN32
+  (void)name;
+  throw std::runtime_error("SpectatorReader::SpectatorReader: Shared memory feeds are not supported on this platform.");
+#else
+  int const file = shm_open(GetSharedName(name).c_str(), O_RDONLY, 0);
+  if (file < 0)
+  {
+    throw std::runtime_error("SpectatorReader::SpectatorReader: There is no feed " + name + ".");
+  }
+  void* const pMemory = mmap(nullptr, sizeof(SpectatorShared), PROT_READ, MAP_SHARED, file, 0);
+  (void)close(file);
+  if (pMemory == MAP_FAILED)
+  {
+    throw std::runtime_error("SpectatorReader::SpectatorReader: Feed " + name + " could not be mapped.");
+  }
+
+  SpectatorShared const * const pShared = static_cast<SpectatorShared const *>(pMemory);
+  if ((pShared->magic != FEED_MAGIC) || (pShared->version != FEED_VERSION))
+  {
+    (void)munmap(pMemory, sizeof(SpectatorShared));
+    throw std::runtime_error("SpectatorReader::SpectatorReader: " + name + " is no feed of this version.");
+  }
+  return pShared;
+#endif
+}
+
+
+SpectatorFeed::SpectatorFeed(std::string const & feedName, Position const & boardSize)
+: name(GetSharedName(feedName))
+, pShared(nullptr)
+, published(0UL)
+, skipped(0UL)
+, maxPublishTime_ns(0UL)
+{
+#ifdef _WIN32
+  (void)boardSize;
+  throw std::runtime_error("SpectatorFeed::SpectatorFeed: Shared memory feeds are not supported on this platform.");
+#else
+  // A feed left over by a crashed game is replaced
+  (void)shm_unlink(name.c_str());
+  int const file = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (file < 0)
+  {
+    throw std::runtime_error("SpectatorFeed::SpectatorFeed: Feed " + name + " could not be created.");
+  }
+  if (ftruncate(file, static_cast<off_t>(sizeof(SpectatorShared))) != 0)
+  {
+    (void)close(file);
+    (void)shm_unlink(name.c_str());
+    throw std::runtime_error("SpectatorFeed::SpectatorFeed: Feed " + name + " could not be sized.");
+  }
+  void* const pMemory = mmap(nullptr, sizeof(SpectatorShared), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  (void)close(file);
+  if (pMemory == MAP_FAILED)
+  {
+    (void)shm_unlink(name.c_str());
+    throw std::runtime_error("SpectatorFeed::SpectatorFeed: Feed " + name + " could not be mapped.");
+  }
+
+  // The memory is zeroed, so all slots start out as never written
+  pShared = new (pMemory) SpectatorShared;
+  for (SpectatorSlot & slot : pShared->slots)
+  {
+    // Faults in the page most records fit into now instead of during the first ticks
+    slot.sequence.store(0UL, std::memory_order_relaxed);
+  }
+  pShared->version = FEED_VERSION;
+  pShared->boardSize = boardSize;
+  pShared->published.store(0UL, std::memory_order_relaxed);
+  pShared->closed.store(0U, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  pShared->magic = FEED_MAGIC;
+#endif
+}
+
+
+SpectatorFeed::~SpectatorFeed(void)
+{
+  std::cout << "feed " << name << ": " << published << " records, " << skipped << " skipped, max "
+            << maxPublishTime_ns << " ns to publish\n";
+
+#ifndef _WIN32
+  // Attached readers keep their mapping and see the feed closed
+  pShared->closed.store(1U, std::memory_order_release);
+  (void)munmap(pShared, sizeof(SpectatorShared));
+  (void)shm_unlink(name.c_str());
+#endif
+}
+
+
+void SpectatorFeed::Publish(RewindBuffer const & rewind, uint64_t const tick)
+{
+  std::chrono::steady_clock::time_point const begin = std::chrono::steady_clock::now();
+
+  uint8_t const * pBytes = nullptr;
+  size_t size = 0UL;
+  bool const snapshot = rewind.GetLastRecord(pBytes, size);
+  uint8_t type = snapshot ? RECORD_SNAPSHOT : RECORD_DELTA;
+  if ((pBytes == nullptr) || (size > SLOT_BYTES))
+  {
+    ++skipped;
+    type = RECORD_GAP;
+    size = 0UL;
+  }
+
+  // There is a single writer, so the record number needs no read-modify-write
+  uint64_t const record = pShared->published.load(std::memory_order_relaxed);
+  SpectatorSlot & slot = pShared->slots[record % NUMBER_OF_SLOTS];
+  slot.sequence.store(2UL * record + 1UL, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.tick = tick;
+  slot.size = static_cast<uint32_t>(size);
+  slot.type = type;
+  if (size > 0UL)
+  {
+    std::memcpy(slot.bytes, pBytes, size);
+  }
+  slot.sequence.store(2UL * record + 2UL, std::memory_order_release);
+  pShared->published.store(record + 1UL, std::memory_order_release);
+
+  ++published;
+  maxPublishTime_ns = std::max(maxPublishTime_ns, static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
+}
+
+
+SpectatorReader::SpectatorReader(std::string const & name)
+: pShared(Attach(name))
+, mirror(pShared->boardSize, READER_TICKS)
+, record(SLOT_BYTES)
+, cursor(0UL)
+, synced(false)
+, records(0UL)
+, resyncs(0UL)
+, mismatches(0UL)
+{
+  // Attaching counts as no resync
+  Resync(pShared->published.load(std::memory_order_acquire));
+  resyncs = 0UL;
+}
+
+
+SpectatorReader::~SpectatorReader(void)
+{
+#ifndef _WIN32
+  (void)munmap(const_cast<SpectatorShared*>(pShared), sizeof(SpectatorShared));
+#endif
+}
+
+
+Position SpectatorReader::GetBoardSize(void) const
+{
+  return pShared->boardSize;
+}
+
+
+bool SpectatorReader::IsOpen(void) const
+{
+  return (pShared->closed.load(std::memory_order_acquire) == 0U);
+}
+
+
+bool SpectatorReader::Poll(Simulation::State & state)
+{
+  uint64_t const published = pShared->published.load(std::memory_order_acquire);
+  if (published > cursor + NUMBER_OF_SLOTS)
+  {
+    Resync(published);
+  }
+
+  bool updated = false;
+  uint64_t tick = 0UL;
+  while (cursor < published)
+  {
+    SpectatorSlot const & slot = pShared->slots[cursor % NUMBER_OF_SLOTS];
+    uint64_t const sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != 2UL * cursor + 2UL)
+    {
+      // Already overwritten by a newer record
+      Resync(pShared->published.load(std::memory_order_acquire));
+      updated = false;
+      continue;
+    }
+
+    uint64_t const recordTick = slot.tick;
+    size_t const size = std::min(static_cast<size_t>(slot.size), SLOT_BYTES);
+    uint8_t const type = slot.type;
+    std::memcpy(record.data(), slot.bytes, size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+    {
+      // Torn by the writer while copying
+      Resync(pShared->published.load(std::memory_order_acquire));
+      updated = false;
+      continue;
+    }
+    ++cursor;
+    ++records;
+
+    if (type == RECORD_SNAPSHOT)
+    {
+      mirror.Clear();
+      synced = mirror.Append(record.data(), size, true);
+    }
+    else if (synced)
+    {
+      synced = (type == RECORD_DELTA) && mirror.Append(record.data(), size, false);
+    }
+    updated = synced;
+    tick = recordTick;
+  }
+
+  if (!updated)
+  {
+    return false;
+  }
+  mirror.Rebuild(mirror.GetNumberOfTicks() - 1UL, state);
+  if (state.numberOfMoves != tick)
+  {
+    ++mismatches;
+  }
+  return true;
+}
+
+
+uint64_t SpectatorReader::GetNumberOfRecords(void) const
+{
+  return records;
+}
+
+
+uint64_t SpectatorReader::GetNumberOfResyncs(void) const
+{
+  return resyncs;
+}
+
+
+uint64_t SpectatorReader::GetNumberOfMismatches(void) const
+{
+  return mismatches;
+}
+
+
+void SpectatorReader::Resync(uint64_t const published)
+{
+  // Start at the oldest record which can't be overwritten right away, a snapshot follows within a chunk
+  cursor = (published > NUMBER_OF_SLOTS / 2UL) ? (published - NUMBER_OF_SLOTS / 2UL) : 0UL;
+  synced = false;
+  mirror.Clear();
+  ++resyncs;
+}
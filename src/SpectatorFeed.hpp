@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Position.hpp"
+#include "RewindBuffer.hpp"
+#include "Simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SpectatorShared;
+
+// Publishes the rewind records of each tick into a shared memory ring, readers never slow the game down
+class SpectatorFeed
+{
+public:
+  SpectatorFeed(std::string const & feedName, Position const & boardSize);
+  ~SpectatorFeed(void);
+
+  // The newest record of the buffer, called after each record
+  void Publish(RewindBuffer const & rewind, uint64_t const tick);
+
+private:
+  std::string name;
+  SpectatorShared* pShared;
+
+  // Statistics
+  uint64_t published;
+  uint64_t skipped;
+  uint64_t maxPublishTime_ns;
+};
+
+// Follows a feed from another process and rebuilds the newest state out of its records
+class SpectatorReader
+{
+public:
+  explicit SpectatorReader(std::string const & name);
+  ~SpectatorReader(void);
+
+  Position GetBoardSize(void) const;
+  // False once the game closed its feed
+  bool IsOpen(void) const;
+  // True if the state was updated, a reader which fell behind waits for the next snapshot
+  bool Poll(Simulation::State & state);
+
+  uint64_t GetNumberOfRecords(void) const;
+  uint64_t GetNumberOfResyncs(void) const;
+  // States which didn't rebuild to the tick they were published for
+  uint64_t GetNumberOfMismatches(void) const;
+
+private:
+  SpectatorShared const * pShared;
+  RewindBuffer mirror;
+  std::vector<uint8_t> record;
+  uint64_t cursor;
+  bool synced;
+
+  // Statistics
+  uint64_t records;
+  uint64_t resyncs;
+  uint64_t mismatches;
+
+  void Resync(uint64_t const published);
+};
@@ -0,0 +1,252 @@
+#include "Trainer.hpp"
+#include "Metrics.hpp"
+#include "Options.hpp"
+#include "PolicyBatch.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Every genome plays the same games of a generation, so their fitness compares fairly
+static size_t constexpr EPISODES = 4UL;
+static size_t constexpr TOURNAMENT_SIZE = 4UL;
+static float constexpr MUTATION_SIGMA = 0.05F;
+static char constexpr CHECKPOINT_MAGIC[4] = { 'S', 'N', 'K', 'P' };
+static uint32_t constexpr CHECKPOINT_VERSION = 1U;
+
+// Checkpoint file: magic, version, genome size, population size, generation, the best genome, then the population
+struct Population
+{
+  uint64_t generation;
+  std::vector<float> best;
+  std::vector<float> genomes;
+};
+
+static bool LoadCheckpoint(std::string const & path, size_t const populationSize, Population & population)
+{
+  FILE* const pFile = fopen(path.c_str(), "rb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+
+  char magic[4];
+  uint32_t header[3];
+  uint64_t generation = 0UL;
+  bool valid =    (fread(magic, sizeof(magic), 1UL, pFile) == 1UL)
+               && (fread(header, sizeof(header), 1UL, pFile) == 1UL)
+               && (fread(&generation, sizeof(generation), 1UL, pFile) == 1UL)
+               && (std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0)
+               && (header[0] == CHECKPOINT_VERSION)
+               && (header[1] == PolicyBatch::GENOME_SIZE)
+               && (header[2] == populationSize);
+  if (valid)
+  {
+    population.generation = generation;
+    population.best.resize(PolicyBatch::GENOME_SIZE);
+    population.genomes.resize(populationSize * PolicyBatch::GENOME_SIZE);
+    valid =    (fread(population.best.data(), sizeof(float), population.best.size(), pFile) == population.best.size())
+            && (fread(population.genomes.data(), sizeof(float), population.genomes.size(), pFile) == population.genomes.size());
+  }
+  fclose(pFile);
+  return valid;
+}
+
+
+static void SaveCheckpoint(std::string const & path, Population const & population)
+{
+  // Written aside and renamed, a crash never leaves half a checkpoint
+  std::string const temporaryPath = path + ".tmp";
+  FILE* const pFile = fopen(temporaryPath.c_str(), "wb");
+  if (pFile == nullptr)
+  {
+    std::cerr << "Checkpoint " << temporaryPath << " could not be written\n";
+    return;
+  }
+
+  uint32_t const header[3] = { CHECKPOINT_VERSION, static_cast<uint32_t>(PolicyBatch::GENOME_SIZE),
+                               static_cast<uint32_t>(population.genomes.size() / PolicyBatch::GENOME_SIZE) };
+  fwrite(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), 1UL, pFile);
+  fwrite(header, sizeof(header), 1UL, pFile);
+  fwrite(&population.generation, sizeof(population.generation), 1UL, pFile);
+  fwrite(population.best.data(), sizeof(float), population.best.size(), pFile);
+  fwrite(population.genomes.data(), sizeof(float), population.genomes.size(), pFile);
+  fclose(pFile);
+
+#ifdef _WIN32
+  (void)std::remove(path.c_str());
+#endif
+  (void)std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+
+static void EvaluateLanes(std::vector<float> const & genomes, Position const & boardSize, uint64_t const generation,
+                          size_t const firstLane, size_t const numberOfLanes, std::vector<float> & laneFitness)
+{
+  // One lane per game, all games of the slice advance in lockstep and share one batched inference per tick
+  PolicyBatch batch(numberOfLanes);
+  std::vector<Simulation> games;
+  games.reserve(numberOfLanes);
+  std::vector<uint32_t> ticksSinceApple(numberOfLanes, 0U);
+  std::vector<uint8_t> done(numberOfLanes, 0U);
+  for (size_t lane = 0UL; lane < numberOfLanes; ++lane)
+  {
+    size_t const game = firstLane + lane;
+    batch.SetWeights(lane, genomes.data() + (game / EPISODES) * PolicyBatch::GENOME_SIZE);
+    games.emplace_back(boardSize);
+    games.back().Restart(1U, generation * EPISODES + (game % EPISODES) + 1UL);
+  }
+
+  // Snakes circling without eating are stopped after they could have visited every cell
+  uint32_t const maxTicksSinceApple = static_cast<uint32_t>(boardSize.x * boardSize.y);
+  uint64_t ticks = 0UL;
+  size_t active = numberOfLanes;
+  while (active > 0UL)
+  {
+    for (size_t lane = 0UL; lane < numberOfLanes; ++lane)
+    {
+      if (done[lane] == 0U)
+      {
+        batch.SetInputs(lane, games[lane]);
+      }
+    }
+    batch.Infer();
+
+    for (size_t lane = 0UL; lane < numberOfLanes; ++lane)
+    {
+      if (done[lane] != 0U)
+      {
+        continue;
+      }
+
+      Simulation & game = games[lane];
+      game.SetPressedDirection(0UL, batch.GetDirection(lane, game));
+      Simulation::Events const events = game.Step();
+      ++ticks;
+      ticksSinceApple[lane] = events.bite ? 0U : ticksSinceApple[lane] + 1U;
+      if (!game.GetState().running || (ticksSinceApple[lane] > maxTicksSinceApple))
+      {
+        // Apples count, surviving longer only breaks ties
+        Simulation::State const & state = game.GetState();
+        laneFitness[firstLane + lane] = static_cast<float>(state.scoreCount)
+                                      + static_cast<float>(state.numberOfMoves) * 0.0001F;
+        done[lane] = 1U;
+        --active;
+      }
+    }
+  }
+
+  Metrics::Add(Metrics::Counter::Ticks, ticks);
+  Metrics::Add(Metrics::Counter::Games, numberOfLanes);
+}
+
+
+static size_t SelectParent(std::vector<float> const & fitness, std::mt19937 & random)
+{
+  size_t best = random() % fitness.size();
+  for (size_t i = 1UL; i < TOURNAMENT_SIZE; ++i)
+  {
+    size_t const candidate = random() % fitness.size();
+    best = (fitness[candidate] > fitness[best]) ? candidate : best;
+  }
+  return best;
+}
+
+
+int RunTrainer(Options const & options)
+{
+  size_t const populationSize = std::max(options.trainPopulation, 2U);
+  size_t const genomeSize = PolicyBatch::GENOME_SIZE;
+  std::mt19937 random(1U);
+  std::normal_distribution<float> noise(0.0F, 1.0F);
+
+  Population population = { 0UL, std::vector<float>(genomeSize, 0.0F), std::vector<float>(populationSize * genomeSize) };
+  if (LoadCheckpoint(options.trainCheckpoint, populationSize, population))
+  {
+    std::cout << "Continuing from generation " << population.generation << " of " << options.trainCheckpoint << "\n";
+    random.seed(static_cast<uint32_t>(population.generation));
+  }
+  else
+  {
+    // Weights scaled by their fan in, so no layer starts saturated
+    for (size_t genome = 0UL; genome < populationSize; ++genome)
+    {
+      float* const pGenome = population.genomes.data() + genome * genomeSize;
+      for (size_t weight = 0UL; weight < genomeSize; ++weight)
+      {
+        size_t const fanIn = (weight < PolicyBatch::NUMBER_OF_HIDDEN * PolicyBatch::NUMBER_OF_INPUTS)
+                           ? PolicyBatch::NUMBER_OF_INPUTS : PolicyBatch::NUMBER_OF_HIDDEN;
+        pGenome[weight] = noise(random) / std::sqrt(static_cast<float>(fanIn));
+      }
+    }
+  }
+
+  // Slices of whole SIMD vectors, one per core
+  size_t const numberOfLanes = populationSize * EPISODES;
+  size_t const numberOfWorkers = std::max(std::thread::hardware_concurrency(), 1U);
+  size_t const slice = ((numberOfLanes + numberOfWorkers * 4UL - 1UL) / (numberOfWorkers * 4UL)) * 4UL;
+
+  std::vector<float> laneFitness(numberOfLanes, 0.0F);
+  std::vector<float> fitness(populationSize, 0.0F);
+  std::vector<size_t> ranking(populationSize);
+  std::vector<float> nextGenomes(population.genomes.size());
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+  for (uint32_t generation = 0U; generation < options.trainGenerations; ++generation)
+  {
+    std::vector<std::thread> workers;
+    for (size_t firstLane = 0UL; firstLane < numberOfLanes; firstLane += slice)
+    {
+      workers.emplace_back(EvaluateLanes, std::cref(population.genomes), options.boardSize, population.generation,
+                           firstLane, std::min(slice, numberOfLanes - firstLane), std::ref(laneFitness));
+    }
+    for (std::thread & worker : workers)
+    {
+      worker.join();
+    }
+
+    for (size_t genome = 0UL; genome < populationSize; ++genome)
+    {
+      fitness[genome] = std::accumulate(laneFitness.begin() + genome * EPISODES,
+                                        laneFitness.begin() + (genome + 1UL) * EPISODES, 0.0F) / EPISODES;
+    }
+    std::iota(ranking.begin(), ranking.end(), 0UL);
+    std::sort(ranking.begin(), ranking.end(), [&fitness](size_t const a, size_t const b){ return fitness[a] > fitness[b]; });
+    std::copy_n(population.genomes.begin() + ranking[0] * genomeSize, genomeSize, population.best.begin());
+
+    // The best tenth survives unchanged, the rest are mutated crossovers of tournament winners
+    size_t const elites = std::max(populationSize / 10UL, 1UL);
+    for (size_t child = 0UL; child < populationSize; ++child)
+    {
+      float* const pChild = nextGenomes.data() + child * genomeSize;
+      if (child < elites)
+      {
+        std::copy_n(population.genomes.begin() + ranking[child] * genomeSize, genomeSize, pChild);
+        continue;
+      }
+      float const * const pMother = population.genomes.data() + SelectParent(fitness, random) * genomeSize;
+      float const * const pFather = population.genomes.data() + SelectParent(fitness, random) * genomeSize;
+      for (size_t weight = 0UL; weight < genomeSize; ++weight)
+      {
+        pChild[weight] = (((random() & 1U) != 0U) ? pMother[weight] : pFather[weight]) + noise(random) * MUTATION_SIGMA;
+      }
+    }
+    population.genomes.swap(nextGenomes);
+    ++population.generation;
+    SaveCheckpoint(options.trainCheckpoint, population);
+
+    double const hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 3600.0;
+    std::cout << "generation " << population.generation << ": best " << fitness[ranking[0]]
+              << ", mean " << (std::accumulate(fitness.begin(), fitness.end(), 0.0F) / populationSize)
+              << " apples, " << static_cast<uint64_t>((generation + 1U) / hours) << " generations per hour\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+struct Options;
+
+// Evolves policies for PolicyBatch on headless games and keeps them in a checkpoint file
+int RunTrainer(Options const & options);
@@ -1,29 +1,106 @@
-
+#include "AllocationCounter.hpp"
+#include "Analytics.hpp"
+#include "AudioSelftest.hpp"
 #include "Game.hpp"
-#include "Position.hpp"
-#include <cstring>
+#include "Headless.hpp"
+#include "LockstepSelftest.hpp"
+#include "MetricsServer.hpp"
+#include "NetSelftest.hpp"
+#include "ObservationExport.hpp"
+#include "Options.hpp"
+#include "ParticleBenchmark.hpp"
+#include "RendererSelftest.hpp"
+#include "Soak.hpp"
+#include "Spectator.hpp"
+#include "Trainer.hpp"
+#include <iostream>
+#include <memory>
 
-static Position ParseResolution(char* pResString)
+int main(int argc, char* argv[])
 {
-  Position resolution;
-  char* pArgv = strtok(pResString, "xX");
-  try {
-    resolution.x = std::stoi(pArgv);
-    pArgv = strtok(nullptr, "xX");
-    resolution.y = std::stoi(pArgv);
-  } catch (...) {
-    resolution = { 0, 0 };
-  }
-  return resolution;
-}
+  // Before SDL allocates anything, so memory is freed by the allocator it came from
+  CountSdlAllocations();
 
+  Options const options = ParseOptions(argc, argv);
 
-int main(int argc, char* argv[])
-{
-  Position const resolution = (argc > 1) ? ParseResolution(argv[1]) : Position{ 0, 0 };
+  if (options.netSelftestMatches > 0U)
+  {
+    return RunNetSelftest(options.netPort, options.netSelftestMatches, options.netMinDelay_ms, options.netMaxDelay_ms);
+  }
+
+  // Scraped by a local Prometheus while the game or a headless run is going on
+  std::unique_ptr<MetricsServer> pMetricsServer;
+  if (options.metricsPort > 0U)
+  {
+    pMetricsServer.reset(new MetricsServer(options.metricsPort));
+  }
+
+  if (options.headlessTicks > 0UL)
+  {
+    // Exports count observations instead of ticks
+    return options.exportOutput.empty() ? RunHeadless(options) : RunObservationExport(options);
+  }
+
+  if (options.analyticsGames > 0UL)
+  {
+    return RunAnalytics(options);
+  }
+
+  if (options.trainGenerations > 0U)
+  {
+    return RunTrainer(options);
+  }
+
+  if (options.lockstepGames > 0U)
+  {
+    return RunLockstepSelftest(options);
+  }
 
-  Game game(resolution);
-  game.Run();
+  if (options.benchmarkParticles > 0U)
+  {
+    return RunParticleBenchmark(options);
+  }
+
+  if (options.audioSelftest)
+  {
+    return RunAudioSelftest(options);
+  }
+
+  if (options.rendererSelftest)
+  {
+    return RunRendererSelftest(options);
+  }
+
+  if (options.rendererBenchmarkFrames > 0U)
+  {
+    return RunRendererBenchmark(options);
+  }
+
+  if (options.spectatorSelftestReaders > 0U)
+  {
+    return RunSpectatorSelftest(options);
+  }
+
+  if (!options.spectatorWatch.empty())
+  {
+    return RunSpectator(options);
+  }
+
+  if (options.allocSelftestFrames > 0U)
+  {
+    if (!IsCountingAllocations())
+    {
+      std::cerr << "Allocation selftest: configure with -DCOUNT_ALLOCATIONS=ON, this build does not count allocations\n";
+      return 1;
+    }
+    Soak::UseDummyDrivers();
+  }
+
+  if (options.soakMinutes > 0U)
+  {
+    Soak::UseDummyDrivers();
+  }
 
-  return 0;
-}
\ No newline at end of file
+  Game game(options);
+  return game.Run();
+}